@@ -25,6 +25,7 @@ void CLIEngine::Initialise(ImageSourceEngine* imageSource,
   this->mainEngine = mainEngine;
 
   this->currentFrameNo = 0;
+  this->statisticsInterval = 0;
 
   bool allocateGPU = false;
   if (deviceType == ITMLibSettings::DEVICE_CUDA) {
@@ -87,9 +88,29 @@ bool CLIEngine::ProcessFrame() {
 
   currentFrameNo++;
 
+  if (statisticsInterval > 0 && currentFrameNo % statisticsInterval == 0) {
+    PrintHashStatistics();
+  }
+
   return true;
 }
 
+void CLIEngine::PrintHashStatistics() {
+  ITMHashStatistics stats;
+  if (!mainEngine->GetHashStatistics(&stats)) {
+    return;
+  }
+
+  printf(
+      "hash: buckets %i/%i, excess %i/%i, chain max %i avg %.2f, "
+      "blocks %i/%i, entries %i (%i swapped out), dropped %i (total %i)\n",
+      stats.noOccupiedBuckets, stats.noBuckets, stats.noUsedExcessEntries,
+      stats.noExcessEntries, stats.maxChainLength, stats.avgChainLength,
+      stats.noUsedLocalBlocks, stats.noLocalBlocks, stats.noAllocatedEntries,
+      stats.noSwappedOutEntries, stats.noDroppedBlocks,
+      stats.noDroppedBlocksTotal);
+}
+
 void CLIEngine::Run() {
   while (true) {
     if (!ProcessFrame()) {
@@ -99,6 +120,10 @@ void CLIEngine::Run() {
 }
 
 void CLIEngine::Shutdown() {
+  if (statisticsInterval > 0) {
+    PrintHashStatistics();
+  }
+
   sdkDeleteTimer(&timer_instant);
   sdkDeleteTimer(&timer_average);
 
@@ -31,6 +31,8 @@ namespace InfiniTAM
 			ITMIMUMeasurement *inputIMUMeasurement;
 
 			int currentFrameNo;
+
+			void PrintHashStatistics(void);
 		public:
 			static CLIEngine* Instance(void) {
 				if (instance == NULL) instance = new CLIEngine();
@@ -39,6 +41,11 @@ namespace InfiniTAM
 
 			float processedTime;
 
+			/** Print the load of the voxel block hash every that
+			many frames and on shutdown, 0 to never print it.
+			*/
+			int statisticsInterval;
+
 			void Initialise(ImageSourceEngine *imageSource, IMUSourceEngine *imuSource, ITMMainEngine *mainEngine,
 				ITMLibSettings::DeviceType deviceType);
 			void Shutdown();
@@ -110,9 +110,11 @@ void RosPoseSourceEngine::TFCallback(const tf::tfMessage& tf_msg) {
     }
 
     if (set_camera_pose_) {
-      // Assign the infinitam camera pose the same pose as TF.
+      // Assign the infinitam camera pose the same pose as TF, expressed
+      // relative to the (possibly re-centered) origin of the scene.
       main_engine_->GetTrackingState()->pose_d->SetT(
-          infinitam_translation_vector_);
+          infinitam_translation_vector_ +
+          infinitam_rotation_matrix_ * main_engine_->GetSceneOrigin());
       main_engine_->GetTrackingState()->pose_d->SetR(
           infinitam_rotation_matrix_);
     }
@@ -360,7 +360,7 @@ void UIEngine::Initialise(int& argc, char** argv,
   this->currentColourMode = 0;
   this->colourModes.push_back(UIColourMode(
       "shaded greyscale", ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_SHADED));
-  if (ITMVoxel::hasColorInformation) {
+  if (mainEngine->HasColorInformation()) {
     this->colourModes.push_back(UIColourMode(
         "integrated colours",
         ITMMainEngine::InfiniTAM_IMAGE_FREECAMERA_COLOUR_FROM_VOLUME));
@@ -150,42 +150,42 @@ static const _CPU_AND_GPU_CONSTANT_ int triangleTable[256][16] = { { -1, -1, -1,
 { 0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }, { 0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
 { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 } };
 
-template<class TVoxel>
+template<class TVoxel, class TIndexData, class TCache>
 _CPU_AND_GPU_CODE_ inline bool findPointNeighbors(THREADPTR(Vector3f) *p, THREADPTR(float) *sdf, Vector3i blockLocation, const CONSTPTR(TVoxel) *localVBA, 
-	const CONSTPTR(ITMHashEntry) *hashTable)
+	const CONSTPTR(TIndexData) *hashTable, THREADPTR(TCache) & cache)
 {
 	bool isFound; Vector3i localBlockLocation;
 
 	localBlockLocation = blockLocation + Vector3i(0, 0, 0); p[0] = localBlockLocation.toFloat();
-	sdf[0] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[0] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[0] == 1.0f) return false;
 
 	localBlockLocation = blockLocation + Vector3i(1, 0, 0); p[1] = localBlockLocation.toFloat();
-	sdf[1] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[1] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[1] == 1.0f) return false;
 
 	localBlockLocation = blockLocation + Vector3i(1, 1, 0); p[2] = localBlockLocation.toFloat();
-	sdf[2] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[2] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[2] == 1.0f) return false;
 
 	localBlockLocation = blockLocation + Vector3i(0, 1, 0); p[3] = localBlockLocation.toFloat();
-	sdf[3] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[3] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[3] == 1.0f) return false;
 
 	localBlockLocation = blockLocation + Vector3i(0, 0, 1); p[4] = localBlockLocation.toFloat();
-	sdf[4] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[4] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[4] == 1.0f) return false;
 
 	localBlockLocation = blockLocation + Vector3i(1, 0, 1); p[5] = localBlockLocation.toFloat();
-	sdf[5] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[5] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[5] == 1.0f) return false;
 
 	localBlockLocation = blockLocation + Vector3i(1, 1, 1); p[6] = localBlockLocation.toFloat();
-	sdf[6] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[6] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[6] == 1.0f) return false;
 
 	localBlockLocation = blockLocation + Vector3i(0, 1, 1); p[7] = localBlockLocation.toFloat();
-	sdf[7] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound).sdf);
+	sdf[7] = TVoxel::SDF_valueToFloat(readVoxel(localVBA, hashTable, localBlockLocation, isFound, cache).sdf);
 	if (!isFound || sdf[7] == 1.0f) return false;
 
 	return true;
@@ -200,12 +200,13 @@ _CPU_AND_GPU_CODE_ inline Vector3f sdfInterp(const THREADPTR(Vector3f) &p1, cons
 	return p1 + ((0.0f - valp1) / (valp2 - valp1)) * (p2 - p1);
 }
 
-template<class TVoxel>
-_CPU_AND_GPU_CODE_ inline int buildVertList(THREADPTR(Vector3f) *vertList, Vector3i globalPos, Vector3i localPos, const CONSTPTR(TVoxel) *localVBA, const CONSTPTR(ITMHashEntry) *hashTable)
+template<class TVoxel, class TIndexData, class TCache>
+_CPU_AND_GPU_CODE_ inline int buildVertList(THREADPTR(Vector3f) *vertList, Vector3i globalPos, Vector3i localPos, const CONSTPTR(TVoxel) *localVBA, const CONSTPTR(TIndexData) *hashTable,
+	THREADPTR(TCache) & cache)
 {
 	Vector3f points[8]; float sdfVals[8];
 
-	if (!findPointNeighbors(points, sdfVals, globalPos + localPos, localVBA, hashTable)) return -1;
+	if (!findPointNeighbors(points, sdfVals, globalPos + localPos, localVBA, hashTable, cache)) return -1;
 
 	int cubeIndex = 0;
 	if (sdfVals[0] < 0) cubeIndex |= 1; if (sdfVals[1] < 0) cubeIndex |= 2;
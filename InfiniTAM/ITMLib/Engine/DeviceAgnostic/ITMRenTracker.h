@@ -17,15 +17,15 @@ _CPU_AND_GPU_CODE_ inline void unprojectPtWithIntrinsic(const THREADPTR(Vector4f
 	outpt.w = 1.0f;
 }
 
-template<class TVoxel, class TIndex>
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline float computePerPixelEnergy(const THREADPTR(Vector4f) &inpt, const CONSTPTR(TVoxel) *voxelBlocks,
-	const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM)
+	const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM, THREADPTR(TCache) & cache)
 {
 	Vector3f pt; bool dtIsFound;
 	pt = TO_VECTOR3(invM * inpt) * oneOverVoxelSize;
 
 	// faster but theoretically worse
-	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, dtIsFound);
+	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, dtIsFound, cache);
 
 	//typename TIndex::IndexCache cache;
 	//float dt = readFromSDF_float_interpolated(voxelBlocks, index, pt, dtIsFound, cache);
@@ -36,9 +36,9 @@ _CPU_AND_GPU_CODE_ inline float computePerPixelEnergy(const THREADPTR(Vector4f)
 	return 4.0f * expdt / ((expdt + 1.0f)*(expdt + 1.0f));
 }
 
-template<class TVoxel, class TIndex>
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline Vector3f computeDDT(const CONSTPTR(Vector3f) &pt_f, const THREADPTR(TVoxel) *voxelBlocks,
-	const THREADPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, DEVICEPTR(bool) &ddtFound)
+	const THREADPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, DEVICEPTR(bool) &ddtFound, THREADPTR(TCache) & cache)
 {
 	
 	Vector3f ddt;
@@ -47,30 +47,31 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeDDT(const CONSTPTR(Vector3f) &pt_f, co
 
 	bool isFound; float dt1, dt2;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(1, 0, 0), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(1, 0, 0), isFound, cache).sdf);
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(-1, 0, 0), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(-1, 0, 0), isFound, cache).sdf);
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.x = (dt1 - dt2) * 0.5f;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 1, 0), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 1, 0), isFound, cache).sdf);
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, -1, 0), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, -1, 0), isFound, cache).sdf);
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.y = (dt1 - dt2) * 0.5f;
 
-	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, 1), isFound).sdf);
+	dt1 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, 1), isFound, cache).sdf);
 	if (!isFound || dt1 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
-	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, -1), isFound).sdf);
+	dt2 = TVoxel::SDF_valueToFloat(readVoxel(voxelBlocks, index, pt + Vector3i(0, 0, -1), isFound, cache).sdf);
 	if (!isFound || dt2 == 1.0f) { ddtFound = false; return Vector3f(0.0f); }
 	ddt.z = (dt1 - dt2) * 0.5f;
 
 	ddtFound = true; return ddt;
 }
 
-template<class TVoxel, class TIndex>
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline bool computePerPixelJacobian(THREADPTR(float) *jacobian, const THREADPTR(Vector4f) &inpt, 
-	const CONSTPTR(TVoxel) *voxelBlocks, const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM)
+	const CONSTPTR(TVoxel) *voxelBlocks, const CONSTPTR(typename TIndex::IndexData) *index, float oneOverVoxelSize, Matrix4f invM,
+	THREADPTR(TCache) & cache)
 {
 
 	bool isFound;
@@ -84,12 +85,12 @@ _CPU_AND_GPU_CODE_ inline bool computePerPixelJacobian(THREADPTR(float) *jacobia
 	//typename TIndex::IndexCache cache;
 	//float dt = readFromSDF_float_interpolated(voxelBlocks, index, pt, isFound, cache);
 
-	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, isFound);
+	float dt = readFromSDF_float_uninterpolated(voxelBlocks, index, pt, isFound, cache);
 
 	if (dt == 1.0f || !isFound) return false;
 
 
-	dDt = computeDDT<TVoxel, TIndex>(pt, voxelBlocks, index, oneOverVoxelSize, isFound);
+	dDt = computeDDT<TVoxel, TIndex>(pt, voxelBlocks, index, oneOverVoxelSize, isFound, cache);
 	if (!isFound) return false;
 
 	float expdt = exp(-dt * DTUNE);
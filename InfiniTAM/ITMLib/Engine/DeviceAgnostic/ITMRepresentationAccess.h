@@ -5,9 +5,132 @@
 #include "../../Utils/ITMLibDefines.h"
 #include "ITMPixelUtils.h"
 
+#if !defined(__CUDACC__) && !defined(__METALC__) && (defined(__AVX2__) || defined(__SSE4_1__))
+#include <immintrin.h>
+#endif
+
+/** XOR of the coordinates multiplied by large primes, as proposed by
+    Teschner et al. for spatial hashing.
+*/
+struct ITMTeschnerHash
+{
+	_CPU_AND_GPU_CODE_ static inline uint hash(int x, int y, int z) {
+		return ((uint)x * 73856093u) ^ ((uint)y * 19349669u) ^ ((uint)z * 83492791u);
+	}
+};
+
+/** Interleaves the lowest 10 bits of the coordinates along a Z-order
+    curve, so that blocks of the same 32^3 cell fall into nearby buckets.
+    The cells themselves, and the higher bits, are scattered by a
+    multiplicative hash of them.
+*/
+struct ITMMortonHash
+{
+	_CPU_AND_GPU_CODE_ static inline uint spreadBits(uint v) {
+		v &= 0x3ffu;
+		v = (v | (v << 16)) & 0x030000ffu;
+		v = (v | (v << 8)) & 0x0300f00fu;
+		v = (v | (v << 4)) & 0x030c30c3u;
+		v = (v | (v << 2)) & 0x09249249u;
+		return v;
+	}
+
+	_CPU_AND_GPU_CODE_ static inline uint hash(int x, int y, int z) {
+		uint code = spreadBits((uint)x) | (spreadBits((uint)y) << 1) | (spreadBits((uint)z) << 2);
+		uint high = ((uint)x >> 10) * 73856093u ^ ((uint)y >> 10) * 19349669u ^ ((uint)z >> 10) * 83492791u;
+		return code ^ (((code >> 15) ^ high) * 0x9e3779b1u);
+	}
+};
+
+#ifndef __METALC__
+/** Multiplies the 48 bit packed position by an odd 64 bit constant and
+    keeps the upper half of the product.
+*/
+struct ITMMultiplyShiftHash
+{
+	_CPU_AND_GPU_CODE_ static inline uint hash(int x, int y, int z) {
+		unsigned long long key = (unsigned long long)(unsigned short)x | ((unsigned long long)(unsigned short)y << 16) |
+			((unsigned long long)(unsigned short)z << 32);
+		return (uint)((key * 0x9e3779b97f4a7c15ull) >> 32);
+	}
+};
+#endif
+
+/** Mixes in the coordinates one at a time as in MurmurHash3 and applies
+    its finaliser, so that every input bit affects every output bit.
+*/
+struct ITMMurmurHash
+{
+	_CPU_AND_GPU_CODE_ static inline uint rotl(uint v, int r) { return (v << r) | (v >> (32 - r)); }
+
+	_CPU_AND_GPU_CODE_ static inline uint mix(uint h, uint k) {
+		k *= 0xcc9e2d51u; k = rotl(k, 15); k *= 0x1b873593u;
+		h ^= k; h = rotl(h, 13);
+		return h * 5u + 0xe6546b64u;
+	}
+
+	_CPU_AND_GPU_CODE_ static inline uint hash(int x, int y, int z) {
+		uint h = mix(mix(mix(0u, (uint)x), (uint)y), (uint)z) ^ 12u;
+		h ^= h >> 16; h *= 0x85ebca6bu;
+		h ^= h >> 13; h *= 0xc2b2ae35u;
+		h ^= h >> 16;
+		return h;
+	}
+};
+
+/** This chooses the hash function of the voxel block hash and the open
+    addressing hash. A hash function is a policy class whose static hash()
+    maps a block position to 32 bits, of which hashIndex() keeps the
+    lowest. At the moment, valid options are ITMTeschnerHash,
+    ITMMortonHash, ITMMultiplyShiftHash and ITMMurmurHash, see
+    InfiniTAM_hashbench for comparing them on recorded scenes. The Metal
+    kernels do not support ITMMultiplyShiftHash.
+*/
+typedef ITMTeschnerHash ITMHashFunction;
+
+template<class THashFunction, typename T> _CPU_AND_GPU_CODE_ inline int hashIndex(const THREADPTR(T) & blockPos) {
+	return THashFunction::hash(blockPos.x, blockPos.y, blockPos.z) & (uint)SDF_HASH_MASK;
+}
+
 template<typename T> _CPU_AND_GPU_CODE_ inline int hashIndex(const THREADPTR(T) & blockPos) {
-	return (((uint)blockPos.x * 73856093u) ^ ((uint)blockPos.y * 19349669u) ^ ((uint)blockPos.z * 83492791u)) & (uint)SDF_HASH_MASK;
+	return hashIndex<ITMHashFunction>(blockPos);
+}
+
+/** Bucket of @p blockPos in a voxel block hash with @p hashMask + 1
+    buckets, see ITMLib::Objects::ITMVoxelBlockHash::GetHashMask().
+*/
+template<typename T> _CPU_AND_GPU_CODE_ inline int hashIndex(const THREADPTR(T) & blockPos, int hashMask) {
+	return ITMHashFunction::hash(blockPos.x, blockPos.y, blockPos.z) & (uint)hashMask;
+}
+
+/** Lookups convert the position of the block they search for into a key
+    once, and then compare it against the position of every entry on the
+    chain with isBlockKey(). For packed block positions this is a single
+    64 bit comparison instead of extracting three bit fields.
+*/
+#ifdef SDF_PACKED_BLOCK_KEYS
+typedef unsigned long long ITMBlockKey;
+
+_CPU_AND_GPU_CODE_ inline ITMBlockKey blockKey(const THREADPTR(Vector3i) & blockPos) {
+	const uint fieldMask = (1u << SDF_BLOCK_POS_BITS) - 1;
+	const uint posOffset = 1u << (SDF_BLOCK_POS_BITS - 1);
+	// positions out of range must not match the block they wrap around to
+	if (((uint)blockPos.x + posOffset | (uint)blockPos.y + posOffset | (uint)blockPos.z + posOffset) > fieldMask) return ~0ull;
+	return ITMPackedBlockPos(blockPos.x, blockPos.y, blockPos.z).key;
+}
+
+_CPU_AND_GPU_CODE_ inline bool isBlockKey(const THREADPTR(ITMBlockPos) & pos, ITMBlockKey key) {
+	return pos.key == key;
+}
+#else
+typedef Vector3i ITMBlockKey;
+
+_CPU_AND_GPU_CODE_ inline ITMBlockKey blockKey(const THREADPTR(Vector3i) & blockPos) { return blockPos; }
+
+_CPU_AND_GPU_CODE_ inline bool isBlockKey(const THREADPTR(ITMBlockPos) & pos, const THREADPTR(ITMBlockKey) & key) {
+	return IS_EQUAL3(pos, key);
 }
+#endif
 
 _CPU_AND_GPU_CODE_ inline int pointToVoxelBlockPos(const THREADPTR(Vector3i) & point, THREADPTR(Vector3i) &blockPos) {
 	blockPos.x = ((point.x < 0) ? point.x - SDF_BLOCK_SIZE + 1 : point.x) / SDF_BLOCK_SIZE;
@@ -31,13 +154,14 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxel
 		return cache.blockPtr + linearIdx;
 	}
 
-	int hashIdx = hashIndex(blockPos);
+	int hashIdx = hashIndex(blockPos, cache.hashMask);
+	ITMBlockKey key = blockKey(blockPos);
 
 	while (true) 
 	{
 		ITMHashEntry hashEntry = voxelIndex[hashIdx];
 
-		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
+		if (isBlockKey(hashEntry.pos, key) && hashEntry.ptr >= 0)
 		{
 			isFound = true;
 			cache.blockPos = blockPos; cache.blockPtr = hashEntry.ptr * SDF_BLOCK_SIZE3;
@@ -45,7 +169,7 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxel
 		}
 
 		if (hashEntry.offset < 1) break;
-		hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+		hashIdx = cache.hashMask + hashEntry.offset;
 	}
 
 	isFound = false;
@@ -58,6 +182,248 @@ _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxel
 	return findVoxel(voxelIndex, point, isFound, cache);
 }
 
+/** Bucket of the open addressing hash at which the probe sequence of
+    @p blockPos starts.
+*/
+template<typename T> _CPU_AND_GPU_CODE_ inline int openHashIndex(const THREADPTR(T) & blockPos) {
+	return hashIndex(blockPos) & SDF_OPEN_HASH_MASK;
+}
+
+/** Compares @p blockPos with the keys of all slots of @p bucket. Bit i of
+    @p matchMask is set if slot i holds the block, bit i of @p freeMask if
+    slot i is free.
+*/
+template<typename T> _CPU_AND_GPU_CODE_ inline void matchOpenHashBucket(const CONSTPTR(ITMOpenHashBucket) & bucket,
+	const THREADPTR(T) & blockPos, THREADPTR(int) &matchMask, THREADPTR(int) &freeMask)
+{
+#if !defined(__CUDACC__) && !defined(__METALC__) && (defined(__AVX2__) || defined(__SSE4_1__))
+	long long key = (long long)((unsigned long long)(unsigned short)blockPos.x | ((unsigned long long)(unsigned short)blockPos.y << 16) |
+		((unsigned long long)(unsigned short)blockPos.z << 32) | (1ull << 48));
+	long long takenBit = (long long)(1ull << 48);
+#endif
+#if !defined(__CUDACC__) && !defined(__METALC__) && defined(__AVX2__)
+	__m256i keys = _mm256_loadu_si256((const __m256i*)bucket.pos);
+	matchMask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(keys, _mm256_set1_epi64x(key))));
+	freeMask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(keys, _mm256_set1_epi64x(takenBit)),
+		_mm256_setzero_si256())));
+#elif !defined(__CUDACC__) && !defined(__METALC__) && defined(__SSE4_1__)
+	__m128i keys0 = _mm_load_si128((const __m128i*)bucket.pos), keys1 = _mm_load_si128((const __m128i*)bucket.pos + 1);
+	__m128i keyVec = _mm_set1_epi64x(key), takenVec = _mm_set1_epi64x(takenBit);
+	matchMask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(keys0, keyVec))) |
+		(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(keys1, keyVec))) << 2);
+	freeMask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(_mm_and_si128(keys0, takenVec), _mm_setzero_si128()))) |
+		(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(_mm_and_si128(keys1, takenVec), _mm_setzero_si128()))) << 2);
+#else
+	matchMask = 0; freeMask = 0;
+	for (int slotIdx = 0; slotIdx < SDF_OPEN_HASH_SLOT_NUM; slotIdx++)
+	{
+		Vector4s slotPos = bucket.pos[slotIdx];
+		if (slotPos.w == 0) freeMask |= 1 << slotIdx;
+		else if (IS_EQUAL3(slotPos, blockPos)) matchMask |= 1 << slotIdx;
+	}
+#endif
+}
+
+_CPU_AND_GPU_CODE_ inline int lowestOpenHashSlot(int slotMask)
+{
+	for (int slotIdx = 0; slotIdx < SDF_OPEN_HASH_SLOT_NUM; slotIdx++) if (slotMask & (1 << slotIdx)) return slotIdx;
+	return -1;
+}
+
+/** Finds the entry of @p blockPos in the open addressing hash. If the block
+    is not in the table, -1 is returned and @p freeEntryId is set to the
+    first free slot on its probe sequence, where it would be inserted.
+*/
+template<typename T> _CPU_AND_GPU_CODE_ inline int findOpenHashEntry(const CONSTPTR(ITMOpenHashBucket) *buckets, const THREADPTR(T) & blockPos,
+	THREADPTR(int) &freeEntryId)
+{
+	int bucketIdx = openHashIndex(blockPos);
+	freeEntryId = -1;
+
+	for (int noProbes = 0; noProbes < SDF_OPEN_HASH_BUCKET_NUM; noProbes++)
+	{
+		int matchMask, freeMask;
+		matchOpenHashBucket(buckets[bucketIdx], blockPos, matchMask, freeMask);
+
+		if (matchMask != 0) return bucketIdx * SDF_OPEN_HASH_SLOT_NUM + lowestOpenHashSlot(matchMask);
+
+		// slots are never freed, so the block cannot be further down the sequence
+		if (freeMask != 0)
+		{
+			freeEntryId = bucketIdx * SDF_OPEN_HASH_SLOT_NUM + lowestOpenHashSlot(freeMask);
+			return -1;
+		}
+
+		bucketIdx = (bucketIdx + 1) & SDF_OPEN_HASH_MASK;
+	}
+
+	return -1;
+}
+
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex, const THREADPTR(Vector3i) & point,
+	THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache) & cache)
+{
+	Vector3i blockPos;
+	int linearIdx = pointToVoxelBlockPos(point, blockPos);
+
+	if IS_EQUAL3(blockPos, cache.blockPos)
+	{
+		isFound = true;
+		return cache.blockPtr + linearIdx;
+	}
+
+	int freeEntryId;
+	int entryId = findOpenHashEntry(voxelIndex, blockPos, freeEntryId);
+
+	if (entryId >= 0)
+	{
+		isFound = true;
+		cache.blockPos = blockPos;
+		cache.blockPtr = voxelIndex[entryId / SDF_OPEN_HASH_SLOT_NUM].ptr[entryId % SDF_OPEN_HASH_SLOT_NUM] * SDF_BLOCK_SIZE3;
+		return cache.blockPtr + linearIdx;
+	}
+
+	isFound = false;
+	return -1;
+}
+
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex, Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache cache;
+	return findVoxel(voxelIndex, point, isFound, cache);
+}
+
+/** Reads the position and voxel block pointer of the entry @p entryId, as
+    listed in the allocated and visible entry lists.
+*/
+_CPU_AND_GPU_CODE_ inline void readBlockEntry(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex, int entryId,
+	THREADPTR(ITMBlockPos) &blockPos, THREADPTR(int) &blockPtr)
+{
+	blockPos = voxelIndex[entryId].pos;
+	blockPtr = voxelIndex[entryId].ptr;
+}
+
+_CPU_AND_GPU_CODE_ inline void readBlockEntry(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex, int entryId,
+	THREADPTR(ITMBlockPos) &blockPos, THREADPTR(int) &blockPtr)
+{
+	const CONSTPTR(ITMOpenHashBucket) &bucket = voxelIndex[entryId / SDF_OPEN_HASH_SLOT_NUM];
+	Vector4s slotPos = bucket.pos[entryId % SDF_OPEN_HASH_SLOT_NUM];
+
+	blockPos = ITMBlockPos(slotPos.x, slotPos.y, slotPos.z);
+	blockPtr = slotPos.w != 0 ? bucket.ptr[entryId % SDF_OPEN_HASH_SLOT_NUM] : -2;
+}
+
+/** Octant of a node of level @p level of the voxel block octree that
+    holds the block at @p blockPos.
+*/
+_CPU_AND_GPU_CODE_ inline int octreeChildIdx(const THREADPTR(Vector3i) & blockPos, int level)
+{
+	int shift = SDF_OCTREE_DEPTH - 1 - level, rootOffset = 1 << (SDF_OCTREE_DEPTH - 1);
+
+	return (((blockPos.x + rootOffset) >> shift) & 1) | ((((blockPos.y + rootOffset) >> shift) & 1) << 1) |
+		((((blockPos.z + rootOffset) >> shift) & 1) << 2);
+}
+
+/** Whether the block at @p blockPos is inside the root of the voxel block octree. */
+_CPU_AND_GPU_CODE_ inline bool isInOctree(const THREADPTR(Vector3i) & blockPos)
+{
+	int rootOffset = 1 << (SDF_OCTREE_DEPTH - 1);
+
+	return (uint)(blockPos.x + rootOffset) < (uint)(2 * rootOffset) && (uint)(blockPos.y + rootOffset) < (uint)(2 * rootOffset) &&
+		(uint)(blockPos.z + rootOffset) < (uint)(2 * rootOffset);
+}
+
+/** Descends the voxel block octree from the node @p nodeIdx of level
+    @p level towards the block at @p blockPos, which has to be inside the
+    root. Stops at the node of level @p lastLevel, by default the last
+    level above the block, or at the first node on the way whose octant is
+    empty, and returns its child, i.e. -1 if the descent ended at an empty
+    octant.
+*/
+_CPU_AND_GPU_CODE_ inline int descendOctree(const CONSTPTR(ITMOctreeNode) *nodes, const THREADPTR(Vector3i) & blockPos,
+	THREADPTR(int) &nodeIdx, THREADPTR(int) &level, int lastLevel = SDF_OCTREE_DEPTH - 1)
+{
+	while (true)
+	{
+		int child = nodes[nodeIdx].child[octreeChildIdx(blockPos, level)];
+		if (child < 0 || level == lastLevel) return child;
+
+		nodeIdx = child; level++;
+	}
+}
+
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexData) *voxelIndex, const THREADPTR(Vector3i) & point,
+	THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexCache) & cache)
+{
+	Vector3i blockPos;
+	int linearIdx = pointToVoxelBlockPos(point, blockPos);
+
+	if IS_EQUAL3(blockPos, cache.blockPos)
+	{
+		isFound = true;
+		return cache.blockPtr + linearIdx;
+	}
+
+	isFound = false;
+	if (!isInOctree(blockPos))
+	{
+		cache.emptySize = 0;
+		return -1;
+	}
+
+	// siblings of the cached block are children of the same node, blocks nearby share the cached subtree
+	const int subtreeMask = ~((1 << (SDF_OCTREE_DEPTH - SDF_OCTREE_CACHED_LEVEL)) - 1);
+	Vector3i nodePos(blockPos.x & ~1, blockPos.y & ~1, blockPos.z & ~1);
+	Vector3i subtreePos(blockPos.x & subtreeMask, blockPos.y & subtreeMask, blockPos.z & subtreeMask);
+	int nodeIdx = 0, level = 0;
+	if IS_EQUAL3(nodePos, cache.nodePos) { nodeIdx = cache.nodeIdx; level = SDF_OCTREE_DEPTH - 1; }
+	else if IS_EQUAL3(subtreePos, cache.subtreePos) { nodeIdx = cache.subtreeIdx; level = SDF_OCTREE_CACHED_LEVEL; }
+	else
+	{
+		int subtreeIdx = descendOctree(voxelIndex, blockPos, nodeIdx, level, SDF_OCTREE_CACHED_LEVEL - 1);
+		if (subtreeIdx >= 0)
+		{
+			nodeIdx = subtreeIdx; level = SDF_OCTREE_CACHED_LEVEL;
+			cache.subtreePos = subtreePos; cache.subtreeIdx = subtreeIdx;
+		}
+	}
+
+	// continues from the empty octant as well, which then fails at once
+	int blockPtr = descendOctree(voxelIndex, blockPos, nodeIdx, level);
+
+	if (blockPtr < 0)
+	{
+		// the empty octant is a node of the next level
+		int rootOffset = 1 << (SDF_OCTREE_DEPTH - 1), emptySize = 1 << (SDF_OCTREE_DEPTH - 1 - level);
+		cache.emptyPos.x = ((blockPos.x + rootOffset) & ~(emptySize - 1)) - rootOffset;
+		cache.emptyPos.y = ((blockPos.y + rootOffset) & ~(emptySize - 1)) - rootOffset;
+		cache.emptyPos.z = ((blockPos.z + rootOffset) & ~(emptySize - 1)) - rootOffset;
+		cache.emptySize = emptySize;
+		return -1;
+	}
+
+	isFound = true;
+	cache.blockPos = blockPos; cache.blockPtr = blockPtr * SDF_BLOCK_SIZE3;
+	cache.nodePos = nodePos; cache.nodeIdx = nodeIdx;
+	return cache.blockPtr + linearIdx;
+}
+
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexData) *voxelIndex, Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOctree::IndexCache cache;
+	return findVoxel(voxelIndex, point, isFound, cache);
+}
+
+_CPU_AND_GPU_CODE_ inline void readBlockEntry(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexData) *voxelIndex, int entryId,
+	THREADPTR(ITMBlockPos) &blockPos, THREADPTR(int) &blockPtr)
+{
+	const CONSTPTR(ITMOctreeNode) &node = voxelIndex[entryId / 8];
+	int childIdx = entryId % 8;
+
+	blockPos = ITMBlockPos(node.pos.x + (childIdx & 1), node.pos.y + ((childIdx >> 1) & 1), node.pos.z + (childIdx >> 2));
+	blockPtr = node.child[childIdx];
+}
+
 _CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex, const THREADPTR(Vector3i) & point_orig,
 	THREADPTR(bool) &isFound)
 {
@@ -97,13 +463,14 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 		return voxelData[cache.blockPtr + linearIdx];
 	}
 
-	int hashIdx = hashIndex(blockPos);
+	int hashIdx = hashIndex(blockPos, cache.hashMask);
+	ITMBlockKey key = blockKey(blockPos);
 
 	while (true) 
 	{
 		ITMHashEntry hashEntry = voxelIndex[hashIdx];
 
-		if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= 0)
+		if (isBlockKey(hashEntry.pos, key) && hashEntry.ptr >= 0)
 		{
 			isFound = true;
 			cache.blockPos = blockPos; cache.blockPtr = hashEntry.ptr * SDF_BLOCK_SIZE3;
@@ -111,7 +478,7 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 		}
 
 		if (hashEntry.offset < 1) break;
-		hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+		hashIdx = cache.hashMask + hashEntry.offset;
 	}
 
 	isFound = false;
@@ -126,6 +493,38 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	return readVoxel(voxelData, voxelIndex, point, isFound, cache);
 }
 
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? voxelData[voxelAddress] : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+	Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache cache;
+	return readVoxel(voxelData, voxelIndex, point, isFound, cache);
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? voxelData[voxelAddress] : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexData) *voxelIndex,
+	Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOctree::IndexCache cache;
+	return readVoxel(voxelData, voxelIndex, point, isFound, cache);
+}
+
 template<class TVoxel>
 _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex,
 	const THREADPTR(Vector3i) & point_orig, THREADPTR(bool) &isFound)
@@ -141,20 +540,465 @@ _CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, co
 	return readVoxel(voxelData, voxelIndex, point_orig, isFound);
 }
 
+#ifndef __METALC__
+
+/** \brief
+    Takes the place of @p TVoxel in voxel arrays with the structure of
+    arrays layout. Every chunk of SDF_BLOCK_SIZE3 voxels, i.e. every
+    voxel block of a ITMLib::Objects::ITMVoxelBlockHash, occupies the
+    same memory as with @p TVoxel, but stores the SDF values, depth
+    weights, colours and colour weights of its voxels in consecutive
+    planes, see ITMVoxelBlockPlanes_SoA. Elements are only accessed
+    through readVoxel and writeVoxel, so the templates in this file and
+    the other device agnostic engine code can be instantiated with it in
+    place of the voxel type.
+*/
+template<class TVoxel>
+struct ITMVoxel_SoA
+{
+	typedef TVoxel VoxelType;
+	typedef decltype(TVoxel::sdf) SDFType;
+
+	static const CONSTPTR(bool) hasColorInformation = TVoxel::hasColorInformation;
+
+	/** Whether the fields are split into planes. Voxels whose fields
+	    share bytes, like the bit fields of ITMVoxel_b, take less memory
+	    than their planes would and are stored whole instead.
+	*/
+	static const CONSTPTR(bool) hasPlanes = sizeof(SDFType) + sizeof(uchar) +
+		(TVoxel::hasColorInformation ? sizeof(Vector3u) + sizeof(uchar) : 0) <= sizeof(TVoxel);
+
+	_CPU_AND_GPU_CODE_ static SDFType SDF_initialValue() { return TVoxel::SDF_initialValue(); }
+	_CPU_AND_GPU_CODE_ static float SDF_valueToFloat(float x) { return TVoxel::SDF_valueToFloat(x); }
+	_CPU_AND_GPU_CODE_ static SDFType SDF_floatToValue(float x) { return TVoxel::SDF_floatToValue(x); }
+
+private:
+	TVoxel storage;
+};
+
+/** \brief
+    Planes of the structure of arrays voxel block that starts at
+    @p blockAddress, a multiple of SDF_BLOCK_SIZE3. The colour planes
+    are NULL for voxel types without colour information.
+*/
+template<class TVoxel>
+struct ITMVoxelBlockPlanes_SoA
+{
+	typedef typename ITMVoxel_SoA<TVoxel>::SDFType SDFType;
+
+	SDFType *sdf;
+	uchar *w_depth;
+	Vector3u *clr;
+	uchar *w_color;
+
+	_CPU_AND_GPU_CODE_ ITMVoxelBlockPlanes_SoA(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, int blockAddress)
+	{
+		uchar *block = (uchar*)(voxelData + blockAddress);
+
+		sdf = (SDFType*)block;
+		w_depth = block + SDF_BLOCK_SIZE3 * sizeof(SDFType);
+		clr = TVoxel::hasColorInformation ? (Vector3u*)(w_depth + SDF_BLOCK_SIZE3) : NULL;
+		w_color = TVoxel::hasColorInformation ? (uchar*)(clr + SDF_BLOCK_SIZE3) : NULL;
+	}
+};
+
+template<bool hasColor, class TVoxel> struct VoxelColorPlanes_SoA;
+
+template<class TVoxel>
+struct VoxelColorPlanes_SoA<false, TVoxel> {
+	_CPU_AND_GPU_CODE_ static void read(THREADPTR(TVoxel) &voxel, const THREADPTR(ITMVoxelBlockPlanes_SoA<TVoxel>) &planes, int linearIdx) { }
+	_CPU_AND_GPU_CODE_ static void write(const THREADPTR(TVoxel) &voxel, const THREADPTR(ITMVoxelBlockPlanes_SoA<TVoxel>) &planes, int linearIdx) { }
+};
+
+template<class TVoxel>
+struct VoxelColorPlanes_SoA<true, TVoxel> {
+	_CPU_AND_GPU_CODE_ static void read(THREADPTR(TVoxel) &voxel, const THREADPTR(ITMVoxelBlockPlanes_SoA<TVoxel>) &planes, int linearIdx)
+	{
+		voxel.clr = planes.clr[linearIdx];
+		voxel.w_color = planes.w_color[linearIdx];
+	}
+
+	_CPU_AND_GPU_CODE_ static void write(const THREADPTR(TVoxel) &voxel, const THREADPTR(ITMVoxelBlockPlanes_SoA<TVoxel>) &planes, int linearIdx)
+	{
+		planes.clr[linearIdx] = voxel.clr;
+		planes.w_color[linearIdx] = voxel.w_color;
+	}
+};
+
+/** Reads the voxel at @p voxelAddress, as returned by findVoxel. */
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, int voxelAddress)
+{
+	return voxelData[voxelAddress];
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, int voxelAddress)
+{
+	if (!ITMVoxel_SoA<TVoxel>::hasPlanes) return ((const CONSTPTR(TVoxel)*)voxelData)[voxelAddress];
+
+	int linearIdx = (int)((uint)voxelAddress % SDF_BLOCK_SIZE3);
+	ITMVoxelBlockPlanes_SoA<TVoxel> planes(voxelData, voxelAddress - linearIdx);
+
+	TVoxel voxel;
+	voxel.sdf = planes.sdf[linearIdx];
+	voxel.w_depth = planes.w_depth[linearIdx];
+	VoxelColorPlanes_SoA<TVoxel::hasColorInformation, TVoxel>::read(voxel, planes, linearIdx);
+
+	return voxel;
+}
+
+/** Writes the voxel at @p voxelAddress, as returned by findVoxel. */
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void writeVoxel(DEVICEPTR(TVoxel) *voxelData, int voxelAddress, const THREADPTR(TVoxel) &voxel)
+{
+	voxelData[voxelAddress] = voxel;
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline void writeVoxel(DEVICEPTR(ITMVoxel_SoA<TVoxel>) *voxelData, int voxelAddress, const THREADPTR(TVoxel) &voxel)
+{
+	if (!ITMVoxel_SoA<TVoxel>::hasPlanes) { ((DEVICEPTR(TVoxel)*)voxelData)[voxelAddress] = voxel; return; }
+
+	int linearIdx = (int)((uint)voxelAddress % SDF_BLOCK_SIZE3);
+	ITMVoxelBlockPlanes_SoA<TVoxel> planes(voxelData, voxelAddress - linearIdx);
+
+	planes.sdf[linearIdx] = voxel.sdf;
+	planes.w_depth[linearIdx] = voxel.w_depth;
+	VoxelColorPlanes_SoA<TVoxel::hasColorInformation, TVoxel>::write(voxel, planes, linearIdx);
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? readVoxel(voxelData, voxelAddress) : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+	Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockHash::IndexCache cache;
+	return readVoxel(voxelData, voxelIndex, point, isFound, cache);
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? readVoxel(voxelData, voxelAddress) : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOpenHash::IndexData) *voxelIndex,
+	Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOpenHash::IndexCache cache;
+	return readVoxel(voxelData, voxelIndex, point, isFound, cache);
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? readVoxel(voxelData, voxelAddress) : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexData) *voxelIndex,
+	Vector3i point, THREADPTR(bool) &isFound)
+{
+	ITMLib::Objects::ITMVoxelBlockOctree::IndexCache cache;
+	return readVoxel(voxelData, voxelIndex, point, isFound, cache);
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point_orig, THREADPTR(bool) &isFound)
+{
+	int voxelAddress = findVoxel(voxelIndex, point_orig, isFound);
+	return isFound ? readVoxel(voxelData, voxelAddress) : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point_orig, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMPlainVoxelArray::IndexCache) & cache)
+{
+	return readVoxel(voxelData, voxelIndex, point_orig, isFound);
+}
+
+/** Position of the block at @p offset, with components in -1..1, in a
+    row of the block neighbour table of the voxel block hash, see
+    ITMLib::Objects::ITMVoxelBlockHash::GetBlockNeighbours(). The centre
+    of the row refers to the block itself.
+*/
+_CPU_AND_GPU_CODE_ inline int blockNeighbourIdx(const THREADPTR(Vector3i) & offset)
+{
+	return (offset.x + 1) + (offset.y + 1) * 3 + (offset.z + 1) * 9;
+}
+
+/** Looks up the blocks around the block at @p blockPos, which has just
+    been given the voxel block @p blockPtr, and links them with it in the
+    block neighbour table. @p hashMask is the bucket mask of @p hashTable.
+*/
+template<typename T> _CPU_AND_GPU_CODE_ inline void linkBlockNeighbours(DEVICEPTR(int) *blockNeighbours, const CONSTPTR(ITMHashEntry) *hashTable,
+	int hashMask, const THREADPTR(T) & blockPos, int blockPtr)
+{
+	DEVICEPTR(int) *row = blockNeighbours + blockPtr * SDF_BLOCK_NEIGHBOUR_NUM;
+
+	for (int neighbourIdx = 0; neighbourIdx < SDF_BLOCK_NEIGHBOUR_NUM; neighbourIdx++)
+	{
+		Vector3i neighbourPos((int)blockPos.x + neighbourIdx % 3 - 1, (int)blockPos.y + neighbourIdx / 3 % 3 - 1, (int)blockPos.z + neighbourIdx / 9 - 1);
+		int neighbourPtr = -1;
+
+		int hashIdx = hashIndex(neighbourPos, hashMask);
+		ITMBlockKey key = blockKey(neighbourPos);
+		while (true)
+		{
+			ITMHashEntry hashEntry = hashTable[hashIdx];
+
+			if (isBlockKey(hashEntry.pos, key) && hashEntry.ptr >= 0) { neighbourPtr = hashEntry.ptr; break; }
+
+			if (hashEntry.offset < 1) break;
+			hashIdx = hashMask + hashEntry.offset;
+		}
+
+		row[neighbourIdx] = neighbourPtr;
+		if (neighbourPtr >= 0) blockNeighbours[neighbourPtr * SDF_BLOCK_NEIGHBOUR_NUM + SDF_BLOCK_NEIGHBOUR_NUM - 1 - neighbourIdx] = blockPtr;
+	}
+}
+
+/** Removes the voxel block @p blockPtr, which is about to be freed, from
+    the block neighbour table.
+*/
+_CPU_AND_GPU_CODE_ inline void unlinkBlockNeighbours(DEVICEPTR(int) *blockNeighbours, int blockPtr)
+{
+	DEVICEPTR(int) *row = blockNeighbours + blockPtr * SDF_BLOCK_NEIGHBOUR_NUM;
+
+	for (int neighbourIdx = 0; neighbourIdx < SDF_BLOCK_NEIGHBOUR_NUM; neighbourIdx++)
+	{
+		int neighbourPtr = row[neighbourIdx];
+		if (neighbourPtr >= 0) blockNeighbours[neighbourPtr * SDF_BLOCK_NEIGHBOUR_NUM + SDF_BLOCK_NEIGHBOUR_NUM - 1 - neighbourIdx] = -1;
+		row[neighbourIdx] = -1;
+	}
+}
+
+/** Position of the cell of level @p level of the block occupancy grid
+    that holds the block at @p blockPos.
+*/
+_CPU_AND_GPU_CODE_ inline Vector3i blockOccupancyCellPos(const THREADPTR(Vector3i) & blockPos, int level)
+{
+	int cellSize = 1 << (SDF_OCCUPANCY_CELL_SHIFT * (level + 1));
+
+	return Vector3i(((blockPos.x < 0) ? blockPos.x - cellSize + 1 : blockPos.x) / cellSize,
+		((blockPos.y < 0) ? blockPos.y - cellSize + 1 : blockPos.y) / cellSize,
+		((blockPos.z < 0) ? blockPos.z - cellSize + 1 : blockPos.z) / cellSize);
+}
+
+/** Position of the counter of the occupancy cell at @p cellPos of level
+    @p level in the block occupancy grid of the voxel block hash, whose
+    levels have @p occupancyMask + 1 counters each, see
+    ITMLib::Objects::ITMVoxelBlockHash::GetBlockOccupancy().
+*/
+_CPU_AND_GPU_CODE_ inline int blockOccupancyIdx(const THREADPTR(Vector3i) & cellPos, int level, int occupancyMask)
+{
+	return level * (occupancyMask + 1) +
+		(int)((((uint)cellPos.x * 73856093u) ^ ((uint)cellPos.y * 19349669u) ^ ((uint)cellPos.z * 83492791u)) & (uint)occupancyMask);
+}
+
+/** Adds @p delta to the counts of all occupancy cells that hold the block
+    at @p blockPos, when a voxel block is given to it or taken from it.
+*/
+template<typename T> _CPU_AND_GPU_CODE_ inline void updateBlockOccupancy(DEVICEPTR(int) *blockOccupancy, int occupancyMask,
+	const THREADPTR(T) & blockPos, int delta)
+{
+	for (int level = 0; level < SDF_OCCUPANCY_LEVEL_NUM; level++)
+		blockOccupancy[blockOccupancyIdx(blockOccupancyCellPos(Vector3i((int)blockPos.x, (int)blockPos.y, (int)blockPos.z), level), level,
+			occupancyMask)] += delta;
+}
+
+/** Number of steps of SDF_BLOCK_SIZE voxels along @p rayDirection from
+    @p point, counting the one at @p point, that stay inside the cell of
+    width @p cellSize voxels whose points round to voxels from
+    @p cellMin on. At least 1.
+*/
+_CPU_AND_GPU_CODE_ inline int countBlockStepsInCell(const THREADPTR(Vector3f) & point, const THREADPTR(Vector3f) & rayDirection,
+	const THREADPTR(Vector3f) & cellMin, float cellSize)
+{
+	// the ray leaves the cell within the length of its diagonal
+	float exitLength = 2.0f * cellSize;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float axisLength;
+		if (rayDirection.v[axis] > 0.0f) axisLength = (cellMin.v[axis] + cellSize - point.v[axis]) / rayDirection.v[axis];
+		else if (rayDirection.v[axis] < 0.0f) axisLength = (cellMin.v[axis] - point.v[axis]) / rayDirection.v[axis];
+		else continue;
+		if (axisLength < exitLength) exitLength = axisLength;
+	}
+
+	// keep a voxel away from the border, the steps are summed up one by one
+	int noSteps = (int)ceil((exitLength - 1.0f) / SDF_BLOCK_SIZE);
+	return MAX(noSteps, 1);
+}
+
+/** Number of steps of SDF_BLOCK_SIZE voxels along @p rayDirection from
+    @p point, counting the one at @p point, that stay inside the widest
+    occupancy cell around @p point without voxel blocks in memory. None
+    of these positions can hit the surface. Returns 1 if the cell of the
+    first level around @p point holds blocks, and remembers that cell in
+    @p cache, as the following steps are likely to fall into it again.
+*/
+_CPU_AND_GPU_CODE_ inline int countEmptyBlockSteps(THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::NeighbourCache) & cache,
+	const THREADPTR(Vector3f) & point, const THREADPTR(Vector3f) & rayDirection)
+{
+	if (cache.blockOccupancy == NULL) return 1;
+
+	Vector3i blockPos;
+	pointToVoxelBlockPos(Vector3i((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z)), blockPos);
+
+	Vector3i cellPos = blockOccupancyCellPos(blockPos, 0);
+	if IS_EQUAL3(cellPos, cache.occupiedCellPos) return 1;
+	if (cache.blockOccupancy[blockOccupancyIdx(cellPos, 0, cache.blockOccupancyMask)] > 0)
+	{
+		cache.occupiedCellPos = cellPos;
+		return 1;
+	}
+
+	// cells of the coarser levels are only empty if those they hold are
+	int level = 0;
+	while (level + 1 < SDF_OCCUPANCY_LEVEL_NUM)
+	{
+		Vector3i coarseCellPos = blockOccupancyCellPos(blockPos, level + 1);
+		if (cache.blockOccupancy[blockOccupancyIdx(coarseCellPos, level + 1, cache.blockOccupancyMask)] > 0) break;
+		cellPos = coarseCellPos; level++;
+	}
+
+	// points in [cellMin, cellMin + cellSize) round to voxels of the cell
+	float cellSize = (float)(SDF_BLOCK_SIZE << (SDF_OCCUPANCY_CELL_SHIFT * (level + 1)));
+	Vector3f cellMin = cellPos.toFloat() * cellSize - 0.5f;
+
+	return countBlockStepsInCell(point, rayDirection, cellMin, cellSize);
+}
+
+/** Number of steps of SDF_BLOCK_SIZE voxels along @p rayDirection from
+    @p point, counting the one at @p point, that stay inside the empty
+    octant the last failed lookup with @p cache ended at. Returns 1 if
+    @p point is not inside of it.
+*/
+_CPU_AND_GPU_CODE_ inline int countEmptyBlockSteps(THREADPTR(ITMLib::Objects::ITMVoxelBlockOctree::IndexCache) & cache,
+	const THREADPTR(Vector3f) & point, const THREADPTR(Vector3f) & rayDirection)
+{
+	if (cache.emptySize == 0) return 1;
+
+	Vector3i blockPos;
+	pointToVoxelBlockPos(Vector3i((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z)), blockPos);
+
+	Vector3i offset = blockPos - cache.emptyPos;
+	if ((uint)offset.x >= (uint)cache.emptySize || (uint)offset.y >= (uint)cache.emptySize || (uint)offset.z >= (uint)cache.emptySize) return 1;
+
+	float cellSize = (float)(SDF_BLOCK_SIZE * cache.emptySize);
+	Vector3f cellMin = cache.emptyPos.toFloat() * (float)SDF_BLOCK_SIZE - 0.5f;
+
+	return countBlockStepsInCell(point, rayDirection, cellMin, cellSize);
+}
+
+/** Like the lookup with ITMLib::Objects::ITMVoxelBlockHash::IndexCache,
+    but blocks next to the cached one are found in its row of the block
+    neighbour table rather than in the hash table.
+*/
+_CPU_AND_GPU_CODE_ inline int findVoxel(const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex, const THREADPTR(Vector3i) & point,
+	THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::NeighbourCache) & cache)
+{
+	Vector3i blockPos;
+	int linearIdx = pointToVoxelBlockPos(point, blockPos);
+
+	if IS_EQUAL3(blockPos, cache.blockPos)
+	{
+		isFound = true;
+		return cache.blockPtr + linearIdx;
+	}
+
+	if (cache.blockNeighbours != NULL && cache.blockPtr >= 0)
+	{
+		Vector3i offset = blockPos - cache.blockPos;
+
+		if (offset.x >= -1 && offset.x <= 1 && offset.y >= -1 && offset.y <= 1 && offset.z >= -1 && offset.z <= 1)
+		{
+			int neighbourPtr = cache.blockNeighbours[cache.blockPtr / SDF_BLOCK_SIZE3 * SDF_BLOCK_NEIGHBOUR_NUM + blockNeighbourIdx(offset)];
+
+			if (neighbourPtr < 0)
+			{
+				isFound = false;
+				return -1;
+			}
+
+			isFound = true;
+			cache.blockPos = blockPos; cache.blockPtr = neighbourPtr * SDF_BLOCK_SIZE3;
+			return cache.blockPtr + linearIdx;
+		}
+	}
+
+	ITMLib::Objects::ITMVoxelBlockHash::IndexCache blockCache(cache.hashMask);
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, blockCache);
+	if (isFound) { cache.blockPos = blockCache.blockPos; cache.blockPtr = blockCache.blockPtr; }
+
+	return voxelAddress;
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::NeighbourCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? voxelData[voxelAddress] : TVoxel();
+}
+
+template<class TVoxel>
+_CPU_AND_GPU_CODE_ inline TVoxel readVoxel(const CONSTPTR(ITMVoxel_SoA<TVoxel>) *voxelData, const CONSTPTR(ITMLib::Objects::ITMVoxelBlockHash::IndexData) *voxelIndex,
+	const THREADPTR(Vector3i) & point, THREADPTR(bool) &isFound, THREADPTR(ITMLib::Objects::ITMVoxelBlockHash::NeighbourCache) & cache)
+{
+	int voxelAddress = findVoxel(voxelIndex, point, isFound, cache);
+	return isFound ? readVoxel(voxelData, voxelAddress) : TVoxel();
+}
+
+/** \brief
+    Voxel lookup cache the CPU engines use with @p TIndex. The voxel
+    block hash is read through its block neighbour table, all other
+    indices use their IndexCache.
+*/
+template<class TIndex>
+struct ITMIndexCache_CPU
+{
+	typedef typename TIndex::IndexCache Type;
+	static Type create(const TIndex *index) { return Type(); }
+};
+
+template<>
+struct ITMIndexCache_CPU<ITMLib::Objects::ITMVoxelBlockHash>
+{
+	typedef ITMLib::Objects::ITMVoxelBlockHash::NeighbourCache Type;
+	static Type create(const ITMLib::Objects::ITMVoxelBlockHash *index) { return Type(index->GetBlockNeighbours(), index->GetBlockOccupancy(),
+		index->GetBlockOccupancyMask(), index->GetHashMask()); }
+};
+
+#endif
+
 template<class TVoxel, class TIndex>
 _CPU_AND_GPU_CODE_ inline float readFromSDF_float_uninterpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(bool) &isFound)
 {
-	TVoxel res = readVoxel(voxelData, voxelIndex, Vector3i((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z)), isFound);
-	return TVoxel::SDF_valueToFloat(res.sdf);
+	return TVoxel::SDF_valueToFloat(readVoxel(voxelData, voxelIndex, Vector3i((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z)), isFound).sdf);
 }
 
 template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline float readFromSDF_float_uninterpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(TIndex) *voxelIndex, Vector3f point, THREADPTR(bool) &isFound, THREADPTR(TCache) & cache)
 {
-	TVoxel res = readVoxel(voxelData, voxelIndex, Vector3i((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z)), isFound, cache);
-	return TVoxel::SDF_valueToFloat(res.sdf);
+	return TVoxel::SDF_valueToFloat(readVoxel(voxelData, voxelIndex, Vector3i((int)ROUND(point.x), (int)ROUND(point.y), (int)ROUND(point.z)), isFound, cache).sdf);
 }
 
 template<class TVoxel, class TIndex, class TCache>
@@ -184,45 +1028,38 @@ _CPU_AND_GPU_CODE_ inline float readFromSDF_float_interpolated(const CONSTPTR(TV
 	return TVoxel::SDF_valueToFloat((1.0f - coeff.z) * res1 + coeff.z * res2);
 }
 
-template<class TVoxel, class TIndex>
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline Vector4f readFromSDF_color4u_interpolated(const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(typename TIndex::IndexData) *voxelIndex, const THREADPTR(Vector3f) & point, 
-	THREADPTR(typename TIndex::IndexCache) & cache)
+	THREADPTR(TCache) & cache)
 {
-	TVoxel resn; Vector3f ret = 0.0f; Vector4f ret4; bool isFound;
+	Vector3f ret = 0.0f; Vector4f ret4; bool isFound;
 	Vector3f coeff; Vector3i pos; TO_INT_FLOOR3(pos, coeff, point);
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), isFound, cache);
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), isFound, cache).clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), isFound, cache);
-	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
+	ret += (coeff.x) * (1.0f - coeff.y) * (1.0f - coeff.z) * readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), isFound, cache).clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), isFound, cache);
-	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * (1.0f - coeff.z) * readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), isFound, cache).clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), isFound, cache);
-	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * resn.clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * (1.0f - coeff.z) * readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), isFound, cache).clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), isFound, cache);
-	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();
+	ret += (1.0f - coeff.x) * (1.0f - coeff.y) * coeff.z * readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), isFound, cache).clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), isFound, cache);
-	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * resn.clr.toFloat();;
+	ret += (coeff.x) * (1.0f - coeff.y) * coeff.z * readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), isFound, cache).clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), isFound, cache);
-	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
+	ret += (1.0f - coeff.x) * (coeff.y) * coeff.z * readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), isFound, cache).clr.toFloat();
 
-	resn = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), isFound, cache);
-	ret += (coeff.x) * (coeff.y) * coeff.z * resn.clr.toFloat();
+	ret += (coeff.x) * (coeff.y) * coeff.z * readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), isFound, cache).clr.toFloat();
 
 	ret4.x = ret.x; ret4.y = ret.y; ret4.z = ret.z; ret4.w = 255.0f;
 
 	return ret4 / 255.0f;
 }
 
-template<class TVoxel, class TIndex>
-_CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(TIndex) *voxelIndex, const THREADPTR(Vector3f) &point)
+template<class TVoxel, class TIndex, class TCache>
+_CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(TIndex) *voxelIndex, const THREADPTR(Vector3f) &point,
+	THREADPTR(TCache) & cache)
 {
 	bool isFound;
 
@@ -232,14 +1069,14 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 
 	// all 8 values are going to be reused several times
 	Vector4f front, back;
-	front.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), isFound).sdf;
-	front.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), isFound).sdf;
-	front.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), isFound).sdf;
-	front.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), isFound).sdf;
-	back.x  = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), isFound).sdf;
-	back.y  = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), isFound).sdf;
-	back.z  = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), isFound).sdf;
-	back.w  = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), isFound).sdf;
+	front.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 0), isFound, cache).sdf;
+	front.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 0), isFound, cache).sdf;
+	front.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 0), isFound, cache).sdf;
+	front.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 0), isFound, cache).sdf;
+	back.x  = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 1), isFound, cache).sdf;
+	back.y  = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 1), isFound, cache).sdf;
+	back.z  = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 1), isFound, cache).sdf;
+	back.w  = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 1), isFound, cache).sdf;
 
 	Vector4f tmp;
 	float p1, p2, v1;
@@ -248,10 +1085,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.z *  coeff.y * ncoeff.z +
 	     back.x  * ncoeff.y *  coeff.z +
 	     back.z  *  coeff.y *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 1), isFound).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 0), isFound, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 0), isFound, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 0, 1), isFound, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(-1, 1, 1), isFound, cache).sdf;
 	p2 = tmp.x * ncoeff.y * ncoeff.z +
 	     tmp.y *  coeff.y * ncoeff.z +
 	     tmp.z * ncoeff.y *  coeff.z +
@@ -262,10 +1099,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.w *  coeff.y * ncoeff.z +
 	     back.y  * ncoeff.y *  coeff.z +
 	     back.w  *  coeff.y *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 1), isFound).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 0), isFound, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 0), isFound, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 0, 1), isFound, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(2, 1, 1), isFound, cache).sdf;
 	p2 = tmp.x * ncoeff.y * ncoeff.z +
 	     tmp.y *  coeff.y * ncoeff.z +
 	     tmp.z * ncoeff.y *  coeff.z +
@@ -278,10 +1115,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.y *  coeff.x * ncoeff.z +
 	     back.x  * ncoeff.x *  coeff.z +
 	     back.y  *  coeff.x *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 1), isFound).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 0), isFound, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 0), isFound, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, -1, 1), isFound, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, -1, 1), isFound, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.z +
 	     tmp.y *  coeff.x * ncoeff.z +
 	     tmp.z * ncoeff.x *  coeff.z +
@@ -292,10 +1129,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.w *  coeff.x * ncoeff.z +
 	     back.z  * ncoeff.x *  coeff.z +
 	     back.w  *  coeff.x *  coeff.z;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 0), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 0), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 1), isFound).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 0), isFound, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 0), isFound, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 2, 1), isFound, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 2, 1), isFound, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.z +
 	     tmp.y *  coeff.x * ncoeff.z +
 	     tmp.z * ncoeff.x *  coeff.z +
@@ -308,10 +1145,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     front.y *  coeff.x * ncoeff.y +
 	     front.z * ncoeff.x *  coeff.y +
 	     front.w *  coeff.x *  coeff.y;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, -1), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, -1), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, -1), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, -1), isFound).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, -1), isFound, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, -1), isFound, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, -1), isFound, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, -1), isFound, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.y +
 	     tmp.y *  coeff.x * ncoeff.y +
 	     tmp.z * ncoeff.x *  coeff.y +
@@ -322,10 +1159,10 @@ _CPU_AND_GPU_CODE_ inline Vector3f computeSingleNormalFromSDF(const CONSTPTR(TVo
 	     back.y *  coeff.x * ncoeff.y +
 	     back.z * ncoeff.x *  coeff.y +
 	     back.w *  coeff.x *  coeff.y;
-	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 2), isFound).sdf;
-	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 2), isFound).sdf;
-	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 2), isFound).sdf;
-	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 2), isFound).sdf;
+	tmp.x = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 0, 2), isFound, cache).sdf;
+	tmp.y = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 0, 2), isFound, cache).sdf;
+	tmp.z = readVoxel(voxelData, voxelIndex, pos + Vector3i(0, 1, 2), isFound, cache).sdf;
+	tmp.w = readVoxel(voxelData, voxelIndex, pos + Vector3i(1, 1, 2), isFound, cache).sdf;
 	p2 = tmp.x * ncoeff.x * ncoeff.y +
 	     tmp.y *  coeff.x * ncoeff.y +
 	     tmp.z * ncoeff.x *  coeff.y +
@@ -343,6 +1180,11 @@ struct VoxelColorReader<false,TVoxel,TIndex> {
 	_CPU_AND_GPU_CODE_ static Vector4f interpolate(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
 		const THREADPTR(Vector3f) & point)
 	{ return Vector4f(0.0f,0.0f,0.0f,0.0f); }
+
+	template<class TCache>
+	_CPU_AND_GPU_CODE_ static Vector4f interpolate(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
+		const THREADPTR(Vector3f) & point, THREADPTR(TCache) & cache)
+	{ return Vector4f(0.0f,0.0f,0.0f,0.0f); }
 };
 
 template<class TVoxel, class TIndex>
@@ -353,4 +1195,11 @@ struct VoxelColorReader<true,TVoxel,TIndex> {
 		typename TIndex::IndexCache cache;
 		return readFromSDF_color4u_interpolated<TVoxel,TIndex>(voxelData, voxelIndex, point, cache);
 	}
+
+	template<class TCache>
+	_CPU_AND_GPU_CODE_ static Vector4f interpolate(const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
+		const THREADPTR(Vector3f) & point, THREADPTR(TCache) & cache)
+	{
+		return readFromSDF_color4u_interpolated<TVoxel,TIndex>(voxelData, voxelIndex, point, cache);
+	}
 };
@@ -141,16 +141,16 @@ struct ComputeUpdatedVoxelInfo<true, TVoxel> {
 _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
     /* clang-format off */
     DEVICEPTR(uchar)* entriesAllocType, DEVICEPTR(uchar)* entriesVisibleType,
-    int x, int y, DEVICEPTR(Vector4s)* blockCoords,
+    int x, int y, DEVICEPTR(ITMBlockCoords)* blockCoords,
     const CONSTPTR(float)* depth, Matrix4f invM_d, Vector4f projParams_d,
     float mu, Vector2i imgSize, float oneOverVoxelSize,
-    const CONSTPTR(ITMHashEntry)* hashTable, float viewFrustum_min,
-    float viewFrustum_max /* clang-format on */) {
+    const CONSTPTR(ITMHashEntry)* hashTable, int hashMask,
+    float viewFrustum_min, float viewFrustum_max /* clang-format on */) {
   float depth_measure;
   unsigned int hashIdx;
   int noSteps;
   Vector3f pt_camera_f, point_e, point, direction;
-  Vector3s blockPos;
+  Vector3i blockPos;
 
   depth_measure = depth[x + y * imgSize.x];
   if (depth_measure <= 0 || (depth_measure - mu) < 0 ||
@@ -188,17 +188,18 @@ _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
 
   // add neighbouring blocks
   for (int i = 0; i < noSteps; i++) {
-    blockPos = TO_SHORT_FLOOR3(point);
+    blockPos = Vector3i((int)floor(point.x), (int)floor(point.y),
+                        (int)floor(point.z));
 
     // compute index in hash table
-    hashIdx = hashIndex(blockPos);
+    hashIdx = hashIndex(blockPos, hashMask);
 
     // check if hash table contains entry
     bool isFound = false;
 
     ITMHashEntry hashEntry = hashTable[hashIdx];
 
-    if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1) {
+    if (isBlockKey(hashEntry.pos, blockKey(blockPos)) && hashEntry.ptr >= -1) {
       // entry has been streamed out but is visible or in memory and visible
       entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
 
@@ -211,10 +212,10 @@ _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
           -1)  // seach excess list only if there is no room in ordered part
       {
         while (hashEntry.offset >= 1) {
-          hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+          hashIdx = hashMask + hashEntry.offset;
           hashEntry = hashTable[hashIdx];
 
-          if (IS_EQUAL3(hashEntry.pos, blockPos) && hashEntry.ptr >= -1) {
+          if (isBlockKey(hashEntry.pos, blockKey(blockPos)) && hashEntry.ptr >= -1) {
             // entry has been streamed out but is visible or in memory and
             // visible
             entriesVisibleType[hashIdx] = (hashEntry.ptr == -1) ? 2 : 1;
@@ -232,7 +233,8 @@ _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
         entriesAllocType[hashIdx] = isExcess ? 2 : 1;    // needs allocation
         if (!isExcess) entriesVisibleType[hashIdx] = 1;  // new entry is visible
 
-        blockCoords[hashIdx] = Vector4s(blockPos.x, blockPos.y, blockPos.z, 1);
+        blockCoords[hashIdx] =
+            ITMBlockCoords(blockPos.x, blockPos.y, blockPos.z, 1);
       }
     }
 
@@ -240,6 +242,202 @@ _CPU_AND_GPU_CODE_ inline void buildHashAllocAndVisibleTypePP(
   }
 }
 
+/** Takes the next element of a list that several threads append to, by
+    incrementing its length @p noElements.
+*/
+_CPU_AND_GPU_CODE_ inline int appendListElement(DEVICEPTR(int)* noElements) {
+  int elementIdx;
+#if defined(__CUDACC__) && defined(__CUDA_ARCH__)
+  elementIdx = atomicAdd(noElements, 1);
+#else
+#ifdef WITH_OPENMP
+#pragma omp atomic capture
+#endif
+  elementIdx = (*noElements)++;
+#endif
+  return elementIdx;
+}
+
+/** Like buildHashAllocAndVisibleTypePP, but for the open addressing hash.
+    Blocks that are not in the table are marked for allocation in the first
+    free slot of their probe sequence. The first request for a slot also
+    appends it to @p allocationRequests, unless the list already has
+    @p maxAllocationRequests elements, so that the allocation only visits
+    the requested slots. Concurrent first requests may list a slot twice.
+*/
+_CPU_AND_GPU_CODE_ inline void buildOpenHashAllocAndVisibleTypePP(
+    /* clang-format off */
+    DEVICEPTR(uchar)* entriesAllocType, DEVICEPTR(uchar)* entriesVisibleType,
+    DEVICEPTR(int)* allocationRequests, DEVICEPTR(int)* noAllocationRequests,
+    int maxAllocationRequests, int x, int y, DEVICEPTR(Vector4s)* blockCoords,
+    const CONSTPTR(float)* depth, Matrix4f invM_d, Vector4f projParams_d,
+    float mu, Vector2i imgSize, float oneOverVoxelSize,
+    const CONSTPTR(ITMOpenHashBucket)* buckets, float viewFrustum_min,
+    float viewFrustum_max /* clang-format on */) {
+  float depth_measure;
+  int noSteps;
+  Vector3f pt_camera_f, point_e, point, direction;
+  Vector3s blockPos;
+
+  depth_measure = depth[x + y * imgSize.x];
+  if (depth_measure <= 0 || (depth_measure - mu) < 0 ||
+      (depth_measure - mu) < viewFrustum_min ||
+      (depth_measure + mu) > viewFrustum_max)
+    return;
+
+  pt_camera_f.z = depth_measure;
+  pt_camera_f.x =
+      pt_camera_f.z * ((float(x) - projParams_d.z) * projParams_d.x);
+  pt_camera_f.y =
+      pt_camera_f.z * ((float(y) - projParams_d.w) * projParams_d.y);
+
+  float norm =
+      sqrt(pt_camera_f.x * pt_camera_f.x + pt_camera_f.y * pt_camera_f.y +
+           pt_camera_f.z * pt_camera_f.z);
+
+  Vector4f tmp;
+  tmp.x = pt_camera_f.x * (1.0f - mu / norm);
+  tmp.y = pt_camera_f.y * (1.0f - mu / norm);
+  tmp.z = pt_camera_f.z * (1.0f - mu / norm);
+  tmp.w = 1.0f;
+  point = TO_VECTOR3(invM_d * tmp) * oneOverVoxelSize;
+  tmp.x = pt_camera_f.x * (1.0f + mu / norm);
+  tmp.y = pt_camera_f.y * (1.0f + mu / norm);
+  tmp.z = pt_camera_f.z * (1.0f + mu / norm);
+  point_e = TO_VECTOR3(invM_d * tmp) * oneOverVoxelSize;
+
+  direction = point_e - point;
+  norm = sqrt(direction.x * direction.x + direction.y * direction.y +
+              direction.z * direction.z);
+  noSteps = (int)ceil(2.0f * norm);
+
+  direction /= (float)(noSteps - 1);
+
+  // add neighbouring blocks
+  for (int i = 0; i < noSteps; i++) {
+    blockPos = TO_SHORT_FLOOR3(point);
+
+    int freeEntryId;
+    int entryId = findOpenHashEntry(buckets, blockPos, freeEntryId);
+
+    if (entryId >= 0) {
+      entriesVisibleType[entryId] = 1;
+    } else if (freeEntryId >= 0) {
+      if (entriesAllocType[freeEntryId] == 0) {
+        int requestIdx = appendListElement(noAllocationRequests);
+        if (requestIdx >= maxAllocationRequests) {  // asked again next frame
+          point += direction;
+          continue;
+        }
+        allocationRequests[requestIdx] = freeEntryId;
+      }
+
+      entriesAllocType[freeEntryId] = 1;    // needs allocation
+      entriesVisibleType[freeEntryId] = 1;  // new entry is visible
+
+      blockCoords[freeEntryId] =
+          Vector4s(blockPos.x, blockPos.y, blockPos.z, 1);
+    }
+
+    point += direction;
+  }
+}
+
+/** Computes the segment of the ray through pixel (@p x, @p y) that lies in
+    the truncation band around its depth, in voxel blocks: @p noSteps points
+    from @p point on, @p direction apart. Returns false if the depth is
+    invalid or the band is outside of the view frustum.
+*/
+_CPU_AND_GPU_CODE_ inline bool computeTruncationBandSegment(
+    /* clang-format off */
+    THREADPTR(Vector3f)& point, THREADPTR(Vector3f)& direction,
+    THREADPTR(int)& noSteps, int x, int y, const CONSTPTR(float)* depth,
+    Matrix4f invM_d, Vector4f projParams_d, float mu, Vector2i imgSize,
+    float oneOverVoxelSize, float viewFrustum_min,
+    float viewFrustum_max /* clang-format on */) {
+  float depth_measure;
+  Vector3f pt_camera_f, point_e;
+
+  depth_measure = depth[x + y * imgSize.x];
+  if (depth_measure <= 0 || (depth_measure - mu) < 0 ||
+      (depth_measure - mu) < viewFrustum_min ||
+      (depth_measure + mu) > viewFrustum_max)
+    return false;
+
+  pt_camera_f.z = depth_measure;
+  pt_camera_f.x =
+      pt_camera_f.z * ((float(x) - projParams_d.z) * projParams_d.x);
+  pt_camera_f.y =
+      pt_camera_f.z * ((float(y) - projParams_d.w) * projParams_d.y);
+
+  float norm =
+      sqrt(pt_camera_f.x * pt_camera_f.x + pt_camera_f.y * pt_camera_f.y +
+           pt_camera_f.z * pt_camera_f.z);
+
+  Vector4f tmp;
+  tmp.x = pt_camera_f.x * (1.0f - mu / norm);
+  tmp.y = pt_camera_f.y * (1.0f - mu / norm);
+  tmp.z = pt_camera_f.z * (1.0f - mu / norm);
+  tmp.w = 1.0f;
+  point = TO_VECTOR3(invM_d * tmp) * oneOverVoxelSize;
+  tmp.x = pt_camera_f.x * (1.0f + mu / norm);
+  tmp.y = pt_camera_f.y * (1.0f + mu / norm);
+  tmp.z = pt_camera_f.z * (1.0f + mu / norm);
+  point_e = TO_VECTOR3(invM_d * tmp) * oneOverVoxelSize;
+
+  direction = point_e - point;
+  norm = sqrt(direction.x * direction.x + direction.y * direction.y +
+              direction.z * direction.z);
+  noSteps = (int)ceil(2.0f * norm);
+
+  direction /= (float)(noSteps - 1);
+
+  return true;
+}
+
+/** Like buildHashAllocAndVisibleTypePP, but for the voxel block octree.
+    Marks the blocks in the truncation band of pixel (@p x, @p y) that are
+    in the octree visible, and returns true if any of the others inside the
+    root still have to be allocated. Allocation inserts nodes, so it is left
+    to the caller.
+*/
+_CPU_AND_GPU_CODE_ inline bool buildOctreeVisibleTypePP(
+    /* clang-format off */
+    DEVICEPTR(uchar)* entriesVisibleType, int x, int y,
+    const CONSTPTR(float)* depth, Matrix4f invM_d, Vector4f projParams_d,
+    float mu, Vector2i imgSize, float oneOverVoxelSize,
+    const CONSTPTR(ITMOctreeNode)* nodes, float viewFrustum_min,
+    float viewFrustum_max /* clang-format on */) {
+  int noSteps;
+  Vector3f point, direction;
+
+  if (!computeTruncationBandSegment(point, direction, noSteps, x, y, depth,
+                                    invM_d, projParams_d, mu, imgSize,
+                                    oneOverVoxelSize, viewFrustum_min,
+                                    viewFrustum_max))
+    return false;
+
+  bool needsAllocation = false;
+
+  for (int i = 0; i < noSteps; i++) {
+    Vector3i blockPos((int)floor(point.x), (int)floor(point.y),
+                      (int)floor(point.z));
+
+    if (isInOctree(blockPos)) {
+      int nodeIdx = 0, level = 0;
+      if (descendOctree(nodes, blockPos, nodeIdx, level) >= 0)
+        entriesVisibleType[nodeIdx * 8 +
+                           octreeChildIdx(blockPos, level)] = 1;
+      else
+        needsAllocation = true;
+    }
+
+    point += direction;
+  }
+
+  return needsAllocation;
+}
+
 template <bool useSwapping>
 _CPU_AND_GPU_CODE_ inline void checkPointVisibility(
     /* clang-format off */
@@ -273,11 +471,11 @@ _CPU_AND_GPU_CODE_ inline void checkPointVisibility(
   }
 }
 
-template <bool useSwapping>
+template <bool useSwapping, typename T>
 _CPU_AND_GPU_CODE_ inline void checkBlockVisibility(
     /* clang-format off */
     THREADPTR(bool)& isVisible, THREADPTR(bool)& isVisibleEnlarged,
-    const THREADPTR(Vector3s)& hashPos, const CONSTPTR(Matrix4f)& M_d,
+    const THREADPTR(T)& hashPos, const CONSTPTR(Matrix4f)& M_d,
     const CONSTPTR(Vector4f)& projParams_d, const CONSTPTR(float)& voxelSize,
     const CONSTPTR(Vector2i)& imgSize /* clang-format on */) {
   Vector4f pt_image;
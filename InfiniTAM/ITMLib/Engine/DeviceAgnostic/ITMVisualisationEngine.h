@@ -25,7 +25,7 @@ static const CONSTPTR(int) MAX_RENDERING_BLOCKS = 65536*4;
 //static const int MAX_RENDERING_BLOCKS = 16384;
 static const CONSTPTR(int) minmaximg_subsample = 8;
 
-_CPU_AND_GPU_CODE_ inline bool ProjectSingleBlock(const THREADPTR(Vector3s) & blockPos, const THREADPTR(Matrix4f) & pose, const THREADPTR(Vector4f) & intrinsics, 
+template<typename T> _CPU_AND_GPU_CODE_ inline bool ProjectSingleBlock(const THREADPTR(T) & blockPos, const THREADPTR(Matrix4f) & pose, const THREADPTR(Vector4f) & intrinsics, 
 	const THREADPTR(Vector2i) & imgSize, float voxelSize, THREADPTR(Vector2i) & upperLeft, THREADPTR(Vector2i) & lowerRight, THREADPTR(Vector2f) & zRange)
 {
 	upperLeft = imgSize / minmaximg_subsample;
@@ -34,11 +34,11 @@ _CPU_AND_GPU_CODE_ inline bool ProjectSingleBlock(const THREADPTR(Vector3s) & bl
 	for (int corner = 0; corner < 8; ++corner)
 	{
 		// project all 8 corners down to 2D image
-		Vector3s tmp = blockPos;
+		Vector3f tmp((float)blockPos.x, (float)blockPos.y, (float)blockPos.z);
 		tmp.x += (corner & 1) ? 1 : 0;
 		tmp.y += (corner & 2) ? 1 : 0;
 		tmp.z += (corner & 4) ? 1 : 0;
-		Vector4f pt3d(TO_FLOAT3(tmp) * (float)SDF_BLOCK_SIZE * voxelSize, 1.0f);
+		Vector4f pt3d(tmp * (float)SDF_BLOCK_SIZE * voxelSize, 1.0f);
 		pt3d = pose * pt3d;
 		if (pt3d.z < 1e-6) continue;
 
@@ -89,10 +89,21 @@ _CPU_AND_GPU_CODE_ inline void CreateRenderingBlocks(DEVICEPTR(RenderingBlock) *
 	}
 }
 
-template<class TVoxel, class TIndex>
+/** Without an occupancy grid, only the position the ray is at is known
+    to miss all blocks, see countEmptyBlockSteps() for the voxel block
+    hash on the CPU.
+*/
+template<class TCache>
+_CPU_AND_GPU_CODE_ inline int countEmptyBlockSteps(THREADPTR(TCache) & cache, const THREADPTR(Vector3f) & point,
+	const THREADPTR(Vector3f) & rayDirection)
+{
+	return 1;
+}
+
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y, const CONSTPTR(TVoxel) *voxelData,
 	const CONSTPTR(typename TIndex::IndexData) *voxelIndex, Matrix4f invM, Vector4f projParams, float oneOverVoxelSize, 
-	float mu, const CONSTPTR(Vector2f) & viewFrustum_minmax)
+	float mu, const CONSTPTR(Vector2f) & viewFrustum_minmax, THREADPTR(TCache) & cache)
 {
 	Vector4f pt_camera_f; Vector3f pt_block_s, pt_block_e, rayDirection, pt_result;
 	bool pt_found, hash_found;
@@ -121,13 +132,18 @@ _CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y
 
 	pt_result = pt_block_s;
 
-	typename TIndex::IndexCache cache;
-
 	while (totalLength < totalLengthMax) {
 		sdfValue = readFromSDF_float_uninterpolated(voxelData, voxelIndex, pt_result, hash_found, cache);
 
 		if (!hash_found) {
 			stepLength = SDF_BLOCK_SIZE;
+
+			// the positions of the following steps miss as well, so take them without reading the SDF
+			for (int noEmptySteps = countEmptyBlockSteps(cache, pt_result, rayDirection) - 1;
+				noEmptySteps > 0 && totalLength + stepLength < totalLengthMax; noEmptySteps--)
+			{
+				pt_result += stepLength * rayDirection; totalLength += stepLength;
+			}
 		} else {
 			if ((sdfValue <= 0.1f) && (sdfValue >= -0.5f)) {
 				sdfValue = readFromSDF_float_interpolated(voxelData, voxelIndex, pt_result, hash_found, cache);
@@ -157,6 +173,15 @@ _CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y
 	return pt_found;
 }
 
+template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline bool castRay(DEVICEPTR(Vector4f) &pt_out, int x, int y, const CONSTPTR(TVoxel) *voxelData,
+	const CONSTPTR(typename TIndex::IndexData) *voxelIndex, Matrix4f invM, Vector4f projParams, float oneOverVoxelSize, 
+	float mu, const CONSTPTR(Vector2f) & viewFrustum_minmax)
+{
+	typename TIndex::IndexCache cache;
+	return castRay<TVoxel, TIndex>(pt_out, x, y, voxelData, voxelIndex, invM, projParams, oneOverVoxelSize, mu, viewFrustum_minmax, cache);
+}
+
 _CPU_AND_GPU_CODE_ inline int forwardProjectPixel(Vector4f pixel, const CONSTPTR(Matrix4f) &M, const CONSTPTR(Vector4f) &projParams,
 	const THREADPTR(Vector2i) &imgSize)
 {
@@ -172,14 +197,15 @@ _CPU_AND_GPU_CODE_ inline int forwardProjectPixel(Vector4f pixel, const CONSTPTR
 	return (int)(pt_image.x + 0.5f) + (int)(pt_image.y + 0.5f) * imgSize.x;
 }
 
-template<class TVoxel, class TIndex>
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline void computeNormalAndAngle(THREADPTR(bool) & foundPoint, const THREADPTR(Vector3f) & point,
                                                      const CONSTPTR(TVoxel) *voxelBlockData, const CONSTPTR(typename TIndex::IndexData) *indexData,
-                                                     const THREADPTR(Vector3f) & lightSource, THREADPTR(Vector3f) & outNormal, THREADPTR(float) & angle)
+                                                     const THREADPTR(Vector3f) & lightSource, THREADPTR(Vector3f) & outNormal, THREADPTR(float) & angle,
+                                                     THREADPTR(TCache) & cache)
 {
 	if (!foundPoint) return;
 
-	outNormal = computeSingleNormalFromSDF(voxelBlockData, indexData, point);
+	outNormal = computeSingleNormalFromSDF(voxelBlockData, indexData, point, cache);
 
 	float normScale = 1.0f / sqrt(outNormal.x * outNormal.x + outNormal.y * outNormal.y + outNormal.z * outNormal.z);
 	outNormal *= normScale;
@@ -188,6 +214,15 @@ _CPU_AND_GPU_CODE_ inline void computeNormalAndAngle(THREADPTR(bool) & foundPoin
 	if (!(angle > 0.0)) foundPoint = false;
 }
 
+template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline void computeNormalAndAngle(THREADPTR(bool) & foundPoint, const THREADPTR(Vector3f) & point,
+                                                     const CONSTPTR(TVoxel) *voxelBlockData, const CONSTPTR(typename TIndex::IndexData) *indexData,
+                                                     const THREADPTR(Vector3f) & lightSource, THREADPTR(Vector3f) & outNormal, THREADPTR(float) & angle)
+{
+	typename TIndex::IndexCache cache;
+	computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelBlockData, indexData, lightSource, outNormal, angle, cache);
+}
+
 template <bool useSmoothing>
 _CPU_AND_GPU_CODE_ inline void computeNormalAndAngle(THREADPTR(bool) & foundPoint, const THREADPTR(int) &x, const THREADPTR(int) &y,
 	const CONSTPTR(Vector4f) *pointsRay, const THREADPTR(Vector3f) & lightSource, const THREADPTR(float) &voxelSize,
@@ -266,11 +301,11 @@ _CPU_AND_GPU_CODE_ inline void drawPixelNormal(DEVICEPTR(Vector4u) & dest, const
 	dest.b = (uchar)((0.3f + (-normal_obj.b + 1.0f)*0.35f)*255.0f);
 }
 
-template<class TVoxel, class TIndex>
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline void drawPixelColour(DEVICEPTR(Vector4u) & dest, const CONSTPTR(Vector3f) & point, 
-	const CONSTPTR(TVoxel) *voxelBlockData, const CONSTPTR(typename TIndex::IndexData) *indexData)
+	const CONSTPTR(TVoxel) *voxelBlockData, const CONSTPTR(typename TIndex::IndexData) *indexData, THREADPTR(TCache) & cache)
 {
-	Vector4f clr = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate(voxelBlockData, indexData, point);
+	Vector4f clr = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate(voxelBlockData, indexData, point, cache);
 
 	dest.x = (uchar)(clr.x * 255.0f);
 	dest.y = (uchar)(clr.y * 255.0f);
@@ -365,45 +400,72 @@ _CPU_AND_GPU_CODE_ inline void processPixelForwardRender(DEVICEPTR(Vector4u) *ou
 	else outRendering[locId] = Vector4u((uchar)0);
 }
 
-template<class TVoxel, class TIndex>
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline void processPixelGrey(DEVICEPTR(Vector4u) &outRendering, const CONSTPTR(Vector3f) & point, 
 	bool foundPoint, const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex, 
-	Vector3f lightSource)
+	Vector3f lightSource, THREADPTR(TCache) & cache)
 {
 	Vector3f outNormal;
 	float angle;
 
-	computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle);
+	computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle, cache);
 
 	if (foundPoint) drawPixelGrey(outRendering, angle);
 	else outRendering = Vector4u((uchar)0);
 }
 
 template<class TVoxel, class TIndex>
-_CPU_AND_GPU_CODE_ inline void processPixelColour(DEVICEPTR(Vector4u) &outRendering, const CONSTPTR(Vector3f) & point,
+_CPU_AND_GPU_CODE_ inline void processPixelGrey(DEVICEPTR(Vector4u) &outRendering, const CONSTPTR(Vector3f) & point, 
 	bool foundPoint, const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex, 
 	Vector3f lightSource)
+{
+	typename TIndex::IndexCache cache;
+	processPixelGrey<TVoxel, TIndex>(outRendering, point, foundPoint, voxelData, voxelIndex, lightSource, cache);
+}
+
+template<class TVoxel, class TIndex, class TCache>
+_CPU_AND_GPU_CODE_ inline void processPixelColour(DEVICEPTR(Vector4u) &outRendering, const CONSTPTR(Vector3f) & point,
+	bool foundPoint, const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex, 
+	Vector3f lightSource, THREADPTR(TCache) & cache)
 {
 	Vector3f outNormal;
 	float angle;
 
-	computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle);
+	computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle, cache);
 
-	if (foundPoint) drawPixelColour<TVoxel, TIndex>(outRendering, point, voxelData, voxelIndex);
+	if (foundPoint) drawPixelColour<TVoxel, TIndex>(outRendering, point, voxelData, voxelIndex, cache);
 	else outRendering = Vector4u((uchar)0);
 }
 
-
 template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline void processPixelColour(DEVICEPTR(Vector4u) &outRendering, const CONSTPTR(Vector3f) & point,
+	bool foundPoint, const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex, 
+	Vector3f lightSource)
+{
+	typename TIndex::IndexCache cache;
+	processPixelColour<TVoxel, TIndex>(outRendering, point, foundPoint, voxelData, voxelIndex, lightSource, cache);
+}
+
+
+template<class TVoxel, class TIndex, class TCache>
 _CPU_AND_GPU_CODE_ inline void processPixelNormal(DEVICEPTR(Vector4u) &outRendering, const CONSTPTR(Vector3f) & point,
 	bool foundPoint, const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
-	Vector3f lightSource)
+	Vector3f lightSource, THREADPTR(TCache) & cache)
 {
 	Vector3f outNormal;
 	float angle;
 
-	computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle);
+	computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle, cache);
 
 	if (foundPoint) drawPixelNormal(outRendering, outNormal);
 	else outRendering = Vector4u((uchar)0);
 }
+
+template<class TVoxel, class TIndex>
+_CPU_AND_GPU_CODE_ inline void processPixelNormal(DEVICEPTR(Vector4u) &outRendering, const CONSTPTR(Vector3f) & point,
+	bool foundPoint, const CONSTPTR(TVoxel) *voxelData, const CONSTPTR(typename TIndex::IndexData) *voxelIndex,
+	Vector3f lightSource)
+{
+	typename TIndex::IndexCache cache;
+	processPixelNormal<TVoxel, TIndex>(outRendering, point, foundPoint, voxelData, voxelIndex, lightSource, cache);
+}
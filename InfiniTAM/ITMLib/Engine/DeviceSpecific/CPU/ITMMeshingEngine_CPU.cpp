@@ -15,39 +15,44 @@ ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockHash>::~ITMMeshingEngine_CPU(void)
 {
 }
 
-template<class TVoxel>
-void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+template<class TVoxel, class TIndex, class TVoxelData>
+static void MeshScene_common(ITMMesh *mesh, const ITMScene<TVoxel, TIndex> *scene, const TVoxelData *localVBA)
 {
 	ITMMesh::Triangle *triangles = mesh->triangles->GetData(MEMORYDEVICE_CPU);
-	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
-	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	const typename TIndex::IndexData *hashTable = scene->index.getIndexData();
+	const int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
 
-	int noTriangles = 0, noMaxTriangles = mesh->noMaxTriangles, noTotalEntries = scene->index.noTotalEntries;
+	int noTriangles = 0, noMaxTriangles = mesh->noMaxTriangles, noAllocatedEntries = scene->index.GetNoAllocatedEntries();
 	float factor = scene->sceneParams->voxelSize;
+	// the triangles are put back where the scene was before it was recentered
+	Vector3f origin = scene->blockOrigin.toFloat() * (factor * SDF_BLOCK_SIZE);
+	const typename ITMIndexCache_CPU<TIndex>::Type emptyCache = ITMIndexCache_CPU<TIndex>::create(&scene->index);
 
 	mesh->triangles->Clear();
 
-	for (int entryId = 0; entryId < noTotalEntries; entryId++)
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
 	{
 		Vector3i globalPos;
-		const ITMHashEntry &currentHashEntry = hashTable[entryId];
+		ITMBlockPos blockPos; int blockPtr;
+		readBlockEntry(hashTable, allocatedEntryIDs[listIdx], blockPos, blockPtr);
 
-		if (currentHashEntry.ptr < 0) continue;
+		if (blockPtr < 0) continue;
 
-		globalPos = currentHashEntry.pos.toInt() * SDF_BLOCK_SIZE;
+		globalPos = blockPos.toInt() * SDF_BLOCK_SIZE;
+		typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
 
 		for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
 		{
 			Vector3f vertList[12];
-			int cubeIndex = buildVertList(vertList, globalPos, Vector3i(x, y, z), localVBA, hashTable);
+			int cubeIndex = buildVertList(vertList, globalPos, Vector3i(x, y, z), localVBA, hashTable, cache);
 			
 			if (cubeIndex < 0) continue;
 
 			for (int i = 0; triangleTable[cubeIndex][i] != -1; i += 3)
 			{
-				triangles[noTriangles].p0 = vertList[triangleTable[cubeIndex][i]] * factor;
-				triangles[noTriangles].p1 = vertList[triangleTable[cubeIndex][i + 1]] * factor;
-				triangles[noTriangles].p2 = vertList[triangleTable[cubeIndex][i + 2]] * factor;
+				triangles[noTriangles].p0 = vertList[triangleTable[cubeIndex][i]] * factor + origin;
+				triangles[noTriangles].p1 = vertList[triangleTable[cubeIndex][i + 1]] * factor + origin;
+				triangles[noTriangles].p2 = vertList[triangleTable[cubeIndex][i + 2]] * factor + origin;
 
 				if (noTriangles < noMaxTriangles - 1) noTriangles++;
 			}
@@ -57,6 +62,50 @@ void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash>::MeshScene(ITMMesh *mesh, c
 	mesh->noTotalTriangles = noTriangles;
 }
 
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockHash>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) MeshScene_common(mesh, scene, (const ITMVoxel_SoA<TVoxel>*)localVBA);
+	else MeshScene_common(mesh, scene, localVBA);
+}
+
+template<class TVoxel>
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::ITMMeshingEngine_CPU(void) 
+{
+}
+
+template<class TVoxel>
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockOctree>::ITMMeshingEngine_CPU(void) 
+{
+}
+
+template<class TVoxel>
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::~ITMMeshingEngine_CPU(void) 
+{
+}
+
+template<class TVoxel>
+ITMMeshingEngine_CPU<TVoxel,ITMVoxelBlockOctree>::~ITMMeshingEngine_CPU(void) 
+{
+}
+
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene)
+{
+	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) MeshScene_common(mesh, scene, (const ITMVoxel_SoA<TVoxel>*)localVBA);
+	else MeshScene_common(mesh, scene, localVBA);
+}
+
+template<class TVoxel>
+void ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOctree>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOctree> *scene)
+{
+	const TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) MeshScene_common(mesh, scene, (const ITMVoxel_SoA<TVoxel>*)localVBA);
+	else MeshScene_common(mesh, scene, localVBA);
+}
+
 template<class TVoxel>
 ITMMeshingEngine_CPU<TVoxel,ITMPlainVoxelArray>::ITMMeshingEngine_CPU(void) 
 {}
@@ -69,4 +118,4 @@ template<class TVoxel>
 void ITMMeshingEngine_CPU<TVoxel, ITMPlainVoxelArray>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMPlainVoxelArray> *scene)
 {}
 
-template class ITMLib::Engine::ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMMeshingEngine_CPU)
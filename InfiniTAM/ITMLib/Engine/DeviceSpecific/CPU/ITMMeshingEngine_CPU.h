@@ -22,6 +22,26 @@ namespace ITMLib
 			~ITMMeshingEngine_CPU(void);
 		};
 
+		template<class TVoxel>
+		class ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOpenHash> : public ITMMeshingEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		public:
+			void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene);
+
+			ITMMeshingEngine_CPU(void);
+			~ITMMeshingEngine_CPU(void);
+		};
+
+		template<class TVoxel>
+		class ITMMeshingEngine_CPU<TVoxel, ITMVoxelBlockOctree> : public ITMMeshingEngine < TVoxel, ITMVoxelBlockOctree >
+		{
+		public:
+			void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOctree> *scene);
+
+			ITMMeshingEngine_CPU(void);
+			~ITMMeshingEngine_CPU(void);
+		};
+
 		template<class TVoxel>
 		class ITMMeshingEngine_CPU<TVoxel, ITMPlainVoxelArray> : public ITMMeshingEngine < TVoxel, ITMPlainVoxelArray >
 		{
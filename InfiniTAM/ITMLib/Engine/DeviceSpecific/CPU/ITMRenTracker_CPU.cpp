@@ -23,13 +23,20 @@ void ITMRenTracker_CPU<TVoxel,TIndex>::F_oneLevel(float *f, Matrix4f invM)
 	const TVoxel *voxelBlocks = this->scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *index = this->scene->index.getIndexData();
 	float oneOverVoxelSize = 1.0f / (float)this->scene->sceneParams->voxelSize;
+	bool useSoAVoxelBlocks = this->scene->sceneParams->useSoAVoxelBlocks;
+	const typename ITMIndexCache_CPU<TIndex>::Type emptyCache = ITMIndexCache_CPU<TIndex>::create(&this->scene->index);
 
 	float energy = 0;
 
 	for (int i = 0; i < count; i++)
 	{
 		Vector4f inpt = ptList[i];
-		if (inpt.w > -1.0f) energy += computePerPixelEnergy<TVoxel,TIndex>(inpt, voxelBlocks, index, oneOverVoxelSize, invM);
+		if (inpt.w <= -1.0f) continue;
+
+		typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
+		if (useSoAVoxelBlocks) energy += computePerPixelEnergy<ITMVoxel_SoA<TVoxel>,TIndex>(inpt, (const ITMVoxel_SoA<TVoxel>*)voxelBlocks, index,
+			oneOverVoxelSize, invM, cache);
+		else energy += computePerPixelEnergy<TVoxel,TIndex>(inpt, voxelBlocks, index, oneOverVoxelSize, invM, cache);
 	}
 
 	f[0] = -energy;
@@ -44,6 +51,8 @@ void ITMRenTracker_CPU<TVoxel,TIndex>::G_oneLevel(float *gradient, float *hessia
 	const TVoxel *voxelBlocks = this->scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *index = this->scene->index.getIndexData();
 	float oneOverVoxelSize = 1.0f / (float)this->scene->sceneParams->voxelSize;
+	bool useSoAVoxelBlocks = this->scene->sceneParams->useSoAVoxelBlocks;
+	const typename ITMIndexCache_CPU<TIndex>::Type emptyCache = ITMIndexCache_CPU<TIndex>::create(&this->scene->index);
 
 	int noPara = 6, noParaSQ = 21;
 
@@ -57,8 +66,11 @@ void ITMRenTracker_CPU<TVoxel,TIndex>::G_oneLevel(float *gradient, float *hessia
 		if (cPt.w == -1.0f) continue;
 
 		float jacobian[6];
+		typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
+		bool isValid = useSoAVoxelBlocks ? computePerPixelJacobian<ITMVoxel_SoA<TVoxel>,TIndex>(jacobian, cPt, (const ITMVoxel_SoA<TVoxel>*)voxelBlocks,
+			index, oneOverVoxelSize, invM, cache) : computePerPixelJacobian<TVoxel,TIndex>(jacobian, cPt, voxelBlocks, index, oneOverVoxelSize, invM, cache);
 
-		if (computePerPixelJacobian<TVoxel,TIndex>(jacobian, cPt, voxelBlocks, index, oneOverVoxelSize, invM))
+		if (isValid)
 		{
 			for (int r = 0, counter = 0; r < noPara; r++)
 			{
@@ -101,4 +113,4 @@ void ITMRenTracker_CPU<TVoxel,TIndex>::UnprojectDepthToCam(ITMFloatImage *depth,
 	}
 }
 
-template class ITMLib::Engine::ITMRenTracker_CPU<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMRenTracker_CPU)
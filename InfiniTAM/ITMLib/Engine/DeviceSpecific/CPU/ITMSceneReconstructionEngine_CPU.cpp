@@ -4,118 +4,2126 @@
 #include "../../DeviceAgnostic/ITMSceneReconstructionEngine.h"
 #include "../../../Objects/ITMRenderState_VH.h"
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
 using namespace ITMLib::Engine;
 
 template<class TVoxel>
-ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstructionEngine_CPU(void) 
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstructionEngine_CPU(void) 
+{
+	// sized to the scene's hash table in ResetScene
+	entriesAllocType = NULL;
+	blockCoords = NULL;
+	allocationRequests = NULL;
+	// sized to the depth image in IntegrateIntoScene
+	depthTiles = NULL;
+	garbageCollectionCursor = 0;
+	// sized to the scene's hash table in ResetScene if its origin is to be moved
+	recenteredEntries = NULL;
+	recenteredExcessList = NULL;
+	recenteredBlockOccupancy = NULL;
+	recenteredEntryIDs = NULL;
+	lastFreeRecenteredExcessId = -1;
+	isRecentering = false;
+	noRecenteredEntries = 0;
+}
+
+template<class TVoxel>
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::~ITMSceneReconstructionEngine_CPU(void) 
+{
+	delete entriesAllocType;
+	delete blockCoords;
+	delete allocationRequests;
+	delete depthTiles;
+	delete recenteredEntries;
+	delete recenteredExcessList;
+	delete recenteredBlockOccupancy;
+	delete recenteredEntryIDs;
+}
+
+template<class TVoxel, class TVoxelData>
+static void resetVoxels(TVoxelData *voxelData, int noVoxels)
+{
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int i = 0; i < noVoxels; ++i) writeVoxel(voxelData, i, TVoxel());
+}
+
+template<class TVoxel, class TVoxelData>
+static void clearHandedOutBlocks(TVoxelData *voxelData, const int *voxelAllocationList, int oldLastFreeBlockId, int lastFreeBlockId)
+{
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int vbaIdx = MAX(lastFreeBlockId + 1, 0); vbaIdx <= oldLastFreeBlockId; vbaIdx++)
+	{
+		int blockAddress = voxelAllocationList[vbaIdx] * SDF_BLOCK_SIZE3;
+		for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++) writeVoxel(voxelData, blockAddress + locId, TVoxel());
+	}
+}
+
+template<class TVoxel, class TIndex>
+static void clearHandedOutBlocks(ITMScene<TVoxel, TIndex> *scene, int oldLastFreeBlockId)
+{
+	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
+	const int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int lastFreeBlockId = scene->localVBA.lastFreeBlockId;
+
+	if (scene->sceneParams->useSoAVoxelBlocks)
+		clearHandedOutBlocks<TVoxel>((ITMVoxel_SoA<TVoxel>*)voxelBlocks_ptr, voxelAllocationList, oldLastFreeBlockId, lastFreeBlockId);
+	else clearHandedOutBlocks<TVoxel>(voxelBlocks_ptr, voxelAllocationList, oldLastFreeBlockId, lastFreeBlockId);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ClearHandedOutBlocks(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	int oldLastFreeBlockId) const
+{
+	clearHandedOutBlocks(scene, oldLastFreeBlockId);
+}
+
+/** Links the voxel blocks of the entries in the allocated entry list that
+    are not in the block neighbour table yet, i.e. whose row does not refer
+    to the block itself, and counts them in the block occupancy grid.
+*/
+template<class TVoxel>
+static void linkNewVoxelBlocks(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	int *blockOccupancy = scene->index.GetBlockOccupancy(), occupancyMask = scene->index.GetBlockOccupancyMask();
+	if (blockNeighbours == NULL) return;
+
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	const int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	int centreIdx = blockNeighbourIdx(Vector3i(0, 0, 0));
+
+	// linking a block writes the rows of its neighbours as well, so this pass is serial
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		const ITMHashEntry &hashEntry = hashTable[allocatedEntryIDs[listIdx]];
+
+		if (hashEntry.ptr >= 0 && blockNeighbours[hashEntry.ptr * SDF_BLOCK_NEIGHBOUR_NUM + centreIdx] != hashEntry.ptr)
+		{
+			linkBlockNeighbours(blockNeighbours, hashTable, scene->index.GetHashMask(), hashEntry.pos.toInt(), hashEntry.ptr);
+			updateBlockOccupancy(blockOccupancy, occupancyMask, hashEntry.pos.toInt(), 1);
+		}
+	}
+}
+
+/** Counts the voxel blocks linked in the block neighbour table in the block
+    occupancy grid anew, once the grid changed its size.
+*/
+template<class TVoxel>
+static void recountBlockOccupancy(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	int *blockOccupancy = scene->index.GetBlockOccupancy(), occupancyMask = scene->index.GetBlockOccupancyMask();
+	if (blockNeighbours == NULL) return;
+
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	const int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	int centreIdx = blockNeighbourIdx(Vector3i(0, 0, 0));
+
+	memset(blockOccupancy, 0, SDF_OCCUPANCY_LEVEL_NUM * (occupancyMask + 1) * sizeof(int));
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		const ITMHashEntry &hashEntry = hashTable[allocatedEntryIDs[listIdx]];
+		if (hashEntry.ptr >= 0 && blockNeighbours[hashEntry.ptr * SDF_BLOCK_NEIGHBOUR_NUM + centreIdx] == hashEntry.ptr)
+			updateBlockOccupancy(blockOccupancy, occupancyMask, hashEntry.pos.toInt(), 1);
+	}
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::LinkHandedOutBlocks(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	int oldLastFreeBlockId) const
+{
+	if (scene->localVBA.lastFreeBlockId != oldLastFreeBlockId) linkNewVoxelBlocks(scene);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	int numBlocks = scene->index.getNumAllocatedVoxelBlocks();
+
+	// the voxels are left as they are, blocks are cleared when they are handed out
+	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
+	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
+	scene->localVBA.lastFreeBlockId = numBlocks - 1;
+
+	ITMHashEntry tmpEntry;
+	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
+	tmpEntry.ptr = -2;
+	ITMHashEntry *hashEntry_ptr = scene->index.GetEntries();
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int i = 0; i < scene->index.noTotalEntries; ++i) hashEntry_ptr[i] = tmpEntry;
+	int *blockNeighbours_ptr = scene->index.GetBlockNeighbours();
+	if (blockNeighbours_ptr != NULL)
+	{
+#ifdef WITH_OPENMP
+		#pragma omp parallel for
+#endif
+		for (int i = 0; i < numBlocks * SDF_BLOCK_NEIGHBOUR_NUM; ++i) blockNeighbours_ptr[i] = -1;
+	}
+	int *blockOccupancy_ptr = scene->index.GetBlockOccupancy();
+	if (blockOccupancy_ptr != NULL) memset(blockOccupancy_ptr, 0, SDF_OCCUPANCY_LEVEL_NUM * (scene->index.GetBlockOccupancyMask() + 1) * sizeof(int));
+	int *excessList_ptr = scene->index.GetExcessAllocationList();
+	int noExcessEntries = scene->index.GetExcessListSize();
+	for (int i = 0; i < noExcessEntries; ++i) excessList_ptr[i] = i;
+
+	scene->index.SetLastFreeExcessListId(noExcessEntries - 1);
+	scene->index.SetNoAllocatedEntries(0);
+	scene->index.SetNoDroppedBlocks(0, true);
+
+	// the swap queues and stored blocks refer to the entries just removed
+	if (scene->useSwapping) scene->globalCache->Reset();
+
+	int noTotalEntries = scene->index.noTotalEntries;
+	if (entriesAllocType == NULL || entriesAllocType->dataSize != (size_t)noTotalEntries)
+	{
+		delete entriesAllocType;
+		delete blockCoords;
+		delete allocationRequests;
+		entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(noTotalEntries, MEMORYDEVICE_CPU);
+		blockCoords = new ORUtils::MemoryBlock<ITMBlockCoords>(noTotalEntries, MEMORYDEVICE_CPU);
+		allocationRequests = new ORUtils::MemoryBlock<int>(noTotalEntries, MEMORYDEVICE_CPU);
+	}
+
+	// the table for moving the origin is set up here rather than by the first move, which should not stall a frame
+	if (scene->sceneParams->recenteringDistance > 0.0f || recenteredEntries != NULL) ClearRecenteredEntries(scene, scene->index.GetBucketNum());
+	isRecentering = false;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ClearRecenteredEntries(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int noBuckets)
+{
+	int noTotalEntries = noBuckets + scene->index.GetExcessListSize();
+	if (recenteredEntries == NULL || recenteredEntries->dataSize != (size_t)noTotalEntries)
+	{
+		delete recenteredEntries;
+		delete recenteredExcessList;
+		delete recenteredBlockOccupancy;
+		delete recenteredEntryIDs;
+		recenteredEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, MEMORYDEVICE_CPU);
+		recenteredExcessList = new ORUtils::MemoryBlock<int>(scene->index.GetExcessListSize(), MEMORYDEVICE_CPU);
+		recenteredBlockOccupancy = scene->index.GetBlockOccupancy() != NULL ?
+			new ORUtils::MemoryBlock<int>(SDF_OCCUPANCY_LEVEL_NUM * (scene->index.GetBlockOccupancyMask() + 1), MEMORYDEVICE_CPU) : NULL;
+		// indexed by the addresses in the current table
+		recenteredEntryIDs = new ORUtils::MemoryBlock<int>(MAX(noTotalEntries, scene->index.noTotalEntries), MEMORYDEVICE_CPU);
+	}
+
+	ITMHashEntry tmpEntry;
+	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
+	tmpEntry.ptr = -2;
+	ITMHashEntry *recenteredTable = recenteredEntries->GetData(MEMORYDEVICE_CPU);
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int i = 0; i < noTotalEntries; ++i) recenteredTable[i] = tmpEntry;
+}
+
+/** Reads the SDF values and depth weights of the block row of SDF_BLOCK_SIZE
+    voxels that starts at @p rowAddress.
+*/
+template<class TVoxel>
+static inline void loadVoxelRow(float *sdf, int *w_depth, const TVoxel *voxelData, int rowAddress)
+{
+	const TVoxel *voxelRow = voxelData + rowAddress;
+	for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		sdf[x] = TVoxel::SDF_valueToFloat(voxelRow[x].sdf);
+		w_depth[x] = voxelRow[x].w_depth;
+	}
+}
+
+template<class TVoxel>
+static inline void loadVoxelRow(float *sdf, int *w_depth, const ITMVoxel_SoA<TVoxel> *voxelData, int rowAddress)
+{
+	if (!ITMVoxel_SoA<TVoxel>::hasPlanes) { loadVoxelRow(sdf, w_depth, (const TVoxel*)voxelData, rowAddress); return; }
+
+	int linearIdx = (int)((uint)rowAddress % SDF_BLOCK_SIZE3);
+	ITMVoxelBlockPlanes_SoA<TVoxel> planes(voxelData, rowAddress - linearIdx);
+	for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		sdf[x] = TVoxel::SDF_valueToFloat(planes.sdf[linearIdx + x]);
+		w_depth[x] = planes.w_depth[linearIdx + x];
+	}
+}
+
+/** Writes back the voxels of a block row that are set in @p updateMask. */
+template<class TVoxel>
+static inline void storeVoxelRow(TVoxel *voxelData, int rowAddress, const float *sdf, const int *w_depth, int updateMask)
+{
+	TVoxel *voxelRow = voxelData + rowAddress;
+	for (int x = 0; x < SDF_BLOCK_SIZE; x++) if (updateMask & (1 << x))
+	{
+		voxelRow[x].sdf = TVoxel::SDF_floatToValue(sdf[x]);
+		voxelRow[x].w_depth = w_depth[x];
+	}
+}
+
+template<class TVoxel>
+static inline void storeVoxelRow(ITMVoxel_SoA<TVoxel> *voxelData, int rowAddress, const float *sdf, const int *w_depth, int updateMask)
+{
+	if (!ITMVoxel_SoA<TVoxel>::hasPlanes) { storeVoxelRow((TVoxel*)voxelData, rowAddress, sdf, w_depth, updateMask); return; }
+
+	int linearIdx = (int)((uint)rowAddress % SDF_BLOCK_SIZE3);
+	ITMVoxelBlockPlanes_SoA<TVoxel> planes(voxelData, rowAddress - linearIdx);
+	for (int x = 0; x < SDF_BLOCK_SIZE; x++) if (updateMask & (1 << x))
+	{
+		planes.sdf[linearIdx + x] = TVoxel::SDF_floatToValue(sdf[x]);
+		planes.w_depth[linearIdx + x] = w_depth[x];
+	}
+}
+
+/** Depth-only equivalent of ComputeUpdatedVoxelInfo for the SDF_BLOCK_SIZE
+    voxels of the block row that starts at @p rowAddress. The camera
+    coordinates of the row start at @p pt_camera and advance by
+    @p step_camera from voxel to voxel.
+*/
+template<class TVoxelData>
+static inline void integrateVoxelRow(TVoxelData *voxelData, int rowAddress, const Vector4f &pt_camera, const Vector4f &step_camera,
+	const Vector4f &projParams_d, float mu, int maxW, bool stopIntegratingAtMaxW, const float *depth, const Vector2i &imgSize)
+{
+	float oldF[SDF_BLOCK_SIZE], newF[SDF_BLOCK_SIZE];
+	int oldW[SDF_BLOCK_SIZE], newW[SDF_BLOCK_SIZE];
+	int updateMask = 0;
+
+	loadVoxelRow(oldF, oldW, voxelData, rowAddress);
+
+#if defined(__AVX2__) && (SDF_BLOCK_SIZE % 8 == 0)
+	for (int x = 0; x < SDF_BLOCK_SIZE; x += 8)
+	{
+		__m256 one = _mm256_set1_ps(1.0f), half = _mm256_set1_ps(0.5f);
+		__m256 lane = _mm256_add_ps(_mm256_set1_ps((float)x), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+
+		// project the voxel centres into the depth image
+		__m256 cam_x = _mm256_add_ps(_mm256_set1_ps(pt_camera.x), _mm256_mul_ps(lane, _mm256_set1_ps(step_camera.x)));
+		__m256 cam_y = _mm256_add_ps(_mm256_set1_ps(pt_camera.y), _mm256_mul_ps(lane, _mm256_set1_ps(step_camera.y)));
+		__m256 cam_z = _mm256_add_ps(_mm256_set1_ps(pt_camera.z), _mm256_mul_ps(lane, _mm256_set1_ps(step_camera.z)));
+		__m256 valid = _mm256_cmp_ps(cam_z, _mm256_setzero_ps(), _CMP_GT_OQ);
+
+		__m256 img_x = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(projParams_d.x), cam_x), cam_z), _mm256_set1_ps(projParams_d.z));
+		__m256 img_y = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_set1_ps(projParams_d.y), cam_y), cam_z), _mm256_set1_ps(projParams_d.w));
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_x, one, _CMP_GE_OQ));
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_x, _mm256_set1_ps((float)(imgSize.x - 2)), _CMP_LE_OQ));
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_y, one, _CMP_GE_OQ));
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(img_y, _mm256_set1_ps((float)(imgSize.y - 2)), _CMP_LE_OQ));
+
+		// gather the measured depth of the voxels that project into the image
+		__m256i depthIdx = _mm256_add_epi32(_mm256_cvttps_epi32(_mm256_add_ps(img_x, half)),
+			_mm256_mullo_epi32(_mm256_cvttps_epi32(_mm256_add_ps(img_y, half)), _mm256_set1_epi32(imgSize.x)));
+		__m256 depth_measure = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), depth, depthIdx, valid, 4);
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(depth_measure, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+		__m256 eta = _mm256_sub_ps(depth_measure, cam_z);
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(eta, _mm256_set1_ps(-mu), _CMP_GE_OQ));
+
+		// running average of the SDF value, weights saturate at maxW
+		__m256i oldW_i = _mm256_loadu_si256((const __m256i*)(oldW + x));
+		if (stopIntegratingAtMaxW) valid = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(oldW_i, _mm256_set1_epi32(maxW))), valid);
+
+		__m256 oldW_f = _mm256_cvtepi32_ps(oldW_i);
+		__m256 sample = _mm256_min_ps(one, _mm256_div_ps(eta, _mm256_set1_ps(mu)));
+		__m256 newF_v = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(oldW_f, _mm256_loadu_ps(oldF + x)), sample), _mm256_add_ps(oldW_f, one));
+
+		_mm256_storeu_ps(newF + x, newF_v);
+		_mm256_storeu_si256((__m256i*)(newW + x), _mm256_min_epi32(_mm256_add_epi32(oldW_i, _mm256_set1_epi32(1)), _mm256_set1_epi32(maxW)));
+		updateMask |= _mm256_movemask_ps(valid) << x;
+	}
+#else
+	for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+	{
+		float cam_x = pt_camera.x + x * step_camera.x;
+		float cam_y = pt_camera.y + x * step_camera.y;
+		float cam_z = pt_camera.z + x * step_camera.z;
+
+		float img_x = projParams_d.x * cam_x / cam_z + projParams_d.z;
+		float img_y = projParams_d.y * cam_y / cam_z + projParams_d.w;
+		bool valid = cam_z > 0 && img_x >= 1 && img_x <= imgSize.x - 2 && img_y >= 1 && img_y <= imgSize.y - 2;
+
+		float depth_measure = valid ? depth[(int)(img_x + 0.5f) + (int)(img_y + 0.5f) * imgSize.x] : -1.0f;
+		float eta = depth_measure - cam_z;
+		valid = valid && depth_measure > 0 && eta >= -mu;
+		if (stopIntegratingAtMaxW) valid = valid && oldW[x] != maxW;
+
+		newF[x] = (oldW[x] * oldF[x] + MIN(1.0f, eta / mu)) / (oldW[x] + 1);
+		newW[x] = MIN(oldW[x] + 1, maxW);
+		updateMask |= (int)valid << x;
+	}
+#endif
+
+	storeVoxelRow(voxelData, rowAddress, newF, newW, updateMask);
+}
+
+// The finest level of the depth tile pyramid stores the largest valid depth
+// of each tile of (1 << depthTileShift)^2 pixels, every coarser level the
+// largest depth of 2x2 tiles of the level below. Tiles without any valid
+// depth store 0.
+static const int depthTileShift = 3;
+static const int maxDepthTileLevels = 16;
+
+struct DepthTilePyramid
+{
+	int noLevels, noTiles;
+	Vector2i levelSize[maxDepthTileLevels];
+	int levelOffset[maxDepthTileLevels];
+
+	explicit DepthTilePyramid(const Vector2i &imgSize)
+	{
+		Vector2i size(((imgSize.x - 1) >> depthTileShift) + 1, ((imgSize.y - 1) >> depthTileShift) + 1);
+
+		noLevels = 0; noTiles = 0;
+		while (true)
+		{
+			levelSize[noLevels] = size;
+			levelOffset[noLevels] = noTiles;
+			noTiles += size.x * size.y;
+			noLevels++;
+
+			if ((size.x == 1 && size.y == 1) || noLevels == maxDepthTileLevels) break;
+			size.x = (size.x + 1) / 2; size.y = (size.y + 1) / 2;
+		}
+	}
+};
+
+static void buildDepthTilePyramid(float *depthTiles, const DepthTilePyramid &pyramid, const float *depth, const Vector2i &imgSize)
+{
+	const Vector2i &tilesSize = pyramid.levelSize[0];
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int tileId = 0; tileId < tilesSize.x * tilesSize.y; tileId++)
+	{
+		int tileX = tileId % tilesSize.x, tileY = tileId / tilesSize.x;
+		float maxDepth = 0.0f;
+
+		for (int y = tileY << depthTileShift; y < MIN((tileY + 1) << depthTileShift, imgSize.y); y++)
+			for (int x = tileX << depthTileShift; x < MIN((tileX + 1) << depthTileShift, imgSize.x); x++)
+			{
+				float depth_measure = depth[x + y * imgSize.x];
+				if (depth_measure > maxDepth) maxDepth = depth_measure;
+			}
+
+		depthTiles[tileId] = maxDepth;
+	}
+
+	for (int level = 1; level < pyramid.noLevels; level++)
+	{
+		const float *fineTiles = depthTiles + pyramid.levelOffset[level - 1];
+		float *coarseTiles = depthTiles + pyramid.levelOffset[level];
+		Vector2i fineSize = pyramid.levelSize[level - 1], coarseSize = pyramid.levelSize[level];
+
+		for (int tileY = 0; tileY < coarseSize.y; tileY++) for (int tileX = 0; tileX < coarseSize.x; tileX++)
+		{
+			float maxDepth = 0.0f;
+			for (int y = 2 * tileY; y < MIN(2 * tileY + 2, fineSize.y); y++) for (int x = 2 * tileX; x < MIN(2 * tileX + 2, fineSize.x); x++)
+				maxDepth = MAX(maxDepth, fineTiles[x + y * fineSize.x]);
+			coarseTiles[tileX + tileY * coarseSize.x] = maxDepth;
+		}
+	}
+}
+
+/** Largest valid depth in the pixel rectangle [x0, x1] x [y0, y1], read from
+    the coarsest pyramid level at which the rectangle covers at most 2x2 tiles.
+*/
+static inline float findMaxDepth(const float *depthTiles, const DepthTilePyramid &pyramid, int x0, int y0, int x1, int y1)
+{
+	x0 >>= depthTileShift; y0 >>= depthTileShift; x1 >>= depthTileShift; y1 >>= depthTileShift;
+
+	int level = 0;
+	while (level < pyramid.noLevels - 1 && (x1 - x0 > 1 || y1 - y0 > 1))
+	{
+		x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+		level++;
+	}
+
+	const float *levelTiles = depthTiles + pyramid.levelOffset[level];
+	int levelWidth = pyramid.levelSize[level].x;
+
+	float maxDepth = 0.0f;
+	for (int y = y0; y <= y1; y++) for (int x = x0; x <= x1; x++) maxDepth = MAX(maxDepth, levelTiles[x + y * levelWidth]);
+
+	return maxDepth;
+}
+
+/** Finds the range [zBegin, zEnd) of block slabs that the depth image can
+    update. A voxel is only updated if it projects onto a valid depth and lies
+    at most mu behind it, so slabs further than mu behind the largest depth in
+    the image footprint of the block are skipped. The footprint is the
+    bounding box of the projected block corners, grown by a pixel to cover
+    the rounding of the depth lookup.
+*/
+static inline void findUpdatedSlabs(int &zBegin, int &zEnd, const Vector4f &pt_block_camera, const Vector4f &stepX, const Vector4f &stepY,
+	const Vector4f &stepZ, const Vector4f &projParams_d, const Vector2i &imgSize, float mu, const float *depthTiles, const DepthTilePyramid &pyramid)
+{
+	const float blockExtent = (float)(SDF_BLOCK_SIZE - 1);
+
+	bool allInFront = true, allBehind = true;
+	float minX = imgSize.x, maxX = -1.0f, minY = imgSize.y, maxY = -1.0f;
+
+	zBegin = zEnd = 0;
+
+	for (int cornerId = 0; cornerId < 8; cornerId++)
+	{
+		Vector4f pt_corner = pt_block_camera;
+		if (cornerId & 1) pt_corner += stepX * blockExtent;
+		if (cornerId & 2) pt_corner += stepY * blockExtent;
+		if (cornerId & 4) pt_corner += stepZ * blockExtent;
+
+		if (pt_corner.z <= 0) { allInFront = false; continue; }
+		allBehind = false;
+
+		float pt_image_x = projParams_d.x * pt_corner.x / pt_corner.z + projParams_d.z;
+		float pt_image_y = projParams_d.y * pt_corner.y / pt_corner.z + projParams_d.w;
+		minX = MIN(minX, pt_image_x); maxX = MAX(maxX, pt_image_x);
+		minY = MIN(minY, pt_image_y); maxY = MAX(maxY, pt_image_y);
+	}
+
+	// the whole block is behind the camera
+	if (allBehind) return;
+
+	// only voxels projecting into [1, imgSize - 2] are updated
+	int x0 = 1, y0 = 1, x1 = imgSize.x - 2, y1 = imgSize.y - 2;
+	if (allInFront)
+	{
+		x0 = (int)MIN(MAX(minX, (float)x0), (float)imgSize.x); x1 = (int)MAX(MIN(maxX + 1.0f, (float)x1), 0.0f);
+		y0 = (int)MIN(MAX(minY, (float)y0), (float)imgSize.y); y1 = (int)MAX(MIN(maxY + 1.0f, (float)y1), 0.0f);
+		if (x0 > x1 || y0 > y1) return;
+	}
+
+	float maxDepth = findMaxDepth(depthTiles, pyramid, x0, y0, x1, y1);
+	if (maxDepth <= 0) return;
+
+	// small slack for the rounding differences between the integration paths
+	float maxUpdatedZ = maxDepth + mu * 1.01f;
+	float minSlabZ = pt_block_camera.z + MIN(0.0f, stepX.z * blockExtent) + MIN(0.0f, stepY.z * blockExtent);
+
+	zBegin = 0; zEnd = SDF_BLOCK_SIZE;
+	if (stepZ.z >= 0) { while (zEnd > 0 && minSlabZ + (zEnd - 1) * stepZ.z > maxUpdatedZ) zEnd--; }
+	else { while (zBegin < SDF_BLOCK_SIZE && minSlabZ + zBegin * stepZ.z > maxUpdatedZ) zBegin++; }
+}
+
+template<class TVoxel, class TIndex, class TVoxelData>
+static void IntegrateIntoScene_common(TVoxelData *voxelData, ITMScene<TVoxel, TIndex> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState, const float *depthTiles, const DepthTilePyramid &depthTilePyramid)
+{
+	Vector2i rgbImgSize = view->rgb->noDims;
+	Vector2i depthImgSize = view->depth->noDims;
+	float voxelSize = scene->sceneParams->voxelSize;
+
+	Matrix4f M_d, M_rgb;
+	Vector4f projParams_d, projParams_rgb;
+
+	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+
+	M_d = trackingState->pose_d->GetM();
+	if (TVoxel::hasColorInformation) M_rgb = view->calib->trafo_rgb_to_depth.calib_inv * M_d;
+
+	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
+	projParams_rgb = view->calib->intrinsics_rgb.projectionParamsSimple.all;
+
+	float mu = scene->sceneParams->mu; int maxW = MIN(scene->sceneParams->maxW, TVoxel::W_maxValue());
+
+	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
+	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
+	const typename TIndex::IndexData *hashTable = scene->index.getIndexData();
+
+	int *visibleEntryIds = renderState_vh->GetVisibleEntryIDs();
+	int noVisibleEntries = renderState_vh->noVisibleEntries;
+
+	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
+	//bool approximateIntegration = !trackingState->requiresFullRendering;
+
+	// the vectorised path only updates the depth information
+	bool useVectorisedIntegration = scene->sceneParams->useVectorisedIntegration && !TVoxel::hasColorInformation;
+	Vector4f stepX_d = M_d.getColumn(0) * voxelSize, stepY_d = M_d.getColumn(1) * voxelSize, stepZ_d = M_d.getColumn(2) * voxelSize;
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+	{
+		Vector3i globalPos;
+		ITMBlockPos blockPos; int blockPtr;
+		readBlockEntry(hashTable, visibleEntryIds[entryId], blockPos, blockPtr);
+
+		if (blockPtr < 0) continue;
+
+		globalPos = blockPos.toInt() * SDF_BLOCK_SIZE;
+
+		int blockAddress = blockPtr * SDF_BLOCK_SIZE3;
+
+		Vector4f pt_block;
+		pt_block.x = (float)globalPos.x * voxelSize;
+		pt_block.y = (float)globalPos.y * voxelSize;
+		pt_block.z = (float)globalPos.z * voxelSize;
+		pt_block.w = 1.0f;
+
+		// camera coordinates of the remaining voxels follow from the block origin
+		Vector4f pt_block_camera = M_d * pt_block;
+
+		int zBegin, zEnd;
+		findUpdatedSlabs(zBegin, zEnd, pt_block_camera, stepX_d, stepY_d, stepZ_d, projParams_d, depthImgSize, mu, depthTiles, depthTilePyramid);
+		if (zBegin >= zEnd) continue;
+
+		if (useVectorisedIntegration)
+		{
+			for (int z = zBegin; z < zEnd; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++)
+			{
+				Vector4f pt_row_camera = pt_block_camera + stepY_d * (float)y + stepZ_d * (float)z;
+				integrateVoxelRow(voxelData, blockAddress + (y + z * SDF_BLOCK_SIZE) * SDF_BLOCK_SIZE, pt_row_camera, stepX_d,
+					projParams_d, mu, maxW, stopIntegratingAtMaxW, depth, depthImgSize);
+			}
+
+			continue;
+		}
+
+		for (int z = zBegin; z < zEnd; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+		{
+			Vector4f pt_model; int locId;
+
+			locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+
+			TVoxel voxel = readVoxel(voxelData, blockAddress + locId);
+
+			if (stopIntegratingAtMaxW) if (voxel.w_depth == maxW) continue;
+			//if (approximateIntegration) if (voxel.w_depth != 0) continue;
+
+			pt_model.x = (float)(globalPos.x + x) * voxelSize;
+			pt_model.y = (float)(globalPos.y + y) * voxelSize;
+			pt_model.z = (float)(globalPos.z + z) * voxelSize;
+			pt_model.w = 1.0f;
+
+			ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(voxel, pt_model, M_d, 
+				projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, depthImgSize, rgb, rgbImgSize);
+
+			writeVoxel(voxelData, blockAddress + locId, voxel);
+		}
+	}
+}
+
+/** Integrates the depth image into the visible blocks, skipping the parts
+    of each block that are in front of or behind the truncation band
+    everywhere, as found with the depth tile pyramid in @p depthTiles.
+*/
+template<class TVoxel, class TIndex>
+static void integrateVisibleBlocks(ITMScene<TVoxel, TIndex> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+	const ITMRenderState *renderState, ORUtils::MemoryBlock<float> *&depthTiles)
+{
+	Vector2i depthImgSize = view->depth->noDims;
+
+	DepthTilePyramid depthTilePyramid(depthImgSize);
+	if (depthTiles == NULL || depthTiles->dataSize != (size_t)depthTilePyramid.noTiles)
+	{
+		delete depthTiles;
+		depthTiles = new ORUtils::MemoryBlock<float>(depthTilePyramid.noTiles, MEMORYDEVICE_CPU);
+	}
+
+	float *depthTiles_ptr = depthTiles->GetData(MEMORYDEVICE_CPU);
+	buildDepthTilePyramid(depthTiles_ptr, depthTilePyramid, view->depth->GetData(MEMORYDEVICE_CPU), depthImgSize);
+
+	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) IntegrateIntoScene_common((ITMVoxel_SoA<TVoxel>*)localVBA, scene, view, trackingState, renderState,
+		depthTiles_ptr, depthTilePyramid);
+	else IntegrateIntoScene_common(localVBA, scene, view, trackingState, renderState, depthTiles_ptr, depthTilePyramid);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+{
+	integrateVisibleBlocks(scene, view, trackingState, renderState, depthTiles);
+}
+
+// The parallel allocation passes split their input into this many contiguous
+// ranges. Each range is processed by a single thread and places its results
+// at an offset given by an exclusive prefix sum over the per-range counts, so
+// slots are claimed in the same order as in the serial passes.
+static const int noAllocationChunks = 256;
+
+static inline int exclusivePrefixSum(int *counts, int noCounts)
+{
+	int sum = 0;
+	for (int i = 0; i < noCounts; i++) { int count = counts[i]; counts[i] = sum; sum += count; }
+	return sum;
+}
+
+/** Counts the blocks and excess list entries that the allocation requests
+    in @p entriesAllocType ask for, and, if @p useSwapping is set, the
+    blocks of allocated entries that may be swapped back in. These are
+    upper bounds, some requests may not be granted.
+*/
+static void countAllocationRequests(int &noBlockRequests, int &noExcessRequests, const uchar *entriesAllocType, int noTotalEntries,
+	const ITMHashEntry *hashTable, const int *allocatedEntryIDs, int noAllocatedEntries, const uchar *entriesVisibleType, bool useSwapping)
+{
+	int blockCounts[noAllocationChunks], excessCounts[noAllocationChunks];
+	int chunkSize = (noTotalEntries + noAllocationChunks - 1) / noAllocationChunks;
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		int chunkEnd = MIN((chunkId + 1) * chunkSize, noTotalEntries);
+		int noRequests = 0, noExcess = 0;
+
+		for (int targetIdx = chunkId * chunkSize; targetIdx < chunkEnd;)
+		{
+			if (targetIdx + 8 <= chunkEnd)
+			{
+				unsigned long long allocTypes;
+				memcpy(&allocTypes, entriesAllocType + targetIdx, sizeof(allocTypes));
+				if (allocTypes == 0) { targetIdx += 8; continue; }
+			}
+
+			noRequests += entriesAllocType[targetIdx] > 0;
+			noExcess += entriesAllocType[targetIdx] == 2;
+			targetIdx++;
+		}
+
+		blockCounts[chunkId] = noRequests; excessCounts[chunkId] = noExcess;
+	}
+
+	noBlockRequests = exclusivePrefixSum(blockCounts, noAllocationChunks);
+	noExcessRequests = exclusivePrefixSum(excessCounts, noAllocationChunks);
+
+	if (useSwapping) for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		int targetIdx = allocatedEntryIDs[listIdx];
+		noBlockRequests += entriesVisibleType[targetIdx] > 0 && hashTable[targetIdx].ptr == -1;
+	}
+}
+
+static int allocateVoxelBlocksList_parallel(int *voxelAllocationList, int *excessAllocationList, ITMHashEntry *hashTable, int noBuckets, int noTotalEntries,
+	int &lastFreeVoxelBlockId, int &lastFreeExcessListId, int *allocatedEntryIDs, int &noAllocatedEntries, uchar *entriesAllocType,
+	uchar *entriesVisibleType, const ITMBlockCoords *blockCoords, int *allocationRequests)
+{
+	int vbaOffsets[noAllocationChunks], exlOffsets[noAllocationChunks], listOffsets[noAllocationChunks], noChunkRequests[noAllocationChunks];
+	int noExcessAllocated[noAllocationChunks];
+	int chunkSize = (noTotalEntries + noAllocationChunks - 1) / noAllocationChunks;
+
+	// list the requests of each range at its start in allocationRequests, this is the only pass over all entries
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		int chunkEnd = MIN((chunkId + 1) * chunkSize, noTotalEntries);
+		int *chunkRequests = allocationRequests + chunkId * chunkSize;
+		int noRequests = 0, noExcess = 0;
+
+		for (int targetIdx = chunkId * chunkSize; targetIdx < chunkEnd;)
+		{
+			// few entries request a block, so runs of eight without a request are skipped at once
+			if (targetIdx + 8 <= chunkEnd)
+			{
+				unsigned long long allocTypes;
+				memcpy(&allocTypes, entriesAllocType + targetIdx, sizeof(allocTypes));
+				if (allocTypes == 0) { targetIdx += 8; continue; }
+			}
+
+			unsigned char hashChangeType = entriesAllocType[targetIdx];
+			if (hashChangeType > 0) chunkRequests[noRequests++] = targetIdx;
+			noExcess += hashChangeType == 2;
+			targetIdx++;
+		}
+
+		noChunkRequests[chunkId] = noRequests;
+		vbaOffsets[chunkId] = noRequests - noExcess; exlOffsets[chunkId] = noExcess;
+	}
+
+	int noBlockRequests = exclusivePrefixSum(vbaOffsets, noAllocationChunks) + exclusivePrefixSum(exlOffsets, noAllocationChunks);
+	int noFreeBlocks = MAX(lastFreeVoxelBlockId + 1, 0), noFreeExcessEntries = MAX(lastFreeExcessListId + 1, 0);
+
+	// as in the serial pass a request only takes slots if it succeeds: all requests before a range succeed until the
+	// excess list runs out, after which only those of the ordered list do, until the voxel block array runs out
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		exlOffsets[chunkId] = MIN(exlOffsets[chunkId], noFreeExcessEntries);
+		vbaOffsets[chunkId] = MIN(vbaOffsets[chunkId] + exlOffsets[chunkId], noFreeBlocks);
+	}
+
+	// allocate, failed requests are cleared so the last pass can skip them
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		const int *chunkRequests = allocationRequests + chunkId * chunkSize;
+		int vbaIdx = lastFreeVoxelBlockId - vbaOffsets[chunkId];
+		int exlIdx = lastFreeExcessListId - exlOffsets[chunkId];
+		int noAllocated = 0, noExcess = 0;
+
+		for (int requestIdx = 0; requestIdx < noChunkRequests[chunkId]; requestIdx++)
+		{
+			int targetIdx = chunkRequests[requestIdx];
+			unsigned char hashChangeType = entriesAllocType[targetIdx];
+
+			if (vbaIdx >= 0 && (hashChangeType == 1 || exlIdx >= 0))
+			{
+				ITMBlockCoords pt_block_all = blockCoords[targetIdx];
+
+				ITMHashEntry hashEntry;
+				hashEntry.pos = ITMBlockPos(pt_block_all.x, pt_block_all.y, pt_block_all.z);
+				hashEntry.ptr = voxelAllocationList[vbaIdx];
+				hashEntry.offset = 0;
+
+				if (hashChangeType == 1) hashTable[targetIdx] = hashEntry;
+				else
+				{
+					int exlOffset = excessAllocationList[exlIdx];
+
+					hashTable[targetIdx].offset = exlOffset + 1; //connect to child
+					hashTable[noBuckets + exlOffset] = hashEntry; //add child to the excess list
+					entriesVisibleType[noBuckets + exlOffset] = 1; //make child visible and in memory
+					exlIdx--; noExcess++;
+				}
+
+				vbaIdx--; noAllocated++;
+			}
+			else
+			{
+				if (hashChangeType == 1) entriesVisibleType[targetIdx] = 0; //no block to allocate, the entry stays empty
+				entriesAllocType[targetIdx] = 0;
+			}
+		}
+
+		listOffsets[chunkId] = noAllocated; noExcessAllocated[chunkId] = noExcess;
+	}
+
+	int noNewEntries = exclusivePrefixSum(listOffsets, noAllocationChunks);
+	lastFreeVoxelBlockId -= noNewEntries;
+	lastFreeExcessListId -= exclusivePrefixSum(noExcessAllocated, noAllocationChunks);
+
+	// append the new entries to the allocated list in entry order
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		const int *chunkRequests = allocationRequests + chunkId * chunkSize;
+		int listIdx = noAllocatedEntries + listOffsets[chunkId];
+		for (int requestIdx = 0; requestIdx < noChunkRequests[chunkId]; requestIdx++)
+		{
+			int targetIdx = chunkRequests[requestIdx];
+			if (entriesAllocType[targetIdx] == 1) allocatedEntryIDs[listIdx++] = targetIdx;
+			else if (entriesAllocType[targetIdx] == 2) allocatedEntryIDs[listIdx++] = noBuckets + hashTable[targetIdx].offset - 1;
+		}
+	}
+
+	noAllocatedEntries += noNewEntries;
+
+	return noBlockRequests - noNewEntries;
+}
+
+// entries that turn visible in swap state 0 are to be swapped in, invisible ones in swap state 2 are to be swapped out
+static inline int swapQueueOf(uchar hashVisibleType, const ITMHashSwapState &swapState, bool isQueuedForSwapOut)
+{
+	if (hashVisibleType > 0) return swapState.state == 0 ? 1 : 0;
+	return swapState.state == 2 && !isQueuedForSwapOut ? 2 : 0;
+}
+
+template<bool useSwapping>
+static int buildVisibleList_parallel(const ITMHashEntry *hashTable, ITMHashSwapState *swapStates, const int *allocatedEntryIDs,
+	int noAllocatedEntries, int *visibleEntryIDs, int noMaxVisibleEntries, uchar *entriesVisibleType, int *swapInEntryIDs,
+	int &noSwapInEntries, int *swapOutEntryIDs, int &noSwapOutEntries, bool *isQueuedForSwapOut, const Matrix4f &M_d,
+	const Vector4f &projParams_d, const Vector2i &depthImgSize, float voxelSize)
+{
+	int visibleOffsets[noAllocationChunks], swapInOffsets[noAllocationChunks], swapOutOffsets[noAllocationChunks];
+	int chunkSize = (noAllocatedEntries + noAllocationChunks - 1) / noAllocationChunks;
+
+	// update the visibility of each entry and count the visible ones, and those to be swapped in and out
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		int noVisible = 0, noSwapIn = 0, noSwapOut = 0;
+		for (int listIdx = chunkId * chunkSize; listIdx < MIN((chunkId + 1) * chunkSize, noAllocatedEntries); listIdx++)
+		{
+			int targetIdx = allocatedEntryIDs[listIdx];
+			unsigned char hashVisibleType = entriesVisibleType[targetIdx];
+
+			if (hashVisibleType == 3)
+			{
+				bool isVisibleEnlarged, isVisible;
+				checkBlockVisibility<useSwapping>(isVisible, isVisibleEnlarged, hashTable[targetIdx].pos.toInt(), M_d, projParams_d, voxelSize, depthImgSize);
+				if (!(useSwapping ? isVisibleEnlarged : isVisible)) hashVisibleType = 0;
+				entriesVisibleType[targetIdx] = hashVisibleType;
+			}
+
+			if (useSwapping)
+			{
+				int swapQueue = swapQueueOf(hashVisibleType, swapStates[targetIdx], isQueuedForSwapOut[targetIdx]);
+				noSwapIn += swapQueue == 1;
+				noSwapOut += swapQueue == 2;
+			}
+
+			noVisible += hashVisibleType > 0;
+		}
+		visibleOffsets[chunkId] = noVisible;
+		swapInOffsets[chunkId] = noSwapIn;
+		swapOutOffsets[chunkId] = noSwapOut;
+	}
+
+	int noVisibleEntries = exclusivePrefixSum(visibleOffsets, noAllocationChunks);
+	int noNewSwapInEntries = exclusivePrefixSum(swapInOffsets, noAllocationChunks);
+	int noNewSwapOutEntries = exclusivePrefixSum(swapOutOffsets, noAllocationChunks);
+
+	// compact the visible entries, and append those to be swapped in and out to the queues
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		int visibleIdx = visibleOffsets[chunkId];
+		int swapInIdx = noSwapInEntries + swapInOffsets[chunkId], swapOutIdx = noSwapOutEntries + swapOutOffsets[chunkId];
+		for (int listIdx = chunkId * chunkSize; listIdx < MIN((chunkId + 1) * chunkSize, noAllocatedEntries); listIdx++)
+		{
+			int targetIdx = allocatedEntryIDs[listIdx];
+
+			if (useSwapping)
+			{
+				int swapQueue = swapQueueOf(entriesVisibleType[targetIdx], swapStates[targetIdx], isQueuedForSwapOut[targetIdx]);
+				if (swapQueue == 1)
+				{
+					swapStates[targetIdx].state = 1;
+					swapInEntryIDs[swapInIdx++] = targetIdx;
+				}
+				else if (swapQueue == 2)
+				{
+					isQueuedForSwapOut[targetIdx] = true;
+					swapOutEntryIDs[swapOutIdx++] = targetIdx;
+				}
+			}
+
+			if (entriesVisibleType[targetIdx] == 0) continue;
+			if (visibleIdx < noMaxVisibleEntries) visibleEntryIDs[visibleIdx] = targetIdx;
+			visibleIdx++;
+		}
+	}
+
+	noSwapInEntries += noNewSwapInEntries;
+	noSwapOutEntries += noNewSwapOutEntries;
+
+	return MIN(noVisibleEntries, noMaxVisibleEntries);
+}
+
+static int reAllocateSwappedOutVoxelBlocks_parallel(int *voxelAllocationList, ITMHashEntry *hashTable, int &lastFreeVoxelBlockId,
+	const int *allocatedEntryIDs, int noAllocatedEntries, const uchar *entriesVisibleType)
+{
+	int vbaOffsets[noAllocationChunks];
+	int chunkSize = (noAllocatedEntries + noAllocationChunks - 1) / noAllocationChunks;
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		int noBlocks = 0;
+		for (int listIdx = chunkId * chunkSize; listIdx < MIN((chunkId + 1) * chunkSize, noAllocatedEntries); listIdx++)
+		{
+			int targetIdx = allocatedEntryIDs[listIdx];
+			noBlocks += entriesVisibleType[targetIdx] > 0 && hashTable[targetIdx].ptr == -1;
+		}
+		vbaOffsets[chunkId] = noBlocks;
+	}
+
+	int noBlockRequests = exclusivePrefixSum(vbaOffsets, noAllocationChunks);
+
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int chunkId = 0; chunkId < noAllocationChunks; chunkId++)
+	{
+		int vbaIdx = lastFreeVoxelBlockId - vbaOffsets[chunkId];
+		for (int listIdx = chunkId * chunkSize; listIdx < MIN((chunkId + 1) * chunkSize, noAllocatedEntries); listIdx++)
+		{
+			int targetIdx = allocatedEntryIDs[listIdx];
+			if (entriesVisibleType[targetIdx] > 0 && hashTable[targetIdx].ptr == -1)
+			{
+				if (vbaIdx >= 0) hashTable[targetIdx].ptr = voxelAllocationList[vbaIdx];
+				vbaIdx--;
+			}
+		}
+	}
+
+	int noDroppedBlocks = MAX(noBlockRequests - MAX(lastFreeVoxelBlockId + 1, 0), 0);
+	lastFreeVoxelBlockId -= noBlockRequests;
+
+	return noDroppedBlocks;
+}
+
+/** Puts @p hashEntry into its bucket of @p hashTable, which has
+    @p noBuckets buckets, or, if that is taken, at the end of the chain of
+    the bucket in the excess list. Returns the address of the entry, or -1
+    if the excess list is full.
+*/
+static int insertHashEntry(ITMHashEntry *hashTable, int noBuckets, const int *excessAllocationList, int &lastFreeExcessListId,
+	const ITMHashEntry &hashEntry)
+{
+	int hashIdx = hashIndex(hashEntry.pos.toInt(), noBuckets - 1);
+	if (hashTable[hashIdx].ptr < -1)
+	{
+		hashTable[hashIdx] = hashEntry;
+		return hashIdx;
+	}
+	if (lastFreeExcessListId < 0) return -1;
+
+	while (hashTable[hashIdx].offset >= 1) hashIdx = noBuckets + hashTable[hashIdx].offset - 1;
+	int exlOffset = excessAllocationList[lastFreeExcessListId--];
+	hashTable[hashIdx].offset = exlOffset + 1;
+	hashTable[noBuckets + exlOffset] = hashEntry;
+	return noBuckets + exlOffset;
+}
+
+/** Size to which an array of @p size elements, of which @p noUsed are
+    or are about to be used, grows so that at most @p growthThreshold of it
+    is used. Returns @p size if that holds already.
+*/
+static inline int grownSize(int size, int noUsed, float growthThreshold, int initialSize)
+{
+	if (noUsed <= growthThreshold * size) return size;
+
+	// growing geometrically keeps the number of resizes, which copy the arrays, logarithmic in the final capacity
+	return MAX(size + MAX(initialSize, size / 2), (int)ceil(noUsed / growthThreshold));
+}
+
+template<class TVoxel>
+bool ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::RehashScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	ITMRenderState_VH *renderState_vh)
+{
+	int noBuckets = scene->index.GetBucketNum();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	if (noAllocatedEntries <= scene->sceneParams->growthThreshold * noBuckets) return false;
+
+	// the entries are moved with the machinery of RecenterScene, a move under way starts again in the new table
+	if (isRecentering) CancelRecentering(scene);
+	int newNoBuckets = 2 * noBuckets;
+	ClearRecenteredEntries(scene, newNoBuckets);
+
+	int noExcessEntries = scene->index.GetExcessListSize();
+	int *recenteredExcessList_ptr = recenteredExcessList->GetData(MEMORYDEVICE_CPU);
+	for (int exlIdx = 0; exlIdx < noExcessEntries; exlIdx++) recenteredExcessList_ptr[exlIdx] = exlIdx;
+	lastFreeRecenteredExcessId = noExcessEntries - 1;
+	// blocks keep their positions, so they keep their cells in the occupancy grid
+	if (recenteredBlockOccupancy != NULL)
+		memcpy(recenteredBlockOccupancy->GetData(MEMORYDEVICE_CPU), scene->index.GetBlockOccupancy(),
+			SDF_OCCUPANCY_LEVEL_NUM * (scene->index.GetBlockOccupancyMask() + 1) * sizeof(int));
+
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
+	const int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	ITMHashEntry *recenteredTable = recenteredEntries->GetData(MEMORYDEVICE_CPU);
+	int *newEntryIdOf = recenteredEntryIDs->GetData(MEMORYDEVICE_CPU);
+
+	// a bucket splits into two, whose chains together take no more excess list entries than the old one did
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		ITMHashEntry hashEntry = hashTable[allocatedEntryIDs[listIdx]];
+		hashEntry.offset = 0;
+		newEntryIdOf[allocatedEntryIDs[listIdx]] = insertHashEntry(recenteredTable, newNoBuckets, recenteredExcessList_ptr,
+			lastFreeRecenteredExcessId, hashEntry);
+	}
+	noRecenteredEntries = noAllocatedEntries;
+
+	SwapInRecenteredEntries(scene, renderState_vh, newNoBuckets);
+
+	entriesAllocType->Resize(scene->index.noTotalEntries);
+	blockCoords->Resize(scene->index.noTotalEntries);
+	allocationRequests->Resize(scene->index.noTotalEntries);
+
+	// the old table is kept for the next move of the origin only if there is going to be one
+	if (scene->sceneParams->recenteringDistance > 0.0f) ClearRecenteredEntries(scene, newNoBuckets);
+	else
+	{
+		delete recenteredEntries; recenteredEntries = NULL;
+		delete recenteredExcessList; recenteredExcessList = NULL;
+		delete recenteredBlockOccupancy; recenteredBlockOccupancy = NULL;
+		delete recenteredEntryIDs; recenteredEntryIDs = NULL;
+	}
+
+	return true;
+}
+
+template<class TVoxel>
+bool ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::GrowScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	int noBlockRequests, int noExcessRequests)
+{
+	float growthThreshold = scene->sceneParams->growthThreshold;
+	int noBuckets = scene->index.GetBucketNum();
+	int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
+	int noExcessEntries = scene->index.GetExcessListSize();
+	int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
+	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+
+	int newNoLocalBlocks = grownSize(noLocalBlocks, noLocalBlocks - (lastFreeVoxelBlockId + 1) + noBlockRequests, growthThreshold,
+		scene->sceneParams->noLocalBlocks);
+	int newNoExcessEntries = grownSize(noExcessEntries, noExcessEntries - (lastFreeExcessListId + 1) + noExcessRequests, growthThreshold,
+		scene->sceneParams->noExcessEntries);
+
+	if (newNoLocalBlocks == noLocalBlocks && newNoExcessEntries == noExcessEntries) return false;
+
+	// the buckets stay as they are, so entry IDs and block pointers remain valid
+	int occupancyMask = scene->index.GetBlockOccupancyMask();
+	scene->index.Resize(newNoExcessEntries, newNoLocalBlocks);
+	scene->localVBA.Resize(newNoLocalBlocks, scene->index.getVoxelBlockSize());
+	if (scene->useSwapping) scene->globalCache->Resize(scene->index.noTotalEntries);
+
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	for (int vbaIdx = noLocalBlocks; vbaIdx < newNoLocalBlocks; vbaIdx++) voxelAllocationList[++lastFreeVoxelBlockId] = vbaIdx;
+
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	if (blockNeighbours != NULL)
+	{
+		for (int i = noLocalBlocks * SDF_BLOCK_NEIGHBOUR_NUM; i < newNoLocalBlocks * SDF_BLOCK_NEIGHBOUR_NUM; i++) blockNeighbours[i] = -1;
+	}
+	if (scene->index.GetBlockOccupancyMask() != occupancyMask) recountBlockOccupancy(scene);
+
+	ITMHashEntry tmpEntry;
+	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
+	tmpEntry.ptr = -2;
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	int *excessAllocationList = scene->index.GetExcessAllocationList();
+	for (int exlIdx = noExcessEntries; exlIdx < newNoExcessEntries; exlIdx++)
+	{
+		hashTable[noBuckets + exlIdx] = tmpEntry;
+		excessAllocationList[++lastFreeExcessListId] = exlIdx;
+	}
+
+	scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
+	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+
+	entriesAllocType->Resize(scene->index.noTotalEntries);
+	blockCoords->Resize(scene->index.noTotalEntries);
+	allocationRequests->Resize(scene->index.noTotalEntries);
+
+	// a move of the origin under way goes on with the new excess list entries, unless its blocks were counted in a grid of the old size
+	if (recenteredEntries != NULL)
+	{
+		if (scene->index.GetBlockOccupancyMask() != occupancyMask)
+		{
+			if (isRecentering) CancelRecentering(scene);
+			if (recenteredBlockOccupancy != NULL) recenteredBlockOccupancy->Resize(SDF_OCCUPANCY_LEVEL_NUM * (scene->index.GetBlockOccupancyMask() + 1));
+		}
+
+		recenteredEntries->Resize(scene->index.noTotalEntries);
+		recenteredExcessList->Resize(newNoExcessEntries);
+		recenteredEntryIDs->Resize(scene->index.noTotalEntries);
+
+		ITMHashEntry *recenteredTable = recenteredEntries->GetData(MEMORYDEVICE_CPU);
+		int *recenteredExcessList_ptr = recenteredExcessList->GetData(MEMORYDEVICE_CPU);
+		for (int exlIdx = noExcessEntries; exlIdx < newNoExcessEntries; exlIdx++)
+		{
+			recenteredTable[noBuckets + exlIdx] = tmpEntry;
+			recenteredExcessList_ptr[++lastFreeRecenteredExcessId] = exlIdx;
+		}
+	}
+
+	return true;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool onlyUpdateVisibleList)
+{
+	Vector2i depthImgSize = view->depth->noDims;
+	float voxelSize = scene->sceneParams->voxelSize;
+
+	Matrix4f M_d, invM_d;
+	Vector4f projParams_d, invProjParams_d;
+
+	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+
+	bool isGrowing = scene->sceneParams->growthThreshold > 0.0f && !onlyUpdateVisibleList;
+	if (isGrowing) this->RehashScene(scene, renderState_vh);
+	renderState_vh->Resize(scene->index.noTotalEntries, scene->index.getNumAllocatedVoxelBlocks());
+
+	M_d = trackingState->pose_d->GetM(); M_d.inv(invM_d);
+
+	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
+	invProjParams_d = projParams_d;
+	invProjParams_d.x = 1.0f / invProjParams_d.x;
+	invProjParams_d.y = 1.0f / invProjParams_d.y;
+
+	float mu = scene->sceneParams->mu;
+
+	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int *excessAllocationList = scene->index.GetExcessAllocationList();
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(false) : 0;
+	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
+	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
+	uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
+	ITMBlockCoords *blockCoords = this->blockCoords->GetData(MEMORYDEVICE_CPU);
+	int noBuckets = scene->index.GetBucketNum();
+	int noTotalEntries = scene->index.noTotalEntries;
+	int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
+
+	bool useSwapping = scene->useSwapping;
+	bool useParallelAllocation = scene->sceneParams->useParallelAllocation;
+
+	float oneOverVoxelSize = 1.0f / (voxelSize * SDF_BLOCK_SIZE);
+
+	int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
+	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+	int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+
+	ITMGlobalCache<TVoxel> *globalCache = scene->useSwapping ? scene->globalCache : NULL;
+	int *swapInEntryIDs = scene->useSwapping ? globalCache->GetSwapInEntryIDs() : NULL;
+	int *swapOutEntryIDs = scene->useSwapping ? globalCache->GetSwapOutEntryIDs() : NULL;
+	bool *isQueuedForSwapOut = scene->useSwapping ? globalCache->GetIsQueuedForSwapOut() : NULL;
+	int noSwapInEntries = scene->useSwapping ? globalCache->GetNoSwapInEntries() : 0;
+	int noSwapOutEntries = scene->useSwapping ? globalCache->GetNoSwapOutEntries() : 0;
+
+	int noVisibleEntries = 0, noDroppedBlocks = 0;
+
+	memset(entriesAllocType, 0, noTotalEntries);
+
+	for (int i = 0; i < renderState_vh->noVisibleEntries; i++)
+		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame and unstreamed
+
+	//build hashVisibility
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
+	{
+		int y = locId / depthImgSize.x;
+		int x = locId - y * depthImgSize.x;
+		buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
+			invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable, noBuckets - 1, scene->sceneParams->viewFrustum_min,
+			scene->sceneParams->viewFrustum_max);
+	}
+
+	if (onlyUpdateVisibleList) useSwapping = false;
+
+	// the arrays grow before any block is handed out, so that the requests of this frame are not dropped
+	if (isGrowing)
+	{
+		int noBlockRequests, noExcessRequests;
+		countAllocationRequests(noBlockRequests, noExcessRequests, entriesAllocType, noTotalEntries, hashTable, allocatedEntryIDs,
+			noAllocatedEntries, entriesVisibleType, useSwapping);
+
+		if (this->GrowScene(scene, noBlockRequests, noExcessRequests))
+		{
+			// the entries and blocks keep their addresses, but the arrays holding them have moved
+			renderState_vh->Resize(scene->index.noTotalEntries, scene->index.getNumAllocatedVoxelBlocks());
+			voxelAllocationList = scene->localVBA.GetAllocationList();
+			excessAllocationList = scene->index.GetExcessAllocationList();
+			hashTable = scene->index.GetEntries();
+			visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
+			entriesVisibleType = renderState_vh->GetEntriesVisibleType();
+			entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
+			blockCoords = this->blockCoords->GetData(MEMORYDEVICE_CPU);
+			noTotalEntries = scene->index.noTotalEntries;
+			noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
+			lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
+			lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+			allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+			if (useSwapping)
+			{
+				swapStates = globalCache->GetSwapStates(false);
+				swapInEntryIDs = globalCache->GetSwapInEntryIDs();
+				swapOutEntryIDs = globalCache->GetSwapOutEntryIDs();
+				isQueuedForSwapOut = globalCache->GetIsQueuedForSwapOut();
+			}
+		}
+	}
+
+	if (!onlyUpdateVisibleList && useParallelAllocation)
+	{
+		noDroppedBlocks += allocateVoxelBlocksList_parallel(voxelAllocationList, excessAllocationList, hashTable, noBuckets, noTotalEntries, lastFreeVoxelBlockId,
+			lastFreeExcessListId, allocatedEntryIDs, noAllocatedEntries, entriesAllocType, entriesVisibleType, blockCoords,
+			this->allocationRequests->GetData(MEMORYDEVICE_CPU));
+	}
+	else if (!onlyUpdateVisibleList)
+	{
+		//allocate
+		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+		{
+			int vbaIdx, exlIdx;
+			unsigned char hashChangeType = entriesAllocType[targetIdx];
+
+			switch (hashChangeType)
+			{
+			case 1: //needs allocation, fits in the ordered list
+				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
+
+				if (vbaIdx >= 0) //there is room in the voxel block array
+				{
+					ITMBlockCoords pt_block_all = blockCoords[targetIdx];
+
+					ITMHashEntry hashEntry;
+					hashEntry.pos = ITMBlockPos(pt_block_all.x, pt_block_all.y, pt_block_all.z);
+					hashEntry.ptr = voxelAllocationList[vbaIdx];
+					hashEntry.offset = 0;
+
+					hashTable[targetIdx] = hashEntry;
+					allocatedEntryIDs[noAllocatedEntries++] = targetIdx;
+				}
+				else
+				{
+					entriesVisibleType[targetIdx] = 0; //no block to allocate, the entry stays empty
+					noDroppedBlocks++;
+				}
+
+				break;
+			case 2: //needs allocation in the excess list
+				// slots are only taken together, a failed request must not use up a slot of the other list
+				if (lastFreeVoxelBlockId >= 0 && lastFreeExcessListId >= 0) //there is room in the voxel block array and excess list
+				{
+					vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
+					exlIdx = lastFreeExcessListId; lastFreeExcessListId--;
+
+					ITMBlockCoords pt_block_all = blockCoords[targetIdx];
+
+					ITMHashEntry hashEntry;
+					hashEntry.pos = ITMBlockPos(pt_block_all.x, pt_block_all.y, pt_block_all.z);
+					hashEntry.ptr = voxelAllocationList[vbaIdx];
+					hashEntry.offset = 0;
+
+					int exlOffset = excessAllocationList[exlIdx];
+
+					hashTable[targetIdx].offset = exlOffset + 1; //connect to child
+
+					hashTable[noBuckets + exlOffset] = hashEntry; //add child to the excess list
+
+					entriesVisibleType[noBuckets + exlOffset] = 1; //make child visible and in memory
+					allocatedEntryIDs[noAllocatedEntries++] = noBuckets + exlOffset;
+				}
+				else noDroppedBlocks++;
+
+				break;
+			}
+		}
+	}
+
+	//build visible list, only entries present in the hash table can be visible
+	if (useParallelAllocation)
+	{
+		if (useSwapping)
+			noVisibleEntries = buildVisibleList_parallel<true>(hashTable, swapStates, allocatedEntryIDs, noAllocatedEntries, visibleEntryIDs,
+				noLocalBlocks, entriesVisibleType, swapInEntryIDs, noSwapInEntries, swapOutEntryIDs, noSwapOutEntries, isQueuedForSwapOut,
+				M_d, projParams_d, depthImgSize, voxelSize);
+		else
+			noVisibleEntries = buildVisibleList_parallel<false>(hashTable, swapStates, allocatedEntryIDs, noAllocatedEntries, visibleEntryIDs,
+				noLocalBlocks, entriesVisibleType, swapInEntryIDs, noSwapInEntries, swapOutEntryIDs, noSwapOutEntries, isQueuedForSwapOut,
+				M_d, projParams_d, depthImgSize, voxelSize);
+	}
+	else for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		int targetIdx = allocatedEntryIDs[listIdx];
+		unsigned char hashVisibleType = entriesVisibleType[targetIdx];
+		const ITMHashEntry &hashEntry = hashTable[targetIdx];
+		
+		if (hashVisibleType == 3)
+		{
+			bool isVisibleEnlarged, isVisible;
+
+			if (useSwapping)
+			{
+				checkBlockVisibility<true>(isVisible, isVisibleEnlarged, hashEntry.pos.toInt(), M_d, projParams_d, voxelSize, depthImgSize);
+				if (!isVisibleEnlarged) hashVisibleType = 0;
+			} else {
+				checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos.toInt(), M_d, projParams_d, voxelSize, depthImgSize);
+				if (!isVisible) { hashVisibleType = 0; }
+			}
+			entriesVisibleType[targetIdx] = hashVisibleType;
+		}
+
+		if (useSwapping)
+		{
+			int swapQueue = swapQueueOf(hashVisibleType, swapStates[targetIdx], isQueuedForSwapOut[targetIdx]);
+			if (swapQueue == 1)
+			{
+				swapStates[targetIdx].state = 1;
+				swapInEntryIDs[noSwapInEntries++] = targetIdx;
+			}
+			else if (swapQueue == 2)
+			{
+				isQueuedForSwapOut[targetIdx] = true;
+				swapOutEntryIDs[noSwapOutEntries++] = targetIdx;
+			}
+		}
+
+		if (hashVisibleType > 0 && noVisibleEntries < noLocalBlocks)
+		{	
+			visibleEntryIDs[noVisibleEntries] = targetIdx;
+			noVisibleEntries++;
+		}
+
+#if 0
+		// "active list", currently disabled
+		if (hashVisibleType == 1)
+		{
+			activeEntryIDs[noActiveEntries] = targetIdx;
+			noActiveEntries++;
+		}
+#endif
+	}
+
+	//reallocate deleted ones from previous swap operation
+	if (useSwapping && useParallelAllocation)
+	{
+		noDroppedBlocks += reAllocateSwappedOutVoxelBlocks_parallel(voxelAllocationList, hashTable, lastFreeVoxelBlockId, allocatedEntryIDs,
+			noAllocatedEntries, entriesVisibleType);
+	}
+	else if (useSwapping)
+	{
+		for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+		{
+			int targetIdx = allocatedEntryIDs[listIdx];
+			int vbaIdx;
+			ITMHashEntry hashEntry = hashTable[targetIdx];
+
+			if (entriesVisibleType[targetIdx] > 0 && hashEntry.ptr == -1) 
+			{
+				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
+				if (vbaIdx >= 0) hashTable[targetIdx].ptr = voxelAllocationList[vbaIdx];
+				else noDroppedBlocks++;
+			}
+		}
+	}
+
+	renderState_vh->noVisibleEntries = noVisibleEntries;
+	if (useSwapping)
+	{
+		globalCache->SetNoSwapInEntries(noSwapInEntries);
+		globalCache->SetNoSwapOutEntries(noSwapOutEntries);
+	}
+
+	// counters run past -1 when the voxel block array or excess list is exhausted
+	int oldLastFreeBlockId = scene->localVBA.lastFreeBlockId;
+	scene->localVBA.lastFreeBlockId = MAX(lastFreeVoxelBlockId, -1);
+	scene->index.SetLastFreeExcessListId(MAX(lastFreeExcessListId, -1));
+	scene->index.SetNoAllocatedEntries(noAllocatedEntries);
+	if (!onlyUpdateVisibleList) scene->index.SetNoDroppedBlocks(noDroppedBlocks);
+
+	this->ClearHandedOutBlocks(scene, oldLastFreeBlockId);
+	this->LinkHandedOutBlocks(scene, oldLastFreeBlockId);
+}
+
+/** A block holds no surface if none of its voxels has both a weight and an
+    SDF value below the truncation value.
+*/
+template<class TVoxel, class TVoxelData>
+static bool isEmptyVoxelBlock(const TVoxelData *voxelData, int blockPtr)
+{
+	int blockAddress = blockPtr * SDF_BLOCK_SIZE3;
+	for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++)
+	{
+		TVoxel voxel = readVoxel(voxelData, blockAddress + locId);
+		if (voxel.w_depth > 0 && TVoxel::SDF_valueToFloat(voxel.sdf) < 1.0f) return false;
+	}
+	return true;
+}
+
+template<class TVoxel, class TVoxelData>
+static void flagEmptyVoxelBlocks(uchar *entriesGarbageType, const TVoxelData *voxelData, const ITMHashEntry *hashTable,
+	const ITMHashSwapState *swapStates, const int *allocatedEntryIDs, int noAllocatedEntries, int firstListIdx, int noCandidates,
+	const uchar *entriesVisibleType)
+{
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int candidateId = 0; candidateId < noCandidates; candidateId++)
+	{
+		int targetIdx = allocatedEntryIDs[(firstListIdx + candidateId) % noAllocatedEntries];
+		int blockPtr = hashTable[targetIdx].ptr;
+
+		// visible blocks are referenced by the visible list, blocks waiting to be combined with their swapped in data may get a surface
+		if (blockPtr < 0 || entriesVisibleType[targetIdx] > 0) continue;
+		if (swapStates != NULL && swapStates[targetIdx].state == 1) continue;
+
+		if (isEmptyVoxelBlock<TVoxel>(voxelData, blockPtr)) entriesGarbageType[targetIdx] = 1;
+	}
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::CollectGarbage(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	const ITMRenderState *renderState)
+{
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	int *excessAllocationList = scene->index.GetExcessAllocationList();
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	const uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
+	ITMGlobalCache<TVoxel> *globalCache = scene->useSwapping ? scene->globalCache : NULL;
+	ITMHashSwapState *swapStates = scene->useSwapping ? globalCache->GetSwapStates(false) : NULL;
+	TVoxel *voxelBlocks = scene->localVBA.GetVoxelBlocks();
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	int *blockOccupancy = scene->index.GetBlockOccupancy(), occupancyMask = scene->index.GetBlockOccupancyMask();
+	int noBuckets = scene->index.GetBucketNum();
+
+	int noCandidates = MIN(scene->sceneParams->garbageCollectionBudget, noAllocatedEntries);
+	if (noCandidates <= 0 || isRecentering) return;
+	if (garbageCollectionCursor >= noAllocatedEntries) garbageCollectionCursor = 0;
+
+	// entriesAllocType is rebuilt by every allocation, until then it marks 1 - no surface, 2 - entry freed
+	uchar *entriesGarbageType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
+	memset(entriesGarbageType, 0, scene->index.noTotalEntries);
+
+	if (scene->sceneParams->useSoAVoxelBlocks)
+		flagEmptyVoxelBlocks<TVoxel>(entriesGarbageType, (const ITMVoxel_SoA<TVoxel>*)voxelBlocks, hashTable, swapStates, allocatedEntryIDs,
+			noAllocatedEntries, garbageCollectionCursor, noCandidates, entriesVisibleType);
+	else flagEmptyVoxelBlocks<TVoxel>(entriesGarbageType, voxelBlocks, hashTable, swapStates, allocatedEntryIDs,
+		noAllocatedEntries, garbageCollectionCursor, noCandidates, entriesVisibleType);
+
+	ITMHashEntry emptyEntry;
+	memset(&emptyEntry, 0, sizeof(ITMHashEntry));
+	emptyEntry.ptr = -2;
+
+	int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
+	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+
+	// remove the entries, the hash table is changed in place so this pass is serial
+	for (int candidateId = 0; candidateId < noCandidates; candidateId++)
+	{
+		int targetIdx = allocatedEntryIDs[(garbageCollectionCursor + candidateId) % noAllocatedEntries];
+		if (entriesGarbageType[targetIdx] != 1) continue;
+
+		ITMHashEntry hashEntry = hashTable[targetIdx];
+		int freedIdx = targetIdx;
+
+		if (targetIdx >= noBuckets)
+		{
+			// excess list entry: link its predecessor to its successor
+			int prevIdx = hashIndex(hashEntry.pos.toInt(), noBuckets - 1);
+			while (hashTable[prevIdx].offset >= 1 && noBuckets + hashTable[prevIdx].offset - 1 != targetIdx)
+				prevIdx = noBuckets + hashTable[prevIdx].offset - 1;
+			hashTable[prevIdx].offset = hashEntry.offset;
+			hashTable[targetIdx] = emptyEntry;
+		}
+		else if (hashEntry.offset >= 1)
+		{
+			// bucket entry with a chain: move the first excess list entry into the bucket
+			int childIdx = noBuckets + hashEntry.offset - 1;
+			if (entriesVisibleType[childIdx] > 0) continue;
+			if (swapStates != NULL && swapStates[childIdx].state == 1) continue;
+
+			hashTable[targetIdx] = hashTable[childIdx];
+			hashTable[childIdx] = emptyEntry;
+
+			if (globalCache != NULL)
+			{
+				swapStates[targetIdx] = swapStates[childIdx];
+				globalCache->MoveStoredData(childIdx, targetIdx);
+			}
+
+			freedIdx = childIdx;
+		}
+		else hashTable[targetIdx] = emptyEntry;
+
+		if (freedIdx >= noBuckets) excessAllocationList[++lastFreeExcessListId] = freedIdx - noBuckets;
+		if (globalCache != NULL)
+		{
+			swapStates[freedIdx].state = 0;
+			globalCache->ClearStoredData(freedIdx);
+		}
+
+		if (blockNeighbours != NULL)
+		{
+			unlinkBlockNeighbours(blockNeighbours, hashEntry.ptr);
+			updateBlockOccupancy(blockOccupancy, occupancyMask, hashEntry.pos.toInt(), -1);
+		}
+		voxelAllocationList[++lastFreeVoxelBlockId] = hashEntry.ptr;
+		entriesGarbageType[freedIdx] = 2;
+	}
+
+	// compact the allocated entry list, keeping the cursor behind the blocks looked at
+	int endListIdx = (garbageCollectionCursor + noCandidates) % noAllocatedEntries;
+	int noKeptEntries = 0, nextCursor = 0;
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		if (listIdx == endListIdx) nextCursor = noKeptEntries;
+		int targetIdx = allocatedEntryIDs[listIdx];
+		if (entriesGarbageType[targetIdx] != 2) allocatedEntryIDs[noKeptEntries++] = targetIdx;
+	}
+
+	garbageCollectionCursor = nextCursor;
+
+	scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
+	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+	scene->index.SetNoAllocatedEntries(noKeptEntries);
+}
+
+/** Interleaves the bits of the block position, offset to be non-negative,
+    so that sorting by the code visits the blocks along a Z-order curve.
+*/
+static inline unsigned long long mortonCode(const ITMBlockPos &blockPos)
+{
+	const unsigned int posOffset = 1u << (SDF_BLOCK_POS_BITS - 1), posMask = (1u << SDF_BLOCK_POS_BITS) - 1;
+
+	unsigned long long code = 0;
+	Vector3i pos = blockPos.toInt();
+	unsigned int x = ((unsigned int)pos.x + posOffset) & posMask, y = ((unsigned int)pos.y + posOffset) & posMask,
+		z = ((unsigned int)pos.z + posOffset) & posMask;
+	for (int bit = 0; bit < SDF_BLOCK_POS_BITS; bit++)
+	{
+		code |= (unsigned long long)((x >> bit) & 1) << (3 * bit);
+		code |= (unsigned long long)((y >> bit) & 1) << (3 * bit + 1);
+		code |= (unsigned long long)((z >> bit) & 1) << (3 * bit + 2);
+	}
+	return code;
+}
+
+static inline void writeBlockPtr(ITMHashEntry *hashTable, int entryId, int blockPtr) { hashTable[entryId].ptr = blockPtr; }
+
+static inline void writeBlockPtr(ITMOpenHashBucket *buckets, int entryId, int blockPtr)
+{
+	buckets[entryId / SDF_OPEN_HASH_SLOT_NUM].ptr[entryId % SDF_OPEN_HASH_SLOT_NUM] = blockPtr;
+}
+
+static inline void writeBlockPtr(ITMOctreeNode *nodes, int entryId, int blockPtr) { nodes[entryId / 8].child[entryId % 8] = blockPtr; }
+
+/** Moves the voxel blocks of all entries in the allocated entry list that
+    are in the local voxel block array to the front of the array, in the
+    Morton order of their positions, and points their entries to the new
+    locations. Blocks are moved in place along the chains and cycles of the
+    permutation. The allocated entry list is sorted the same way, so that
+    the visible lists built from it walk the array front to back, and the
+    allocation list hands out the blocks right behind the sorted ones next.
+    Returns false if the scene is left as it is.
+*/
+template<class TVoxel, class TIndex>
+static bool defragmentVoxelBlocks(ITMScene<TVoxel, TIndex> *scene)
+{
+	typename TIndex::IndexData *indexData = scene->index.getIndexData();
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
+	TVoxel *voxelBlocks = scene->localVBA.GetVoxelBlocks();
+
+	// sort the entries with a voxel block by their Morton code, entries swapped out are kept behind them
+	std::vector<std::pair<unsigned long long, int> > sortedEntries;
+	std::vector<int> swappedOutEntries;
+	sortedEntries.reserve(noAllocatedEntries);
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		ITMBlockPos blockPos; int blockPtr;
+		readBlockEntry(indexData, allocatedEntryIDs[listIdx], blockPos, blockPtr);
+		if (blockPtr >= 0) sortedEntries.push_back(std::make_pair(mortonCode(blockPos), allocatedEntryIDs[listIdx]));
+		else swappedOutEntries.push_back(allocatedEntryIDs[listIdx]);
+	}
+
+	int noBlocks = (int)sortedEntries.size();
+	if (noBlocks + scene->localVBA.lastFreeBlockId + 1 != noLocalBlocks)
+	{
+		printf("Error: The voxel block array holds blocks not referenced by the index, it is not defragmented!\n");
+		return false;
+	}
+
+	std::sort(sortedEntries.begin(), sortedEntries.end());
+
+	// sourcePtr[blockPtr] is the block that moves to blockPtr, blockEntry[blockPtr] the entry of the block now at blockPtr
+	std::vector<int> sourcePtr(noBlocks), blockEntry(noLocalBlocks, -1);
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		ITMBlockPos blockPos; int blockPtr;
+		readBlockEntry(indexData, sortedEntries[blockIdx].second, blockPos, blockPtr);
+		sourcePtr[blockIdx] = blockPtr;
+		blockEntry[blockPtr] = sortedEntries[blockIdx].second;
+	}
+
+	const size_t blockBytes = SDF_BLOCK_SIZE3 * sizeof(TVoxel);
+	std::vector<uchar> moved(noBlocks, 0);
+
+	// chains end at a free block inside the sorted range and start outside of it, fill them from the free end
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		if (blockEntry[blockIdx] >= 0) continue;
+
+		for (int targetPtr = blockIdx; targetPtr < noBlocks; targetPtr = sourcePtr[targetPtr])
+		{
+			memcpy(voxelBlocks + targetPtr * SDF_BLOCK_SIZE3, voxelBlocks + sourcePtr[targetPtr] * SDF_BLOCK_SIZE3, blockBytes);
+			moved[targetPtr] = 1;
+		}
+	}
+
+	// the remaining blocks form cycles inside the sorted range, rotate them through a spare block
+	std::vector<TVoxel> spareBlock(SDF_BLOCK_SIZE3);
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		if (moved[blockIdx] || sourcePtr[blockIdx] == blockIdx) continue;
+
+		memcpy(&spareBlock[0], voxelBlocks + blockIdx * SDF_BLOCK_SIZE3, blockBytes);
+		int targetPtr = blockIdx;
+		for (; sourcePtr[targetPtr] != blockIdx; targetPtr = sourcePtr[targetPtr])
+		{
+			memcpy(voxelBlocks + targetPtr * SDF_BLOCK_SIZE3, voxelBlocks + sourcePtr[targetPtr] * SDF_BLOCK_SIZE3, blockBytes);
+			moved[targetPtr] = 1;
+		}
+		memcpy(voxelBlocks + targetPtr * SDF_BLOCK_SIZE3, &spareBlock[0], blockBytes);
+		moved[targetPtr] = 1;
+	}
+
+	for (int blockIdx = 0; blockIdx < noBlocks; blockIdx++)
+	{
+		writeBlockPtr(indexData, sortedEntries[blockIdx].second, blockIdx);
+		allocatedEntryIDs[blockIdx] = sortedEntries[blockIdx].second;
+	}
+	for (size_t listIdx = 0; listIdx < swappedOutEntries.size(); listIdx++) allocatedEntryIDs[noBlocks + listIdx] = swappedOutEntries[listIdx];
+
+	// the free blocks are handed out in ascending order
+	int lastFreeBlockId = noLocalBlocks - noBlocks - 1;
+	for (int vbaIdx = 0; vbaIdx <= lastFreeBlockId; vbaIdx++) voxelAllocationList[vbaIdx] = noLocalBlocks - 1 - vbaIdx;
+
+	return true;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	if (isRecentering || !defragmentVoxelBlocks(scene)) return;
+
+	// all blocks may have moved, so the block neighbour table is built anew, and the occupancy grid with it
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	if (blockNeighbours != NULL)
+	{
+		int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
+		for (int i = 0; i < noLocalBlocks * SDF_BLOCK_NEIGHBOUR_NUM; i++) blockNeighbours[i] = -1;
+		memset(scene->index.GetBlockOccupancy(), 0, SDF_OCCUPANCY_LEVEL_NUM * (scene->index.GetBlockOccupancyMask() + 1) * sizeof(int));
+		linkNewVoxelBlocks(scene);
+	}
+}
+
+/** Whether @p blockPos can be stored in ITMHashEntry::pos. */
+static inline bool isValidBlockPos(const Vector3i &blockPos)
+{
+	const int maxPos = (1 << (SDF_BLOCK_POS_BITS - 1)) - 1;
+	return blockPos.x >= -maxPos - 1 && blockPos.x <= maxPos && blockPos.y >= -maxPos - 1 && blockPos.y <= maxPos &&
+		blockPos.z >= -maxPos - 1 && blockPos.z <= maxPos;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::CancelRecentering(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	ITMHashEntry *recenteredTable = recenteredEntries->GetData(MEMORYDEVICE_CPU);
+	const int *newEntryIdOf = recenteredEntryIDs->GetData(MEMORYDEVICE_CPU);
+	const int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+
+	ITMHashEntry emptyEntry;
+	memset(&emptyEntry, 0, sizeof(ITMHashEntry));
+	emptyEntry.ptr = -2;
+
+	for (int listIdx = 0; listIdx < noRecenteredEntries; listIdx++) recenteredTable[newEntryIdOf[allocatedEntryIDs[listIdx]]] = emptyEntry;
+	isRecentering = false;
+}
+
+template<class TVoxel>
+bool ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::RecenterScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	ITMRenderState *renderState, const Vector3i &shift)
+{
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	int noExcessEntries = scene->index.GetExcessListSize();
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	int occupancyMask = scene->index.GetBlockOccupancyMask();
+	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
+	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
+
+	if (shift.x == 0 && shift.y == 0 && shift.z == 0) return true;
+	if (isRecentering && recenteringShift != shift) CancelRecentering(scene);
+
+	if (!isRecentering)
+	{
+		if (recenteredEntries == NULL) ClearRecenteredEntries(scene, scene->index.GetBucketNum());
+
+		int *recenteredExcessList_ptr = recenteredExcessList->GetData(MEMORYDEVICE_CPU);
+		for (int exlIdx = 0; exlIdx < noExcessEntries; exlIdx++) recenteredExcessList_ptr[exlIdx] = exlIdx;
+		lastFreeRecenteredExcessId = noExcessEntries - 1;
+		if (recenteredBlockOccupancy != NULL)
+			memset(recenteredBlockOccupancy->GetData(MEMORYDEVICE_CPU), 0, SDF_OCCUPANCY_LEVEL_NUM * (occupancyMask + 1) * sizeof(int));
+
+		isRecentering = true;
+		recenteringShift = shift;
+		noRecenteredEntries = 0;
+	}
+
+	ITMHashEntry *recenteredTable = recenteredEntries->GetData(MEMORYDEVICE_CPU);
+	const int *recenteredExcessList_ptr = recenteredExcessList->GetData(MEMORYDEVICE_CPU);
+	int *recenteredOccupancy = recenteredBlockOccupancy != NULL ? recenteredBlockOccupancy->GetData(MEMORYDEVICE_CPU) : NULL;
+	int *newEntryIdOf = recenteredEntryIDs->GetData(MEMORYDEVICE_CPU);
+	int centreIdx = blockNeighbourIdx(Vector3i(0, 0, 0));
+
+	// the entries are inserted in the order of the list, so the oldest ones take the buckets, entries allocated meanwhile come last
+	int endListIdx = MIN(noRecenteredEntries + scene->sceneParams->recenteringBudget, noAllocatedEntries);
+	for (int listIdx = noRecenteredEntries; listIdx < endListIdx; listIdx++)
+	{
+		ITMHashEntry hashEntry = hashTable[allocatedEntryIDs[listIdx]];
+		Vector3i oldBlockPos = hashEntry.pos.toInt(), blockPos = oldBlockPos - shift;
+		if (!isValidBlockPos(blockPos))
+		{
+			printf("Error: Cannot move the scene origin by (%i, %i, %i) blocks, block (%i, %i, %i) would be out of range!\n",
+				shift.x, shift.y, shift.z, oldBlockPos.x, oldBlockPos.y, oldBlockPos.z);
+			CancelRecentering(scene);
+			return false;
+		}
+
+		hashEntry.pos = ITMBlockPos(blockPos.x, blockPos.y, blockPos.z);
+		hashEntry.offset = 0;
+
+		int entryId = insertHashEntry(recenteredTable, scene->index.GetBucketNum(), recenteredExcessList_ptr, lastFreeRecenteredExcessId, hashEntry);
+		if (entryId < 0)
+		{
+			printf("Error: Cannot move the scene origin by (%i, %i, %i) blocks, the excess list is too small!\n", shift.x, shift.y, shift.z);
+			CancelRecentering(scene);
+			return false;
+		}
+
+		newEntryIdOf[allocatedEntryIDs[listIdx]] = entryId;
+		noRecenteredEntries = listIdx + 1;
+
+		// the blocks stay in the local VBA and keep their neighbours, only the occupancy grid counts them at their positions
+		if (blockNeighbours != NULL && hashEntry.ptr >= 0 && blockNeighbours[hashEntry.ptr * SDF_BLOCK_NEIGHBOUR_NUM + centreIdx] == hashEntry.ptr)
+			updateBlockOccupancy(recenteredOccupancy, occupancyMask, hashEntry.pos.toInt(), 1);
+	}
+
+	if (noRecenteredEntries < noAllocatedEntries) return false;
+
+	SwapInRecenteredEntries(scene, renderState_vh, scene->index.GetBucketNum());
+	isRecentering = false;
+
+	return true;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::SwapInRecenteredEntries(ITMScene<TVoxel, ITMVoxelBlockHash> *scene,
+	ITMRenderState_VH *renderState_vh, int noBuckets)
+{
+	int noTotalEntries = noBuckets + scene->index.GetExcessListSize();
+	renderState_vh->Resize(noTotalEntries, scene->index.getNumAllocatedVoxelBlocks());
+	if (scene->useSwapping) scene->globalCache->Resize(noTotalEntries);
+
+	ITMHashEntry *hashTable = scene->index.GetEntries();
+	int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	int occupancyMask = scene->index.GetBlockOccupancyMask();
+	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
+	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
+	ITMHashEntry *recenteredTable = recenteredEntries->GetData(MEMORYDEVICE_CPU);
+	int *recenteredOccupancy = recenteredBlockOccupancy != NULL ? recenteredBlockOccupancy->GetData(MEMORYDEVICE_CPU) : NULL;
+	const int *newEntryIdOf = recenteredEntryIDs->GetData(MEMORYDEVICE_CPU);
+
+	ITMHashEntry emptyEntry;
+	memset(&emptyEntry, 0, sizeof(ITMHashEntry));
+	emptyEntry.ptr = -2;
+
+	// blocks swapped out or back in since their entries were moved are counted anew, and the old table is emptied to take the next move
+	std::vector<int> newEntryIDs(noAllocatedEntries);
+	std::vector<uchar> visibleTypes(noAllocatedEntries);
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		int entryId = allocatedEntryIDs[listIdx];
+		newEntryIDs[listIdx] = newEntryIdOf[entryId];
+
+		ITMHashEntry &movedEntry = recenteredTable[newEntryIDs[listIdx]];
+		int blockPtr = hashTable[entryId].ptr;
+		if (movedEntry.ptr != blockPtr)
+		{
+			// blocks are linked in the frame they are handed out and unlinked when they are taken away
+			if (blockNeighbours != NULL) updateBlockOccupancy(recenteredOccupancy, occupancyMask, movedEntry.pos.toInt(), (blockPtr >= 0) - (movedEntry.ptr >= 0));
+			movedEntry.ptr = blockPtr;
+		}
+
+		visibleTypes[listIdx] = entriesVisibleType[entryId];
+		entriesVisibleType[entryId] = 0;
+		hashTable[entryId] = emptyEntry;
+	}
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++) entriesVisibleType[newEntryIDs[listIdx]] = visibleTypes[listIdx];
+
+	if (scene->useSwapping) scene->globalCache->MoveEntries(allocatedEntryIDs, &newEntryIDs[0], noAllocatedEntries);
+
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++) allocatedEntryIDs[listIdx] = newEntryIDs[listIdx];
+	for (int visibleIdx = 0; visibleIdx < renderState_vh->noVisibleEntries; visibleIdx++)
+		visibleEntryIDs[visibleIdx] = newEntryIdOf[visibleEntryIDs[visibleIdx]];
+
+	scene->index.SwapEntries(recenteredEntries, recenteredExcessList, lastFreeRecenteredExcessId, recenteredBlockOccupancy, noBuckets);
+}
+
+template<class TVoxel>
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::ITMSceneReconstructionEngine_CPU(void) 
 {
-	int noTotalEntries = ITMVoxelBlockHash::noTotalEntries;
-	entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(noTotalEntries, MEMORYDEVICE_CPU);
-	blockCoords = new ORUtils::MemoryBlock<Vector4s>(noTotalEntries, MEMORYDEVICE_CPU);
+	// sized to the scene's hash table and voxel block array in ResetScene
+	entriesAllocType = NULL;
+	blockCoords = NULL;
+	allocationRequests = NULL;
+	// sized to the depth image in IntegrateIntoScene
+	depthTiles = NULL;
 }
 
 template<class TVoxel>
-ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::~ITMSceneReconstructionEngine_CPU(void) 
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::~ITMSceneReconstructionEngine_CPU(void) 
 {
 	delete entriesAllocType;
 	delete blockCoords;
+	delete allocationRequests;
+	delete depthTiles;
 }
 
 template<class TVoxel>
-void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockHash>::ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::ResetScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene)
 {
 	int numBlocks = scene->index.getNumAllocatedVoxelBlocks();
-	int blockSize = scene->index.getVoxelBlockSize();
 
-	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
-	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	// the voxels are left as they are, blocks are cleared when they are handed out
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
 	scene->localVBA.lastFreeBlockId = numBlocks - 1;
 
-	ITMHashEntry tmpEntry;
-	memset(&tmpEntry, 0, sizeof(ITMHashEntry));
-	tmpEntry.ptr = -2;
-	ITMHashEntry *hashEntry_ptr = scene->index.GetEntries();
-	for (int i = 0; i < scene->index.noTotalEntries; ++i) hashEntry_ptr[i] = tmpEntry;
-	int *excessList_ptr = scene->index.GetExcessAllocationList();
-	for (int i = 0; i < SDF_EXCESS_LIST_SIZE; ++i) excessList_ptr[i] = i;
+	ITMOpenHashBucket tmpBucket;
+	memset(&tmpBucket, 0, sizeof(ITMOpenHashBucket));
+	ITMOpenHashBucket *buckets = scene->index.GetBuckets();
+#ifdef WITH_OPENMP
+	#pragma omp parallel for
+#endif
+	for (int i = 0; i < SDF_OPEN_HASH_BUCKET_NUM; ++i) buckets[i] = tmpBucket;
+
+	scene->index.SetNoAllocatedEntries(0);
+
+	int noTotalEntries = scene->index.noTotalEntries;
+	if (entriesAllocType == NULL || entriesAllocType->dataSize != (size_t)noTotalEntries)
+	{
+		delete entriesAllocType;
+		delete blockCoords;
+		entriesAllocType = new ORUtils::MemoryBlock<unsigned char>(noTotalEntries, MEMORYDEVICE_CPU);
+		blockCoords = new ORUtils::MemoryBlock<Vector4s>(noTotalEntries, MEMORYDEVICE_CPU);
+	}
+	if (allocationRequests == NULL || allocationRequests->dataSize != (size_t)numBlocks)
+	{
+		delete allocationRequests;
+		allocationRequests = new ORUtils::MemoryBlock<int>(numBlocks, MEMORYDEVICE_CPU);
+	}
 
-	scene->index.SetLastFreeExcessListId(SDF_EXCESS_LIST_SIZE - 1);
+	// AllocateSceneFromDepth clears the marks of the requests it lists
+	memset(entriesAllocType->GetData(MEMORYDEVICE_CPU), 0, noTotalEntries);
 }
 
 template<class TVoxel>
-void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view,
-	const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene,
+	const ITMView *view, const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool onlyUpdateVisibleList)
 {
-	Vector2i rgbImgSize = view->rgb->noDims;
 	Vector2i depthImgSize = view->depth->noDims;
 	float voxelSize = scene->sceneParams->voxelSize;
 
-	Matrix4f M_d, M_rgb;
-	Vector4f projParams_d, projParams_rgb;
+	Matrix4f M_d, invM_d;
+	Vector4f projParams_d, invProjParams_d;
 
 	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	renderState_vh->Resize(scene->index.noTotalEntries, scene->index.getNumAllocatedVoxelBlocks());
 
-	M_d = trackingState->pose_d->GetM();
-	if (TVoxel::hasColorInformation) M_rgb = view->calib->trafo_rgb_to_depth.calib_inv * M_d;
+	M_d = trackingState->pose_d->GetM(); M_d.inv(invM_d);
 
 	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
-	projParams_rgb = view->calib->intrinsics_rgb.projectionParamsSimple.all;
+	invProjParams_d = projParams_d;
+	invProjParams_d.x = 1.0f / invProjParams_d.x;
+	invProjParams_d.y = 1.0f / invProjParams_d.y;
 
-	float mu = scene->sceneParams->mu; int maxW = scene->sceneParams->maxW;
+	float mu = scene->sceneParams->mu;
 
 	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
-	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
-	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
-	ITMHashEntry *hashTable = scene->index.GetEntries();
+	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	ITMOpenHashBucket *buckets = scene->index.GetBuckets();
+	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
+	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
+	uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
+	Vector4s *blockCoords = this->blockCoords->GetData(MEMORYDEVICE_CPU);
+	int *allocationRequests = this->allocationRequests->GetData(MEMORYDEVICE_CPU);
+	int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
 
-	int *visibleEntryIds = renderState_vh->GetVisibleEntryIDs();
-	int noVisibleEntries = renderState_vh->noVisibleEntries;
+	float oneOverVoxelSize = 1.0f / (voxelSize * SDF_BLOCK_SIZE);
 
-	bool stopIntegratingAtMaxW = scene->sceneParams->stopIntegratingAtMaxW;
-	//bool approximateIntegration = !trackingState->requiresFullRendering;
+	int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
+	int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+
+	int noVisibleEntries = 0, noAllocationRequests = 0;
+
+	for (int i = 0; i < renderState_vh->noVisibleEntries; i++)
+		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame
 
+	//build hashVisibility
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
 #endif
-	for (int entryId = 0; entryId < noVisibleEntries; entryId++)
+	for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
 	{
-		Vector3i globalPos;
-		const ITMHashEntry &currentHashEntry = hashTable[visibleEntryIds[entryId]];
-
-		if (currentHashEntry.ptr < 0) continue;
+		int y = locId / depthImgSize.x;
+		int x = locId - y * depthImgSize.x;
+		buildOpenHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, allocationRequests, &noAllocationRequests, noLocalBlocks,
+			x, y, blockCoords, depth, invM_d, invProjParams_d, mu, depthImgSize, oneOverVoxelSize, buckets,
+			scene->sceneParams->viewFrustum_min, scene->sceneParams->viewFrustum_max);
+	}
+	noAllocationRequests = MIN(noAllocationRequests, noLocalBlocks);
 
-		globalPos.x = currentHashEntry.pos.x;
-		globalPos.y = currentHashEntry.pos.y;
-		globalPos.z = currentHashEntry.pos.z;
-		globalPos *= SDF_BLOCK_SIZE;
+	//allocate, each request is for the first free slot on the probe sequence of its block
+	for (int requestIdx = 0; requestIdx < noAllocationRequests; requestIdx++)
+	{
+		int targetIdx = allocationRequests[requestIdx];
+		if (entriesAllocType[targetIdx] != 1) continue; // listed twice
+		entriesAllocType[targetIdx] = 0;
 
-		TVoxel *localVoxelBlock = &(localVBA[currentHashEntry.ptr * (SDF_BLOCK_SIZE3)]);
+		int vbaIdx = onlyUpdateVisibleList ? -1 : lastFreeVoxelBlockId--;
 
-		for (int z = 0; z < SDF_BLOCK_SIZE; z++) for (int y = 0; y < SDF_BLOCK_SIZE; y++) for (int x = 0; x < SDF_BLOCK_SIZE; x++)
+		if (vbaIdx >= 0) //there is room in the voxel block array
 		{
-			Vector4f pt_model; int locId;
+			int bucketIdx = targetIdx / SDF_OPEN_HASH_SLOT_NUM, slotIdx = targetIdx % SDF_OPEN_HASH_SLOT_NUM;
+			buckets[bucketIdx].pos[slotIdx] = blockCoords[targetIdx];
+			buckets[bucketIdx].ptr[slotIdx] = voxelAllocationList[vbaIdx];
 
-			locId = x + y * SDF_BLOCK_SIZE + z * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+			allocatedEntryIDs[noAllocatedEntries++] = targetIdx;
+		}
+		else entriesVisibleType[targetIdx] = 0; //no block to allocate, the slot stays free
+	}
+
+	//build visible list, only entries present in the hash table can be visible
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+	{
+		int targetIdx = allocatedEntryIDs[listIdx];
+		unsigned char hashVisibleType = entriesVisibleType[targetIdx];
 
-			if (stopIntegratingAtMaxW) if (localVoxelBlock[locId].w_depth == maxW) continue;
-			//if (approximateIntegration) if (localVoxelBlock[locId].w_depth != 0) continue;
+		if (hashVisibleType == 3)
+		{
+			bool isVisibleEnlarged, isVisible;
+			ITMBlockPos blockPos; int blockPtr;
+			readBlockEntry(buckets, targetIdx, blockPos, blockPtr);
 
-			pt_model.x = (float)(globalPos.x + x) * voxelSize;
-			pt_model.y = (float)(globalPos.y + y) * voxelSize;
-			pt_model.z = (float)(globalPos.z + z) * voxelSize;
-			pt_model.w = 1.0f;
+			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, blockPos.toInt(), M_d, projParams_d, voxelSize, depthImgSize);
+			if (!isVisible) hashVisibleType = 0;
+			entriesVisibleType[targetIdx] = hashVisibleType;
+		}
 
-			ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(localVoxelBlock[locId], pt_model, M_d, 
-				projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, depthImgSize, rgb, rgbImgSize);
+		if (hashVisibleType > 0 && noVisibleEntries < noLocalBlocks)
+		{
+			visibleEntryIDs[noVisibleEntries] = targetIdx;
+			noVisibleEntries++;
 		}
 	}
+
+	renderState_vh->noVisibleEntries = noVisibleEntries;
+
+	// the counter runs past -1 when the voxel block array is exhausted
+	int oldLastFreeBlockId = scene->localVBA.lastFreeBlockId;
+	scene->localVBA.lastFreeBlockId = MAX(lastFreeVoxelBlockId, -1);
+	scene->index.SetNoAllocatedEntries(noAllocatedEntries);
+
+	clearHandedOutBlocks(scene, oldLastFreeBlockId);
 }
 
 template<class TVoxel>
-void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view,
-	const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool onlyUpdateVisibleList)
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene,
+	const ITMView *view, const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+{
+	integrateVisibleBlocks(scene, view, trackingState, renderState, depthTiles);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene)
+{
+	defragmentVoxelBlocks(scene);
+}
+
+template<class TVoxel>
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockOctree>::ITMSceneReconstructionEngine_CPU(void) 
+{
+	// sized to the depth image in AllocateSceneFromDepth and IntegrateIntoScene
+	pixelsAllocType = NULL;
+	depthTiles = NULL;
+}
+
+template<class TVoxel>
+ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockOctree>::~ITMSceneReconstructionEngine_CPU(void) 
+{
+	delete pixelsAllocType;
+	delete depthTiles;
+}
+
+/** Resets all children of @p node and places it at the octant of its
+    parent that holds @p blockPos, on level @p level.
+*/
+static inline void resetOctreeNode(ITMOctreeNode &node, const Vector3i &blockPos, int level)
+{
+	int rootOffset = 1 << (SDF_OCTREE_DEPTH - 1), nodeSize = 1 << (SDF_OCTREE_DEPTH - level);
+
+	node.pos.x = ((blockPos.x + rootOffset) & ~(nodeSize - 1)) - rootOffset;
+	node.pos.y = ((blockPos.y + rootOffset) & ~(nodeSize - 1)) - rootOffset;
+	node.pos.z = ((blockPos.z + rootOffset) & ~(nodeSize - 1)) - rootOffset;
+	node.pos.w = level;
+	for (int childIdx = 0; childIdx < 8; childIdx++) node.child[childIdx] = -1;
+}
+
+/** Inserts the block at @p blockPos into the octree, taking the missing
+    nodes on the way from the pool and the block from the voxel block
+    array. Returns the entry ID of the block, or -1 if it is outside of the
+    root or the pool or the voxel block array are exhausted.
+*/
+static int insertOctreeBlock(ITMOctreeNode *nodes, int &noUsedNodes, int noNodes, const Vector3i &blockPos,
+	const int *voxelAllocationList, int &lastFreeVoxelBlockId, int *allocatedEntryIDs, int &noAllocatedEntries)
+{
+	if (!isInOctree(blockPos)) return -1;
+
+	int nodeIdx = 0, level = 0;
+	if (descendOctree(nodes, blockPos, nodeIdx, level) >= 0) return nodeIdx * 8 + octreeChildIdx(blockPos, SDF_OCTREE_DEPTH - 1);
+
+	// nothing is taken unless the whole path fits, an interior node without a block below it would be wasted for good
+	int noMissingNodes = SDF_OCTREE_DEPTH - 1 - level;
+	if (lastFreeVoxelBlockId < 0 || noUsedNodes + noMissingNodes > noNodes) return -1;
+
+	for (; level < SDF_OCTREE_DEPTH - 1; level++)
+	{
+		int childIdx = noUsedNodes++;
+		resetOctreeNode(nodes[childIdx], blockPos, level + 1);
+		nodes[nodeIdx].child[octreeChildIdx(blockPos, level)] = childIdx;
+		nodeIdx = childIdx;
+	}
+
+	int entryId = nodeIdx * 8 + octreeChildIdx(blockPos, SDF_OCTREE_DEPTH - 1);
+	nodes[nodeIdx].child[entryId % 8] = voxelAllocationList[lastFreeVoxelBlockId--];
+	allocatedEntryIDs[noAllocatedEntries++] = entryId;
+	return entryId;
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel,ITMVoxelBlockOctree>::ResetScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene)
+{
+	int numBlocks = scene->index.getNumAllocatedVoxelBlocks();
+
+	// the voxels are left as they are, blocks are cleared when they are handed out
+	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
+	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
+	scene->localVBA.lastFreeBlockId = numBlocks - 1;
+
+	// only the root is in use, the other nodes are initialised when they are taken from the pool
+	int rootOffset = 1 << (SDF_OCTREE_DEPTH - 1);
+	resetOctreeNode(scene->index.GetNodes()[0], Vector3i(-rootOffset, -rootOffset, -rootOffset), 0);
+	scene->index.SetNoUsedNodes(1);
+	scene->index.SetNoAllocatedEntries(0);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOctree>::AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene,
+	const ITMView *view, const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool onlyUpdateVisibleList)
 {
 	Vector2i depthImgSize = view->depth->noDims;
 	float voxelSize = scene->sceneParams->voxelSize;
@@ -124,6 +2132,7 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 	Vector4f projParams_d, invProjParams_d;
 
 	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	renderState_vh->Resize(scene->index.noTotalEntries, scene->index.getNumAllocatedVoxelBlocks());
 
 	M_d = trackingState->pose_d->GetM(); M_d.inv(invM_d);
 
@@ -134,32 +2143,34 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 
 	float mu = scene->sceneParams->mu;
 
+	if (pixelsAllocType == NULL || pixelsAllocType->dataSize != (size_t)(depthImgSize.x * depthImgSize.y))
+	{
+		delete pixelsAllocType;
+		pixelsAllocType = new ORUtils::MemoryBlock<unsigned char>(depthImgSize.x * depthImgSize.y, MEMORYDEVICE_CPU);
+	}
+
 	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
-	int *excessAllocationList = scene->index.GetExcessAllocationList();
-	ITMHashEntry *hashTable = scene->index.GetEntries();
-	ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(false) : 0;
+	ITMOctreeNode *nodes = scene->index.GetNodes();
 	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
 	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
-	uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
-	Vector4s *blockCoords = this->blockCoords->GetData(MEMORYDEVICE_CPU);
-	int noTotalEntries = scene->index.noTotalEntries;
-
-	bool useSwapping = scene->useSwapping;
+	uchar *pixelsAllocType = this->pixelsAllocType->GetData(MEMORYDEVICE_CPU);
+	int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
 
 	float oneOverVoxelSize = 1.0f / (voxelSize * SDF_BLOCK_SIZE);
+	float viewFrustum_min = scene->sceneParams->viewFrustum_min, viewFrustum_max = scene->sceneParams->viewFrustum_max;
 
 	int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
-	int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+	int noUsedNodes = scene->index.GetNoUsedNodes(), noNodes = scene->index.GetNoNodes();
+	int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
 
 	int noVisibleEntries = 0;
 
-	memset(entriesAllocType, 0, noTotalEntries);
-
 	for (int i = 0; i < renderState_vh->noVisibleEntries; i++)
-		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame and unstreamed
+		entriesVisibleType[visibleEntryIDs[i]] = 3; // visible at previous frame
 
-	//build hashVisibility
+	//build visibility, and flag the pixels with blocks missing from the octree
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
 #endif
@@ -167,127 +2178,79 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockHash>::AllocateSceneF
 	{
 		int y = locId / depthImgSize.x;
 		int x = locId - y * depthImgSize.x;
-		buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
-			invProjParams_d, mu, depthImgSize, oneOverVoxelSize, hashTable, scene->sceneParams->viewFrustum_min,
-			scene->sceneParams->viewFrustum_max);
+		pixelsAllocType[locId] = buildOctreeVisibleTypePP(entriesVisibleType, x, y, depth, invM_d, invProjParams_d, mu,
+			depthImgSize, oneOverVoxelSize, nodes, viewFrustum_min, viewFrustum_max) ? 1 : 0;
 	}
 
-	if (onlyUpdateVisibleList) useSwapping = false;
-	if (!onlyUpdateVisibleList)
+	//allocate, inserting changes the nodes, so the flagged pixels are revisited one after the other
+	if (!onlyUpdateVisibleList) for (int locId = 0; locId < depthImgSize.x*depthImgSize.y; locId++)
 	{
-		//allocate
-		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
-		{
-			int vbaIdx, exlIdx;
-			unsigned char hashChangeType = entriesAllocType[targetIdx];
-
-			switch (hashChangeType)
-			{
-			case 1: //needs allocation, fits in the ordered list
-				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
-
-				if (vbaIdx >= 0) //there is room in the voxel block array
-				{
-					Vector4s pt_block_all = blockCoords[targetIdx];
-
-					ITMHashEntry hashEntry;
-					hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
-					hashEntry.ptr = voxelAllocationList[vbaIdx];
-					hashEntry.offset = 0;
-
-					hashTable[targetIdx] = hashEntry;
-				}
-
-				break;
-			case 2: //needs allocation in the excess list
-				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
-				exlIdx = lastFreeExcessListId; lastFreeExcessListId--;
-
-				if (vbaIdx >= 0 && exlIdx >= 0) //there is room in the voxel block array and excess list
-				{
-					Vector4s pt_block_all = blockCoords[targetIdx];
+		if (pixelsAllocType[locId] == 0) continue;
 
-					ITMHashEntry hashEntry;
-					hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
-					hashEntry.ptr = voxelAllocationList[vbaIdx];
-					hashEntry.offset = 0;
-
-					int exlOffset = excessAllocationList[exlIdx];
+		int y = locId / depthImgSize.x;
+		int x = locId - y * depthImgSize.x;
 
-					hashTable[targetIdx].offset = exlOffset + 1; //connect to child
+		int noSteps; Vector3f point, direction;
+		computeTruncationBandSegment(point, direction, noSteps, x, y, depth, invM_d, invProjParams_d, mu, depthImgSize,
+			oneOverVoxelSize, viewFrustum_min, viewFrustum_max);
 
-					hashTable[SDF_BUCKET_NUM + exlOffset] = hashEntry; //add child to the excess list
+		for (int i = 0; i < noSteps; i++)
+		{
+			Vector3i blockPos((int)floor(point.x), (int)floor(point.y), (int)floor(point.z));
 
-					entriesVisibleType[SDF_BUCKET_NUM + exlOffset] = 1; //make child visible and in memory
-				}
+			int entryId = insertOctreeBlock(nodes, noUsedNodes, noNodes, blockPos, voxelAllocationList, lastFreeVoxelBlockId,
+				allocatedEntryIDs, noAllocatedEntries);
+			if (entryId >= 0) entriesVisibleType[entryId] = 1; //new entry is visible
 
-				break;
-			}
+			point += direction;
 		}
 	}
 
-	//build visible list
-	for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+	//build visible list, only blocks present in the octree can be visible
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
 	{
+		int targetIdx = allocatedEntryIDs[listIdx];
 		unsigned char hashVisibleType = entriesVisibleType[targetIdx];
-		const ITMHashEntry &hashEntry = hashTable[targetIdx];
-		
+
 		if (hashVisibleType == 3)
 		{
 			bool isVisibleEnlarged, isVisible;
+			ITMBlockPos blockPos; int blockPtr;
+			readBlockEntry(nodes, targetIdx, blockPos, blockPtr);
 
-			if (useSwapping)
-			{
-				checkBlockVisibility<true>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
-				if (!isVisibleEnlarged) hashVisibleType = 0;
-			} else {
-				checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
-				if (!isVisible) { hashVisibleType = 0; }
-			}
+			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, blockPos.toInt(), M_d, projParams_d, voxelSize, depthImgSize);
+			if (!isVisible) hashVisibleType = 0;
 			entriesVisibleType[targetIdx] = hashVisibleType;
 		}
 
-		if (useSwapping)
+		if (hashVisibleType > 0 && noVisibleEntries < noLocalBlocks)
 		{
-			if (hashVisibleType > 0 && swapStates[targetIdx].state != 2) swapStates[targetIdx].state = 1;
-		}
-
-		if (hashVisibleType > 0)
-		{	
 			visibleEntryIDs[noVisibleEntries] = targetIdx;
 			noVisibleEntries++;
 		}
-
-#if 0
-		// "active list", currently disabled
-		if (hashVisibleType == 1)
-		{
-			activeEntryIDs[noActiveEntries] = targetIdx;
-			noActiveEntries++;
-		}
-#endif
-	}
-
-	//reallocate deleted ones from previous swap operation
-	if (useSwapping)
-	{
-		for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
-		{
-			int vbaIdx;
-			ITMHashEntry hashEntry = hashTable[targetIdx];
-
-			if (entriesVisibleType[targetIdx] > 0 && hashEntry.ptr == -1) 
-			{
-				vbaIdx = lastFreeVoxelBlockId; lastFreeVoxelBlockId--;
-				if (vbaIdx >= 0) hashTable[targetIdx].ptr = voxelAllocationList[vbaIdx];
-			}
-		}
 	}
 
 	renderState_vh->noVisibleEntries = noVisibleEntries;
 
+	int oldLastFreeBlockId = scene->localVBA.lastFreeBlockId;
 	scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
-	scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+	scene->index.SetNoUsedNodes(noUsedNodes);
+	scene->index.SetNoAllocatedEntries(noAllocatedEntries);
+
+	clearHandedOutBlocks(scene, oldLastFreeBlockId);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOctree>::IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene,
+	const ITMView *view, const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+{
+	integrateVisibleBlocks(scene, view, trackingState, renderState, depthTiles);
+}
+
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOctree>::DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene)
+{
+	defragmentVoxelBlocks(scene);
 }
 
 template<class TVoxel>
@@ -305,7 +2268,8 @@ void ITMSceneReconstructionEngine_CPU<TVoxel,ITMPlainVoxelArray>::ResetScene(ITM
 	int blockSize = scene->index.getVoxelBlockSize();
 
 	TVoxel *voxelBlocks_ptr = scene->localVBA.GetVoxelBlocks();
-	for (int i = 0; i < numBlocks * blockSize; ++i) voxelBlocks_ptr[i] = TVoxel();
+	if (scene->sceneParams->useSoAVoxelBlocks) resetVoxels<TVoxel>((ITMVoxel_SoA<TVoxel>*)voxelBlocks_ptr, numBlocks * blockSize);
+	else resetVoxels<TVoxel>(voxelBlocks_ptr, numBlocks * blockSize);
 	int *vbaAllocationList_ptr = scene->localVBA.GetAllocationList();
 	for (int i = 0; i < numBlocks; ++i) vbaAllocationList_ptr[i] = i;
 	scene->localVBA.lastFreeBlockId = numBlocks - 1;
@@ -316,8 +2280,8 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::AllocateScene
 	const ITMTrackingState *trackingState, const ITMRenderState *renderState, bool onlyUpdateVisibleList)
 {}
 
-template<class TVoxel>
-void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateIntoScene(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, const ITMView *view,
+template<class TVoxel, class TVoxelData>
+static void IntegrateIntoScene_common(TVoxelData *voxelArray, ITMScene<TVoxel, ITMPlainVoxelArray> *scene, const ITMView *view,
 	const ITMTrackingState *trackingState, const ITMRenderState *renderState)
 {
 	Vector2i rgbImgSize = view->rgb->noDims;
@@ -333,11 +2297,10 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
 	projParams_rgb = view->calib->intrinsics_rgb.projectionParamsSimple.all;
 
-	float mu = scene->sceneParams->mu; int maxW = scene->sceneParams->maxW;
+	float mu = scene->sceneParams->mu; int maxW = MIN(scene->sceneParams->maxW, TVoxel::W_maxValue());
 
 	float *depth = view->depth->GetData(MEMORYDEVICE_CPU);
 	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CPU);
-	TVoxel *voxelArray = scene->localVBA.GetVoxelBlocks();
 
 	const ITMPlainVoxelArray::IndexData *arrayInfo = scene->index.getIndexData();
 
@@ -355,17 +2318,30 @@ void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateInto
 		int x = tmp - y * scene->index.getVolumeSize().x;
 		Vector4f pt_model;
 
-		if (stopIntegratingAtMaxW) if (voxelArray[locId].w_depth == maxW) continue;
-		//if (approximateIntegration) if (voxelArray[locId].w_depth != 0) continue;
+		TVoxel voxel = readVoxel(voxelArray, locId);
+
+		if (stopIntegratingAtMaxW) if (voxel.w_depth == maxW) continue;
+		//if (approximateIntegration) if (voxel.w_depth != 0) continue;
 
 		pt_model.x = (float)(x + arrayInfo->offset.x) * voxelSize;
 		pt_model.y = (float)(y + arrayInfo->offset.y) * voxelSize;
 		pt_model.z = (float)(z + arrayInfo->offset.z) * voxelSize;
 		pt_model.w = 1.0f;
 
-		ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(voxelArray[locId], pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, 
+		ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(voxel, pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, 
 			depth, depthImgSize, rgb, rgbImgSize);
+
+		writeVoxel(voxelArray, locId, voxel);
 	}
 }
 
-template class ITMLib::Engine::ITMSceneReconstructionEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+template<class TVoxel>
+void ITMSceneReconstructionEngine_CPU<TVoxel, ITMPlainVoxelArray>::IntegrateIntoScene(ITMScene<TVoxel, ITMPlainVoxelArray> *scene, const ITMView *view,
+	const ITMTrackingState *trackingState, const ITMRenderState *renderState)
+{
+	TVoxel *voxelArray = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) IntegrateIntoScene_common((ITMVoxel_SoA<TVoxel>*)voxelArray, scene, view, trackingState, renderState);
+	else IntegrateIntoScene_common(voxelArray, scene, view, trackingState, renderState);
+}
+
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMSceneReconstructionEngine_CPU)
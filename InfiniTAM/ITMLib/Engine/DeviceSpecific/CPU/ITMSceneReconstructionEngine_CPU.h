@@ -3,6 +3,7 @@
 #pragma once
 
 #include "../../ITMSceneReconstructionEngine.h"
+#include "../../../Objects/ITMRenderState_VH.h"
 
 namespace ITMLib
 {
@@ -17,7 +18,80 @@ namespace ITMLib
 		{
 		protected:
 			ORUtils::MemoryBlock<unsigned char> *entriesAllocType;
-			ORUtils::MemoryBlock<Vector4s> *blockCoords;
+			ORUtils::MemoryBlock<ITMBlockCoords> *blockCoords;
+			/// Entries that request a block, listed by the parallel allocation
+			ORUtils::MemoryBlock<int> *allocationRequests;
+			ORUtils::MemoryBlock<float> *depthTiles;
+
+			/// Position in the allocated entry list where the next garbage collection starts
+			int garbageCollectionCursor;
+
+			/// Hash table, excess list and block occupancy grid RecenterScene moves the entries into, the table is kept empty between moves
+			ORUtils::MemoryBlock<ITMHashEntry> *recenteredEntries;
+			ORUtils::MemoryBlock<int> *recenteredExcessList;
+			ORUtils::MemoryBlock<int> *recenteredBlockOccupancy;
+			/// Address in recenteredEntries of each entry moved, by its address in the scene's hash table
+			ORUtils::MemoryBlock<int> *recenteredEntryIDs;
+			int lastFreeRecenteredExcessId;
+
+			/// Whether a move is under way, its shift, and the number of entries of the allocated entry list moved so far
+			bool isRecentering;
+			Vector3i recenteringShift;
+			int noRecenteredEntries;
+
+			/** Sizes recenteredEntries and the lists that go with it
+			    to a hash table of @p noBuckets buckets and the excess
+			    list of @p scene, and empties it.
+			*/
+			void ClearRecenteredEntries(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int noBuckets);
+
+			/** Empties the entries of recenteredEntries written by
+			    the move under way and gives it up.
+			*/
+			void CancelRecentering(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
+
+			/** Replaces the hash table of @p scene with
+			    recenteredEntries, which has @p noBuckets buckets and
+			    holds all entries of the allocated entry list at the
+			    addresses in recenteredEntryIDs. The allocated entry
+			    list, the visible entries of @p renderState_vh and the
+			    swap states follow the entries to their new addresses.
+			*/
+			void SwapInRecenteredEntries(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState_VH *renderState_vh, int noBuckets);
+
+			/** Clears the voxel blocks that were handed out from the
+			    allocation list since its top was at @p oldLastFreeBlockId.
+			    Blocks are cleared when they are handed out rather than when
+			    they are freed, so that resetting the scene and swapping out
+			    blocks need not touch the voxels.
+			*/
+			void ClearHandedOutBlocks(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int oldLastFreeBlockId) const;
+
+			/** Links the voxel blocks handed out from the allocation list
+			    since its top was at @p oldLastFreeBlockId into the block
+			    neighbour table of the index. Freed blocks are unlinked
+			    where they are freed.
+			*/
+			void LinkHandedOutBlocks(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int oldLastFreeBlockId) const;
+
+			/** Rehashes all entries into a table with twice as many
+			    buckets once there are more entries than
+			    ITMSceneParams::growthThreshold times the number of
+			    buckets. Block pointers do not change, entries move
+			    to new addresses. Returns whether the table changed.
+			*/
+			bool RehashScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState_VH *renderState_vh);
+
+			/** Grows the excess list and the local voxel block array
+			    so that @p noBlockRequests more blocks and
+			    @p noExcessRequests more excess list entries can be
+			    handed out without passing ITMSceneParams::growthThreshold,
+			    by at least half their size. The new entries and blocks
+			    are put on top of the free lists, present entries and
+			    blocks keep their addresses. Returns whether anything
+			    grew.
+			*/
+			bool GrowScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, int noBlockRequests, int noExcessRequests);
 
 		public:
 			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
@@ -28,6 +102,71 @@ namespace ITMLib
 			void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 				const ITMRenderState *renderState);
 
+			/** Waits while RecenterScene moves the entries, which
+			    are to stay where they are until the move is done.
+			*/
+			void CollectGarbage(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, const ITMRenderState *renderState);
+
+			/** Waits while RecenterScene moves the entries, like
+			    CollectGarbage.
+			*/
+			void DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
+
+			/** Rehashes up to ITMSceneParams::recenteringBudget
+			    entries per call into recenteredEntries, and
+			    replaces the hash table with it once all entries
+			    are moved. Meanwhile only the block pointers of
+			    the moved entries may change and new entries be
+			    appended to the allocated entry list.
+			*/
+			bool RecenterScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState, const Vector3i &shift);
+
+			ITMSceneReconstructionEngine_CPU(void);
+			~ITMSceneReconstructionEngine_CPU(void);
+		};
+
+		template<class TVoxel>
+		class ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOpenHash> : public ITMSceneReconstructionEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		protected:
+			ORUtils::MemoryBlock<unsigned char> *entriesAllocType;
+			ORUtils::MemoryBlock<Vector4s> *blockCoords;
+			ORUtils::MemoryBlock<int> *allocationRequests;
+			ORUtils::MemoryBlock<float> *depthTiles;
+
+		public:
+			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene);
+
+			void AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState, bool onlyUpdateVisibleList = false);
+
+			void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState);
+
+			void DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene);
+
+			ITMSceneReconstructionEngine_CPU(void);
+			~ITMSceneReconstructionEngine_CPU(void);
+		};
+
+		template<class TVoxel>
+		class ITMSceneReconstructionEngine_CPU<TVoxel, ITMVoxelBlockOctree> : public ITMSceneReconstructionEngine < TVoxel, ITMVoxelBlockOctree >
+		{
+		protected:
+			ORUtils::MemoryBlock<unsigned char> *pixelsAllocType;
+			ORUtils::MemoryBlock<float> *depthTiles;
+
+		public:
+			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene);
+
+			void AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState, bool onlyUpdateVisibleList = false);
+
+			void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState);
+
+			void DefragmentScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene);
+
 			ITMSceneReconstructionEngine_CPU(void);
 			~ITMSceneReconstructionEngine_CPU(void);
 		};
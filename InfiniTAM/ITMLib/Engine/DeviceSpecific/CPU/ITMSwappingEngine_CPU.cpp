@@ -1,6 +1,7 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
 #include "ITMSwappingEngine_CPU.h"
+#include "../../DeviceAgnostic/ITMRepresentationAccess.h"
 #include "../../DeviceAgnostic/ITMSwappingEngine.h"
 #include "../../../Objects/ITMRenderState_VH.h"
 
@@ -21,7 +22,7 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 {
 	ITMGlobalCache<TVoxel> *globalCache = scene->globalCache;
 
-	ITMHashSwapState *swapStates = globalCache->GetSwapStates(false);
+	const ITMHashEntry *hashTable = scene->index.GetEntries();
 
 	int *neededEntryIDs_local = globalCache->GetNeededEntryIDs(false);
 
@@ -29,19 +30,29 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 	bool *hasSyncedData_global = globalCache->GetHasSyncedData(false);
 	int *neededEntryIDs_global = globalCache->GetNeededEntryIDs(false);
 
-	int noTotalEntries = globalCache->noTotalEntries;
+	int *swapInEntryIDs = globalCache->GetSwapInEntryIDs();
+	int noSwapInEntries = globalCache->GetNoSwapInEntries();
+
+	globalCache->CollectStoredData();
 
-	int noNeededEntries = 0;
-	for (int entryId = 0; entryId < noTotalEntries; entryId++)
+	// the queue holds the entries in swap state 1, those not swapped in now stay in it
+	int noNeededEntries = 0, noQueuedEntries = 0;
+	for (int queueIdx = 0; queueIdx < noSwapInEntries; queueIdx++)
 	{
-		if (noNeededEntries >= SDF_TRANSFER_BLOCK_NUM) break;
-		if (swapStates[entryId].state == 1)
+		int entryId = swapInEntryIDs[queueIdx];
+
+		// blocks that could not be reallocated because the local VBA is full stay in the global memory
+		// blocks on disk are read in the background and swapped in on a later frame, new data is combined with them then
+		if (noNeededEntries < globalCache->noTransferBlocks && hashTable[entryId].ptr >= 0 && globalCache->RequestStoredData(entryId))
 		{
 			neededEntryIDs_local[noNeededEntries] = entryId;
 			noNeededEntries++;
 		}
+		else swapInEntryIDs[noQueuedEntries++] = entryId;
 	}
 
+	globalCache->SetNoSwapInEntries(noQueuedEntries);
+
 	// would copy neededEntryIDs_local into neededEntryIDs_global here
 
 	if (noNeededEntries > 0)
@@ -55,7 +66,7 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 			if (globalCache->HasStoredData(entryId))
 			{
 				hasSyncedData_global[i] = true;
-				memcpy(syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3, globalCache->GetStoredVoxelBlock(entryId), SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+				globalCache->GetStoredData(entryId, syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3);
 			}
 		}
 	}
@@ -65,6 +76,17 @@ int ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 	return noNeededEntries;
 }
 
+template<class TVoxel, class TVoxelData>
+static void combineVoxelBlocks(const TVoxelData *srcVB, TVoxelData *dstVB, int maxW)
+{
+	for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
+	{
+		TVoxel dstVoxel = readVoxel(dstVB, vIdx);
+		CombineVoxelInformation<TVoxel::hasColorInformation, TVoxel>::compute(readVoxel(srcVB, vIdx), dstVoxel, maxW);
+		writeVoxel(dstVB, vIdx, dstVoxel);
+	}
+}
+
 template<class TVoxel>
 void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(ITMScene<TVoxel, ITMVoxelBlockHash> *scene, ITMRenderState *renderState)
 {
@@ -80,9 +102,15 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(
 
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
 
+	uchar *entriesVisibleType = ((ITMRenderState_VH*)renderState)->GetEntriesVisibleType();
+	int *swapOutEntryIDs = globalCache->GetSwapOutEntryIDs();
+	int noSwapOutEntries = globalCache->GetNoSwapOutEntries();
+	bool *isQueuedForSwapOut = globalCache->GetIsQueuedForSwapOut();
+
 	int noNeededEntries = this->LoadFromGlobalMemory(scene);
 
-	int maxW = scene->sceneParams->maxW;
+	int maxW = MIN(scene->sceneParams->maxW, TVoxel::W_maxValue());
+	bool useSoAVoxelBlocks = scene->sceneParams->useSoAVoxelBlocks;
 
 	for (int i = 0; i < noNeededEntries; i++)
 	{
@@ -93,14 +121,22 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal(
 			TVoxel *srcVB = syncedVoxelBlocks_local + i * SDF_BLOCK_SIZE3;
 			TVoxel *dstVB = localVBA + hashTable[entryDestId].ptr * SDF_BLOCK_SIZE3;
 
-			for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
-			{
-				CombineVoxelInformation<TVoxel::hasColorInformation, TVoxel>::compute(srcVB[vIdx], dstVB[vIdx], maxW);
-			}
+			// blocks are copied to and from the global memory as they are, i.e. in the layout of the local VBA
+			if (useSoAVoxelBlocks) combineVoxelBlocks<TVoxel>((ITMVoxel_SoA<TVoxel>*)srcVB, (ITMVoxel_SoA<TVoxel>*)dstVB, maxW);
+			else combineVoxelBlocks<TVoxel>(srcVB, dstVB, maxW);
 		}
 
 		swapStates[entryDestId].state = 2;
+
+		// blocks that turned invisible while they waited to be swapped in
+		if (entriesVisibleType[entryDestId] == 0 && !isQueuedForSwapOut[entryDestId])
+		{
+			isQueuedForSwapOut[entryDestId] = true;
+			swapOutEntryIDs[noSwapOutEntries++] = entryDestId;
+		}
 	}
+
+	globalCache->SetNoSwapOutEntries(noSwapOutEntries);
 }
 
 template<class TVoxel>
@@ -123,15 +159,29 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 
 	TVoxel *localVBA = scene->localVBA.GetVoxelBlocks();
 	int *voxelAllocationList = scene->localVBA.GetAllocationList();
+	int *blockNeighbours = scene->index.GetBlockNeighbours();
+	int *blockOccupancy = scene->index.GetBlockOccupancy(), occupancyMask = scene->index.GetBlockOccupancyMask();
 
-	int noTotalEntries = globalCache->noTotalEntries;
+	int *swapOutEntryIDs = globalCache->GetSwapOutEntryIDs();
+	int noSwapOutEntries = globalCache->GetNoSwapOutEntries();
+	bool *isQueuedForSwapOut = globalCache->GetIsQueuedForSwapOut();
 	
-	int noNeededEntries = 0;
+	int noNeededEntries = 0, noQueuedEntries = 0;
 	int noAllocatedVoxelEntries = scene->localVBA.lastFreeBlockId;
+	int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
 
-	for (int entryDestId = 0; entryDestId < noTotalEntries; entryDestId++)
+	for (int queueIdx = 0; queueIdx < noSwapOutEntries; queueIdx++)
 	{
-		if (noNeededEntries >= SDF_TRANSFER_BLOCK_NUM) break;
+		int entryDestId = swapOutEntryIDs[queueIdx];
+
+		if (noNeededEntries >= globalCache->noTransferBlocks)
+		{
+			swapOutEntryIDs[noQueuedEntries++] = entryDestId;
+			continue;
+		}
+
+		// entries that turned visible again, or were removed by the garbage collection, are queued again when needed
+		isQueuedForSwapOut[entryDestId] = false;
 
 		int localPtr = hashTable[entryDestId].ptr;
 		ITMHashSwapState &swapState = swapStates[entryDestId];
@@ -148,13 +198,17 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 			swapStates[entryDestId].state = 0;
 
 			int vbaIdx = noAllocatedVoxelEntries;
-			if (vbaIdx < SDF_BUCKET_NUM - 1)
+			if (vbaIdx < noLocalBlocks - 1)
 			{
 				noAllocatedVoxelEntries++;
+				// the block is cleared when the allocation hands it out again
+				if (blockNeighbours != NULL)
+				{
+					unlinkBlockNeighbours(blockNeighbours, localPtr);
+					updateBlockOccupancy(blockOccupancy, occupancyMask, hashTable[entryDestId].pos.toInt(), -1);
+				}
 				voxelAllocationList[vbaIdx + 1] = localPtr;
 				hashTable[entryDestId].ptr = -1;
-
-				for (int i = 0; i < SDF_BLOCK_SIZE3; i++) localVBALocation[i] = TVoxel();
 			}
 
 			noNeededEntries++;
@@ -162,6 +216,7 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 	}
 
 	scene->localVBA.lastFreeBlockId = noAllocatedVoxelEntries;
+	globalCache->SetNoSwapOutEntries(noQueuedEntries);
 
 	// would copy neededEntryIDs_local, hasSyncedData_local and syncedVoxelBlocks_local into *_global here
 
@@ -175,4 +230,4 @@ void ITMSwappingEngine_CPU<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSce
 	}
 }
 
-template class ITMLib::Engine::ITMSwappingEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMSwappingEngine_CPU)
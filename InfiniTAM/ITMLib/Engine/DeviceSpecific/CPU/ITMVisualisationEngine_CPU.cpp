@@ -12,7 +12,7 @@ using namespace ITMLib::Engine;
 
 template<class TVoxel, class TIndex>
 static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4f *colours, const Vector4f *ptsRay, 
-	const TVoxel *voxelData, const typename TIndex::IndexData *voxelIndex, bool skipPoints, float voxelSize, 
+	const TVoxel *voxelData, const TIndex *index, bool skipPoints, float voxelSize, 
 	Vector2i imgSize, Vector3f lightSource);
 
 template<class TVoxel, class TIndex>
@@ -27,7 +27,23 @@ template<class TVoxel>
 ITMRenderState_VH* ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockHash>::CreateRenderState(const Vector2i & imgSize) const
 {
 	return new ITMRenderState_VH(
-		ITMVoxelBlockHash::noTotalEntries, imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CPU
+		this->scene->index.noTotalEntries, this->scene->index.getNumAllocatedVoxelBlocks(), imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CPU
+	);
+}
+
+template<class TVoxel>
+ITMRenderState_VH* ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::CreateRenderState(const Vector2i & imgSize) const
+{
+	return new ITMRenderState_VH(
+		this->scene->index.noTotalEntries, this->scene->index.getNumAllocatedVoxelBlocks(), imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CPU
+	);
+}
+
+template<class TVoxel>
+ITMRenderState_VH* ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOctree>::CreateRenderState(const Vector2i & imgSize) const
+{
+	return new ITMRenderState_VH(
+		this->scene->index.noTotalEntries, this->scene->index.getNumAllocatedVoxelBlocks(), imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CPU
 	);
 }
 
@@ -36,33 +52,37 @@ void ITMVisualisationEngine_CPU<TVoxel, TIndex>::FindVisibleBlocks(const ITMPose
 {
 }
 
-template<class TVoxel>
-void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
-	ITMRenderState *renderState) const
+template<class TVoxel, class TIndex>
+static void FindVisibleBlocks_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState)
 {
-	const ITMHashEntry *hashTable = this->scene->index.GetEntries();
-	int noTotalEntries = this->scene->index.noTotalEntries;
-	float voxelSize = this->scene->sceneParams->voxelSize;
+	const typename TIndex::IndexData *hashTable = scene->index.getIndexData();
+	const int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+	int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
+	float voxelSize = scene->sceneParams->voxelSize;
 	Vector2i imgSize = renderState->renderingRangeImage->noDims;
 
 	Matrix4f M = pose->GetM();
 	Vector4f projParams = intrinsics->projectionParamsSimple.all;
 
 	ITMRenderState_VH *renderState_vh = (ITMRenderState_VH*)renderState;
+	renderState_vh->Resize(scene->index.noTotalEntries, scene->index.getNumAllocatedVoxelBlocks());
 
 	int noVisibleEntries = 0;
 	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
 
 	//build visible list
-	for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+	for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
 	{
+		int targetIdx = allocatedEntryIDs[listIdx];
 		unsigned char hashVisibleType = 0;// = entriesVisibleType[targetIdx];
-		const ITMHashEntry &hashEntry = hashTable[targetIdx];
+		ITMBlockPos blockPos; int blockPtr;
+		readBlockEntry(hashTable, targetIdx, blockPos, blockPtr);
 
-		if (hashEntry.ptr >= 0)
+		if (blockPtr >= 0)
 		{
 			bool isVisible, isVisibleEnlarged;
-			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M, projParams, voxelSize, imgSize);
+			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, blockPos.toInt(), M, projParams, voxelSize, imgSize);
 			hashVisibleType = isVisible;
 		}
 
@@ -76,6 +96,27 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::FindVisibleBlocks(con
 	renderState_vh->noVisibleEntries = noVisibleEntries;
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	FindVisibleBlocks_common(this->scene, pose, intrinsics, renderState);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	FindVisibleBlocks_common(this->scene, pose, intrinsics, renderState);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOctree>::FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	FindVisibleBlocks_common(this->scene, pose, intrinsics, renderState);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel, TIndex>::CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const
 {
@@ -90,9 +131,9 @@ void ITMVisualisationEngine_CPU<TVoxel, TIndex>::CreateExpectedDepths(const ITMP
 	}
 }
 
-template<class TVoxel>
-void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
-	ITMRenderState *renderState) const
+template<class TVoxel, class TIndex>
+static void CreateExpectedDepths_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState)
 {
 	Vector2i imgSize = renderState->renderingRangeImage->noDims;
 	Vector2f *minmaxData = renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
@@ -103,7 +144,7 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepths(
 		pixel.y = VERY_CLOSE;
 	}
 
-	float voxelSize = this->scene->sceneParams->voxelSize;
+	float voxelSize = scene->sceneParams->voxelSize;
 
 	std::vector<RenderingBlock> renderingBlocks(MAX_RENDERING_BLOCKS);
 	int numRenderingBlocks = 0;
@@ -115,13 +156,14 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepths(
 
 	//go through list of visible 8x8x8 blocks
 	for (int blockNo = 0; blockNo < noVisibleEntries; ++blockNo) {
-		const ITMHashEntry & blockData(this->scene->index.GetEntries()[visibleEntryIDs[blockNo]]);
+		ITMBlockPos blockPos; int blockPtr;
+		readBlockEntry(scene->index.getIndexData(), visibleEntryIDs[blockNo], blockPos, blockPtr);
 
 		Vector2i upperLeft, lowerRight;
 		Vector2f zRange;
 		bool validProjection = false;
-		if (blockData.ptr>=0) {
-			validProjection = ProjectSingleBlock(blockData.pos, pose->GetM(), intrinsics->projectionParamsSimple.all, imgSize, voxelSize, upperLeft, lowerRight, zRange);
+		if (blockPtr>=0) {
+			validProjection = ProjectSingleBlock(blockPos.toInt(), pose->GetM(), intrinsics->projectionParamsSimple.all, imgSize, voxelSize, upperLeft, lowerRight, zRange);
 		}
 		if (!validProjection) continue;
 
@@ -151,8 +193,30 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepths(
 	}
 }
 
-template<class TVoxel, class TIndex>
-static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i& imgSize, const Matrix4f& invM, Vector4f projParams, const ITMRenderState *renderState)
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	CreateExpectedDepths_common(this->scene, pose, intrinsics, renderState);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	CreateExpectedDepths_common(this->scene, pose, intrinsics, renderState);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOctree>::CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	ITMRenderState *renderState) const
+{
+	CreateExpectedDepths_common(this->scene, pose, intrinsics, renderState);
+}
+
+template<class TVoxel, class TIndex, class TVoxelData>
+static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const TVoxelData *voxelData, const Vector2i& imgSize, const Matrix4f& invM,
+	Vector4f projParams, const ITMRenderState *renderState)
 {
 	projParams.x = 1.0f / projParams.x;
 	projParams.y = 1.0f / projParams.y;
@@ -161,8 +225,8 @@ static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i&
 	float mu = scene->sceneParams->mu;
 	float oneOverVoxelSize = 1.0f / scene->sceneParams->voxelSize;
 	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
-	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	const typename ITMIndexCache_CPU<TIndex>::Type emptyCache = ITMIndexCache_CPU<TIndex>::create(&scene->index);
 
 #ifdef WITH_OPENMP
 	#pragma omp parallel for
@@ -172,8 +236,9 @@ static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i&
 		int y = locId/imgSize.x;
 		int x = locId - y*imgSize.x;
 		int locId2 = (int)floor((float)x / minmaximg_subsample) + (int)floor((float)y / minmaximg_subsample) * imgSize.x;
+		typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
 
-		castRay<TVoxel, TIndex>(
+		castRay<TVoxelData, TIndex>(
 			pointsRay[locId],
 			x, y,
 			voxelData,
@@ -182,25 +247,34 @@ static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i&
 			projParams,
 			oneOverVoxelSize,
 			mu,
-			minmaximg[locId2]
+			minmaximg[locId2],
+			cache
 		);
 	}
 }
 
 template<class TVoxel, class TIndex>
-static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+static void GenericRaycast(const ITMScene<TVoxel,TIndex> *scene, const Vector2i& imgSize, const Matrix4f& invM, Vector4f projParams, const ITMRenderState *renderState)
+{
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) GenericRaycast(scene, (const ITMVoxel_SoA<TVoxel>*)voxelData, imgSize, invM, projParams, renderState);
+	else GenericRaycast(scene, voxelData, imgSize, invM, projParams, renderState);
+}
+
+template<class TVoxel, class TIndex, class TVoxelData>
+static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const TVoxelData *voxelData, const ITMPose *pose, const ITMIntrinsics *intrinsics, 
 	const ITMRenderState *renderState, ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type)
 {
 	Vector2i imgSize = outputImage->noDims;
 	Matrix4f invM = pose->GetInvM();
 
-	GenericRaycast(scene, imgSize, invM, intrinsics->projectionParamsSimple.all, renderState);
+	GenericRaycast(scene, voxelData, imgSize, invM, intrinsics->projectionParamsSimple.all, renderState);
 
 	Vector3f lightSource = -Vector3f(invM.getColumn(2));
 	Vector4u *outRendering = outputImage->GetData(MEMORYDEVICE_CPU);
 	Vector4f *pointsRay = renderState->raycastResult->GetData(MEMORYDEVICE_CPU);
-	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	const typename ITMIndexCache_CPU<TIndex>::Type emptyCache = ITMIndexCache_CPU<TIndex>::create(&scene->index);
 
 	if ((type == IITMVisualisationEngine::RENDER_COLOUR_FROM_VOLUME)&&
 	    (!TVoxel::hasColorInformation)) type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE;
@@ -213,7 +287,8 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPo
 		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
 		{
 			Vector4f ptRay = pointsRay[locId];
-			processPixelColour<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
+			typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
+			processPixelColour<TVoxelData, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource, cache);
 		}
 		break;
 	case IITMVisualisationEngine::RENDER_COLOUR_FROM_NORMAL:
@@ -223,7 +298,8 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPo
 		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
 		{
 			Vector4f ptRay = pointsRay[locId];
-			processPixelNormal<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
+			typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
+			processPixelNormal<TVoxelData, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource, cache);
 		}
 		break;
 	case IITMVisualisationEngine::RENDER_SHADED_GREYSCALE:
@@ -234,28 +310,38 @@ static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPo
 		for (int locId = 0; locId < imgSize.x * imgSize.y; locId++)
 		{
 			Vector4f ptRay = pointsRay[locId];
-			processPixelGrey<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
+			typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
+			processPixelGrey<TVoxelData, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource, cache);
 		}
 	}
 }
 
 template<class TVoxel, class TIndex>
-static void CreatePointCloud_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, 
+static void RenderImage_common(const ITMScene<TVoxel,TIndex> *scene, const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState, ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type)
+{
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) RenderImage_common(scene, (const ITMVoxel_SoA<TVoxel>*)voxelData, pose, intrinsics, renderState, outputImage, type);
+	else RenderImage_common(scene, voxelData, pose, intrinsics, renderState, outputImage, type);
+}
+
+template<class TVoxel, class TIndex, class TVoxelData>
+static void CreatePointCloud_common(const ITMScene<TVoxel,TIndex> *scene, const TVoxelData *voxelData, const ITMView *view, ITMTrackingState *trackingState, 
 	ITMRenderState *renderState, bool skipPoints)
 {
 	Vector2i imgSize = renderState->raycastResult->noDims;
 	Matrix4f invM = trackingState->pose_d->GetInvM() * view->calib->trafo_rgb_to_depth.calib;
 
-	GenericRaycast(scene, imgSize, invM, view->calib->intrinsics_rgb.projectionParamsSimple.all, renderState);
+	GenericRaycast(scene, voxelData, imgSize, invM, view->calib->intrinsics_rgb.projectionParamsSimple.all, renderState);
 	trackingState->pose_pointCloud->SetFrom(trackingState->pose_d);
 
-	trackingState->pointCloud->noTotalPoints = RenderPointCloud<TVoxel, TIndex>(
+	trackingState->pointCloud->noTotalPoints = RenderPointCloud<TVoxelData, TIndex>(
 		renderState->raycastImage->GetData(MEMORYDEVICE_CPU),
 		trackingState->pointCloud->locations->GetData(MEMORYDEVICE_CPU),
 		trackingState->pointCloud->colours->GetData(MEMORYDEVICE_CPU),
 		renderState->raycastResult->GetData(MEMORYDEVICE_CPU),
-		scene->localVBA.GetVoxelBlocks(),
-		scene->index.getIndexData(),
+		voxelData,
+		&scene->index,
 		skipPoints,
 		scene->sceneParams->voxelSize,
 		imgSize,
@@ -263,6 +349,15 @@ static void CreatePointCloud_common(const ITMScene<TVoxel,TIndex> *scene, const
 	);
 }
 
+template<class TVoxel, class TIndex>
+static void CreatePointCloud_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, 
+	ITMRenderState *renderState, bool skipPoints)
+{
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) CreatePointCloud_common(scene, (const ITMVoxel_SoA<TVoxel>*)voxelData, view, trackingState, renderState, skipPoints);
+	else CreatePointCloud_common(scene, voxelData, view, trackingState, renderState, skipPoints);
+}
+
 template<class TVoxel, class TIndex>
 static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState)
 {
@@ -286,8 +381,9 @@ static void CreateICPMaps_common(const ITMScene<TVoxel,TIndex> *scene, const ITM
 		processPixelICP<true>(outRendering, pointsMap, normalsMap, pointsRay, imgSize, x, y, voxelSize, lightSource);
 }
 
-template<class TVoxel, class TIndex>
-static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState)
+template<class TVoxel, class TIndex, class TVoxelData>
+static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const TVoxelData *voxelData, const ITMView *view, ITMTrackingState *trackingState,
+	ITMRenderState *renderState)
 {
 	Vector2i imgSize = renderState->raycastResult->noDims;
 	Matrix4f M = trackingState->pose_d->GetM();
@@ -305,8 +401,8 @@ static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const IT
 	Vector4u *outRendering = renderState->raycastImage->GetData(MEMORYDEVICE_CPU);
 	const Vector2f *minmaximg = renderState->renderingRangeImage->GetData(MEMORYDEVICE_CPU);
 	float voxelSize = scene->sceneParams->voxelSize;
-	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
 	const typename TIndex::IndexData *voxelIndex = scene->index.getIndexData();
+	const typename ITMIndexCache_CPU<TIndex>::Type emptyCache = ITMIndexCache_CPU<TIndex>::create(&scene->index);
 
 	renderState->forwardProjection->Clear();
 
@@ -344,15 +440,24 @@ static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const IT
 		int locId = fwdProjMissingPoints[pointId];
 		int y = locId / imgSize.x, x = locId - y*imgSize.x;
 		int locId2 = (int)floor((float)x / minmaximg_subsample) + (int)floor((float)y / minmaximg_subsample) * imgSize.x;
+		typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
 
-		castRay<TVoxel, TIndex>(forwardProjection[locId], x, y, voxelData, voxelIndex, invM, invProjParams,
-			1.0f / scene->sceneParams->voxelSize, scene->sceneParams->mu, minmaximg[locId2]);
+		castRay<TVoxelData, TIndex>(forwardProjection[locId], x, y, voxelData, voxelIndex, invM, invProjParams,
+			1.0f / scene->sceneParams->voxelSize, scene->sceneParams->mu, minmaximg[locId2], cache);
 	}
 
 	for (int y = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++)
 		processPixelForwardRender<true>(outRendering, forwardProjection, imgSize, x, y, voxelSize, lightSource);
 }
 
+template<class TVoxel, class TIndex>
+static void ForwardRender_common(const ITMScene<TVoxel, TIndex> *scene, const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState)
+{
+	const TVoxel *voxelData = scene->localVBA.GetVoxelBlocks();
+	if (scene->sceneParams->useSoAVoxelBlocks) ForwardRender_common(scene, (const ITMVoxel_SoA<TVoxel>*)voxelData, view, trackingState, renderState);
+	else ForwardRender_common(scene, voxelData, view, trackingState, renderState);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel,TIndex>::RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
 	const ITMRenderState *renderState, ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type) const
@@ -367,6 +472,20 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::RenderImage(const ITM
 	RenderImage_common(this->scene, pose, intrinsics, renderState, outputImage, type);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::RenderImage(const ITMPose *pose,  const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState, ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type) const
+{
+	RenderImage_common(this->scene, pose, intrinsics, renderState, outputImage, type);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOctree>::RenderImage(const ITMPose *pose,  const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState, ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type) const
+{
+	RenderImage_common(this->scene, pose, intrinsics, renderState, outputImage, type);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel, TIndex>::FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const
 {
@@ -380,6 +499,20 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::FindSurface(const ITM
 	GenericRaycast(this->scene, renderState->raycastResult->noDims, pose->GetInvM(), intrinsics->projectionParamsSimple.all, renderState);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState) const
+{
+	GenericRaycast(this->scene, renderState->raycastResult->noDims, pose->GetInvM(), intrinsics->projectionParamsSimple.all, renderState);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOctree>::FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, 
+	const ITMRenderState *renderState) const
+{
+	GenericRaycast(this->scene, renderState->raycastResult->noDims, pose->GetInvM(), intrinsics->projectionParamsSimple.all, renderState);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel,TIndex>::CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, 
 	ITMRenderState *renderState, bool skipPoints) const
@@ -394,6 +527,20 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreatePointCloud(cons
 	CreatePointCloud_common(this->scene, view, trackingState, renderState, skipPoints);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, 
+	ITMRenderState *renderState, bool skipPoints) const
+{
+	CreatePointCloud_common(this->scene, view, trackingState, renderState, skipPoints);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOctree>::CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, 
+	ITMRenderState *renderState, bool skipPoints) const
+{
+	CreatePointCloud_common(this->scene, view, trackingState, renderState, skipPoints);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel,TIndex>::CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const
 {
@@ -407,6 +554,20 @@ void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockHash>::CreateICPMaps(const I
 	CreateICPMaps_common(this->scene, view, trackingState, renderState);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOpenHash>::CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, 
+	ITMRenderState *renderState) const
+{
+	CreateICPMaps_common(this->scene, view, trackingState, renderState);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel,ITMVoxelBlockOctree>::CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, 
+	ITMRenderState *renderState) const
+{
+	CreateICPMaps_common(this->scene, view, trackingState, renderState);
+}
+
 template<class TVoxel, class TIndex>
 void ITMVisualisationEngine_CPU<TVoxel, TIndex>::ForwardRender(const ITMView *view, ITMTrackingState *trackingState, 
 	ITMRenderState *renderState) const
@@ -421,11 +582,27 @@ void ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockHash>::ForwardRender(const
 	ForwardRender_common(this->scene, view, trackingState, renderState);
 }
 
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOpenHash>::ForwardRender(const ITMView *view, ITMTrackingState *trackingState,
+	ITMRenderState *renderState) const
+{
+	ForwardRender_common(this->scene, view, trackingState, renderState);
+}
+
+template<class TVoxel>
+void ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOctree>::ForwardRender(const ITMView *view, ITMTrackingState *trackingState,
+	ITMRenderState *renderState) const
+{
+	ForwardRender_common(this->scene, view, trackingState, renderState);
+}
+
 template<class TVoxel, class TIndex>
 static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4f *colours, const Vector4f *ptsRay, 
-	const TVoxel *voxelData, const typename TIndex::IndexData *voxelIndex, bool skipPoints, float voxelSize, 
+	const TVoxel *voxelData, const TIndex *index, bool skipPoints, float voxelSize, 
 	Vector2i imgSize, Vector3f lightSource)
 {
+	const typename TIndex::IndexData *voxelIndex = index->getIndexData();
+	const typename ITMIndexCache_CPU<TIndex>::Type emptyCache = ITMIndexCache_CPU<TIndex>::create(index);
 	int noTotalPoints = 0;
 
 	for (int y = 0, locId = 0; y < imgSize.y; y++) for (int x = 0; x < imgSize.x; x++, locId++)
@@ -434,8 +611,9 @@ static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4
 		Vector4f pointRay = ptsRay[locId];
 		Vector3f point = pointRay.toVector3();
 		bool foundPoint = pointRay.w > 0;
+		typename ITMIndexCache_CPU<TIndex>::Type cache = emptyCache;
 
-		computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle);
+		computeNormalAndAngle<TVoxel, TIndex>(foundPoint, point, voxelData, voxelIndex, lightSource, outNormal, angle, cache);
 
 		if (foundPoint) drawPixelGrey(outRendering[locId], angle);
 		else outRendering[locId] = Vector4u((uchar)0);
@@ -445,7 +623,7 @@ static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4
 		if (foundPoint)
 		{
 			Vector4f tmp;
-			tmp = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate(voxelData, voxelIndex, point);
+			tmp = VoxelColorReader<TVoxel::hasColorInformation, TVoxel, TIndex>::interpolate(voxelData, voxelIndex, point, cache);
 			if (tmp.w > 0.0f) { tmp.x /= tmp.w; tmp.y /= tmp.w; tmp.z /= tmp.w; tmp.w = 1.0f; }
 			colours[noTotalPoints] = tmp;
 
@@ -461,4 +639,4 @@ static int RenderPointCloud(Vector4u *outRendering, Vector4f *locations, Vector4
 	return noTotalPoints;
 }
 
-template class ITMLib::Engine::ITMVisualisationEngine_CPU<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMVisualisationEngine_CPU)
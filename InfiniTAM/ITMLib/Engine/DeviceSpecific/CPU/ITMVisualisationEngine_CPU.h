@@ -46,5 +46,45 @@ namespace ITMLib
 
 			ITMRenderState_VH* CreateRenderState(const Vector2i & imgSize) const;
 		};
+
+		template<class TVoxel>
+		class ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOpenHash> : public ITMVisualisationEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		public:
+			explicit ITMVisualisationEngine_CPU(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene) 
+				: ITMVisualisationEngine<TVoxel, ITMVoxelBlockOpenHash>(scene) { }
+			~ITMVisualisationEngine_CPU(void) { }
+
+			void FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
+			void CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
+			void RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState, 
+				ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
+			void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const;
+			void CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState, bool skipPoints) const;
+			void CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
+			void ForwardRender(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
+
+			ITMRenderState_VH* CreateRenderState(const Vector2i & imgSize) const;
+		};
+
+		template<class TVoxel>
+		class ITMVisualisationEngine_CPU<TVoxel, ITMVoxelBlockOctree> : public ITMVisualisationEngine < TVoxel, ITMVoxelBlockOctree >
+		{
+		public:
+			explicit ITMVisualisationEngine_CPU(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene) 
+				: ITMVisualisationEngine<TVoxel, ITMVoxelBlockOctree>(scene) { }
+			~ITMVisualisationEngine_CPU(void) { }
+
+			void FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
+			void CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const;
+			void RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState, 
+				ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const;
+			void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const;
+			void CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState, bool skipPoints) const;
+			void CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
+			void ForwardRender(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const;
+
+			ITMRenderState_VH* CreateRenderState(const Vector2i & imgSize) const;
+		};
 	}
 }
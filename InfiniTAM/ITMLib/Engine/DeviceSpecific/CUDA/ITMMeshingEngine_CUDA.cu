@@ -7,17 +7,19 @@
 #include "../../../../ORUtils/CUDADefines.h"
 
 template<class TVoxel>
-__global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noTriangles_device, float factor, int noTotalEntries,
-	int noMaxTriangles, const Vector4s *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMHashEntry *hashTable);
+__global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noTriangles_device, float factor, Vector3f origin, int noTotalEntries,
+	int noMaxTriangles, const ITMBlockCoords *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMHashEntry *hashTable);
 
-__global__ void findAllocateBlocks(Vector4s *visibleBlockGlobalPos, const ITMHashEntry *hashTable, int noTotalEntries);
+__global__ void findAllocateBlocks(ITMBlockCoords *visibleBlockGlobalPos, const ITMHashEntry *hashTable, int noTotalEntries);
 
 using namespace ITMLib::Engine;
 
 template<class TVoxel>
 ITMMeshingEngine_CUDA<TVoxel,ITMVoxelBlockHash>::ITMMeshingEngine_CUDA(void) 
 {
-	ITMSafeCall(cudaMalloc((void**)&visibleBlockGlobalPos_device, SDF_LOCAL_BLOCK_NUM * sizeof(Vector4s)));
+	// sized to the scene's voxel block array in MeshScene
+	visibleBlockGlobalPos_device = NULL;
+	noBlockGlobalPos = 0;
 	ITMSafeCall(cudaMalloc((void**)&noTriangles_device, sizeof(unsigned int)));
 }
 
@@ -37,9 +39,20 @@ void ITMMeshingEngine_CUDA<TVoxel, ITMVoxelBlockHash>::MeshScene(ITMMesh *mesh,
 
 	int noMaxTriangles = mesh->noMaxTriangles, noTotalEntries = scene->index.noTotalEntries;
 	float factor = scene->sceneParams->voxelSize;
+	// the triangles are put back where the scene was before it was recentered
+	Vector3f origin = scene->blockOrigin.toFloat() * (factor * SDF_BLOCK_SIZE);
+
+	// one cuda block per voxel block, laid out on a (n / 16) x 16 grid
+	int noGridRows = (scene->index.getNumAllocatedVoxelBlocks() + 15) / 16;
+	if (noBlockGlobalPos != noGridRows * 16)
+	{
+		noBlockGlobalPos = noGridRows * 16;
+		ITMSafeCall(cudaFree(visibleBlockGlobalPos_device));
+		ITMSafeCall(cudaMalloc((void**)&visibleBlockGlobalPos_device, noBlockGlobalPos * sizeof(ITMBlockCoords)));
+	}
 
 	ITMSafeCall(cudaMemset(noTriangles_device, 0, sizeof(unsigned int)));
-	ITMSafeCall(cudaMemset(visibleBlockGlobalPos_device, 0, sizeof(Vector4s) * SDF_LOCAL_BLOCK_NUM));
+	ITMSafeCall(cudaMemset(visibleBlockGlobalPos_device, 0, sizeof(ITMBlockCoords) * noBlockGlobalPos));
 
 	{ // identify used voxel blocks
 		dim3 cudaBlockSize(256); 
@@ -50,9 +63,9 @@ void ITMMeshingEngine_CUDA<TVoxel, ITMVoxelBlockHash>::MeshScene(ITMMesh *mesh,
 
 	{ // mesh used voxel blocks
 		dim3 cudaBlockSize(SDF_BLOCK_SIZE, SDF_BLOCK_SIZE, SDF_BLOCK_SIZE);
-		dim3 gridSize(SDF_LOCAL_BLOCK_NUM / 16, 16);
+		dim3 gridSize(noGridRows, 16);
 
-		meshScene_device<TVoxel> << <gridSize, cudaBlockSize >> >(triangles, noTriangles_device, factor, noTotalEntries, noMaxTriangles,
+		meshScene_device<TVoxel> << <gridSize, cudaBlockSize >> >(triangles, noTriangles_device, factor, origin, noTotalEntries, noMaxTriangles,
 			visibleBlockGlobalPos_device, localVBA, hashTable);
 
 		ITMSafeCall(cudaMemcpy(&mesh->noTotalTriangles, noTriangles_device, sizeof(unsigned int), cudaMemcpyDeviceToHost));
@@ -71,7 +84,7 @@ template<class TVoxel>
 void ITMMeshingEngine_CUDA<TVoxel, ITMPlainVoxelArray>::MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMPlainVoxelArray> *scene)
 {}
 
-__global__ void findAllocateBlocks(Vector4s *visibleBlockGlobalPos, const ITMHashEntry *hashTable, int noTotalEntries)
+__global__ void findAllocateBlocks(ITMBlockCoords *visibleBlockGlobalPos, const ITMHashEntry *hashTable, int noTotalEntries)
 {
 	int entryId = threadIdx.x + blockIdx.x * blockDim.x;
 	if (entryId > noTotalEntries - 1) return;
@@ -79,21 +92,25 @@ __global__ void findAllocateBlocks(Vector4s *visibleBlockGlobalPos, const ITMHas
 	const ITMHashEntry &currentHashEntry = hashTable[entryId];
 
 	if (currentHashEntry.ptr >= 0) 
-		visibleBlockGlobalPos[currentHashEntry.ptr] = Vector4s(currentHashEntry.pos.x, currentHashEntry.pos.y, currentHashEntry.pos.z, 1);
+	{
+		Vector3i blockPos = currentHashEntry.pos.toInt();
+		visibleBlockGlobalPos[currentHashEntry.ptr] = ITMBlockCoords(blockPos.x, blockPos.y, blockPos.z, 1);
+	}
 }
 
 template<class TVoxel>
-__global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noTriangles_device, float factor, int noTotalEntries, 
-	int noMaxTriangles, const Vector4s *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMHashEntry *hashTable)
+__global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noTriangles_device, float factor, Vector3f origin, int noTotalEntries,
+	int noMaxTriangles, const ITMBlockCoords *visibleBlockGlobalPos, const TVoxel *localVBA, const ITMHashEntry *hashTable)
 {
-	const Vector4s globalPos_4s = visibleBlockGlobalPos[blockIdx.x + gridDim.x * blockIdx.y];
+	const ITMBlockCoords globalPos_4s = visibleBlockGlobalPos[blockIdx.x + gridDim.x * blockIdx.y];
 
 	if (globalPos_4s.w == 0) return;
 
 	Vector3i globalPos = Vector3i(globalPos_4s.x, globalPos_4s.y, globalPos_4s.z) * SDF_BLOCK_SIZE;
 
 	Vector3f vertList[12];
-	int cubeIndex = buildVertList(vertList, globalPos, Vector3i(threadIdx.x, threadIdx.y, threadIdx.z), localVBA, hashTable);
+	ITMVoxelBlockHash::IndexCache cache;
+	int cubeIndex = buildVertList(vertList, globalPos, Vector3i(threadIdx.x, threadIdx.y, threadIdx.z), localVBA, hashTable, cache);
 
 	if (cubeIndex < 0) return;
 
@@ -103,11 +120,11 @@ __global__ void meshScene_device(ITMMesh::Triangle *triangles, unsigned int *noT
 
 		if (triangleId < noMaxTriangles - 1)
 		{
-			triangles[triangleId].p0 = vertList[triangleTable[cubeIndex][i]] * factor;
-			triangles[triangleId].p1 = vertList[triangleTable[cubeIndex][i + 1]] * factor;
-			triangles[triangleId].p2 = vertList[triangleTable[cubeIndex][i + 2]] * factor;
+			triangles[triangleId].p0 = vertList[triangleTable[cubeIndex][i]] * factor + origin;
+			triangles[triangleId].p1 = vertList[triangleTable[cubeIndex][i + 1]] * factor + origin;
+			triangles[triangleId].p2 = vertList[triangleTable[cubeIndex][i + 2]] * factor + origin;
 		}
 	}
 }
 
-template class ITMLib::Engine::ITMMeshingEngine_CUDA<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMMeshingEngine_CUDA)
@@ -17,7 +17,8 @@ namespace ITMLib
 		{
 		private:
 			unsigned int  *noTriangles_device;
-			Vector4s *visibleBlockGlobalPos_device;
+			ITMBlockCoords *visibleBlockGlobalPos_device;
+			int noBlockGlobalPos;
 
 		public:
 			void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
@@ -26,6 +27,28 @@ namespace ITMLib
 			~ITMMeshingEngine_CUDA(void);
 		};
 
+		/** The open addressing hash is only implemented by the CPU
+		engines, ITMMainEngine falls back to the voxel block hash on
+		CUDA devices.
+		*/
+		template<class TVoxel>
+		class ITMMeshingEngine_CUDA<TVoxel, ITMVoxelBlockOpenHash> : public ITMMeshingEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		public:
+			void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene) { }
+		};
+
+		/** The voxel block octree is only implemented by the CPU
+		engines, ITMMainEngine falls back to the voxel block hash on
+		CUDA devices.
+		*/
+		template<class TVoxel>
+		class ITMMeshingEngine_CUDA<TVoxel, ITMVoxelBlockOctree> : public ITMMeshingEngine < TVoxel, ITMVoxelBlockOctree >
+		{
+		public:
+			void MeshScene(ITMMesh *mesh, const ITMScene<TVoxel, ITMVoxelBlockOctree> *scene) { }
+		};
+
 		template<class TVoxel>
 		class ITMMeshingEngine_CUDA<TVoxel, ITMPlainVoxelArray> : public ITMMeshingEngine < TVoxel, ITMPlainVoxelArray >
 		{
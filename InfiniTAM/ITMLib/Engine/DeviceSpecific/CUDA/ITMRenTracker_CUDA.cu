@@ -174,7 +174,8 @@ __global__ void renTrackerOneLevel_f_device(float *f_device, Vector4f *ptList, i
 	if (locId_global < count)
 	{
 		Vector4f inpt = ptList[locId_global];
-		if (inpt.w > -1.0f) dim_shared[locId_local] = computePerPixelEnergy<TVoxel,TIndex>(inpt, voxelBlocks, index, oneOverVoxelSize, invM);
+		typename TIndex::IndexCache cache;
+		if (inpt.w > -1.0f) dim_shared[locId_local] = computePerPixelEnergy<TVoxel,TIndex>(inpt, voxelBlocks, index, oneOverVoxelSize, invM, cache);
 	}
 	
 	{ //reduction for f_device
@@ -210,9 +211,10 @@ __global__ void renTrackerOneLevel_g_device(float *g_device, float *h_device, Ve
 	if (locId_global < count)
 	{
 		Vector4f cPt = ptList[locId_global];
+		typename TIndex::IndexCache cache;
 		if (cPt.w > -1.0f)
 		{
-			if (computePerPixelJacobian<TVoxel,TIndex>(localGradient, cPt, voxelBlocks, index, oneOverVoxelSize, invM))
+			if (computePerPixelJacobian<TVoxel,TIndex>(localGradient, cPt, voxelBlocks, index, oneOverVoxelSize, invM, cache))
 			{
 				shouldAdd = true; hasValidData = true;
 				for (int r = 0, counter = 0; r < noPara; r++) for (int c = 0; c <= r; c++, counter++)
@@ -277,4 +279,4 @@ __global__ void renTrackerOneLevel_g_device(float *g_device, float *h_device, Ve
 	//}
 }
 
-template class ITMLib::Engine::ITMRenTracker_CUDA<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMRenTracker_CUDA)
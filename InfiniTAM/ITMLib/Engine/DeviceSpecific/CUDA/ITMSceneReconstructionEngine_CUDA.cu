@@ -9,6 +9,7 @@ struct AllocationTempData {
 	int noAllocatedVoxelEntries;
 	int noAllocatedExcessEntries;
 	int noVisibleEntries;
+	int noAllocatedEntries;
 };
 
 using namespace ITMLib::Engine;
@@ -23,12 +24,12 @@ __global__ void integrateIntoScene_device(TVoxel *voxelArray, const ITMPlainVoxe
 	const Vector4u *rgb, Vector2i rgbImgSize, const float *depth, Vector2i depthImgSize, Matrix4f M_d, Matrix4f M_rgb, Vector4f projParams_d, 
 	Vector4f projParams_rgb, float _voxelSize, float mu, int maxW);
 
-__global__ void buildHashAllocAndVisibleType_device(uchar *entriesAllocType, uchar *entriesVisibleType, Vector4s *blockCoords, const float *depth,
+__global__ void buildHashAllocAndVisibleType_device(uchar *entriesAllocType, uchar *entriesVisibleType, ITMBlockCoords *blockCoords, const float *depth,
 	Matrix4f invM_d, Vector4f projParams_d, float mu, Vector2i _imgSize, float _voxelSize, ITMHashEntry *hashTable, float viewFrustum_min,
 	float viewFrustrum_max);
 
 __global__ void allocateVoxelBlocksList_device(int *voxelAllocationList, int *excessAllocationList, ITMHashEntry *hashTable, int noTotalEntries,
-	AllocationTempData *allocData, uchar *entriesAllocType, uchar *entriesVisibleType, Vector4s *blockCoords);
+	AllocationTempData *allocData, uchar *entriesAllocType, uchar *entriesVisibleType, ITMBlockCoords *blockCoords, int *allocatedEntryIDs);
 
 __global__ void reAllocateSwappedOutVoxelBlocks_device(int *voxelAllocationList, ITMHashEntry *hashTable, int noTotalEntries,
 	AllocationTempData *allocData, uchar *entriesVisibleType);
@@ -36,7 +37,7 @@ __global__ void reAllocateSwappedOutVoxelBlocks_device(int *voxelAllocationList,
 __global__ void setToType3(uchar *entriesVisibleType, int *visibleEntryIDs, int noVisibleEntries);
 
 template<bool useSwapping>
-__global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapState *swapStates, int noTotalEntries,
+__global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapState *swapStates, int noTotalEntries, int noLocalBlocks,
 	int *visibleEntryIDs, AllocationTempData *allocData, uchar *entriesVisibleType,
 	Matrix4f M_d, Vector4f projParams_d, Vector2i depthImgSize, float voxelSize);
 
@@ -48,9 +49,9 @@ ITMSceneReconstructionEngine_CUDA<TVoxel,ITMVoxelBlockHash>::ITMSceneReconstruct
 	ITMSafeCall(cudaMalloc((void**)&allocationTempData_device, sizeof(AllocationTempData)));
 	ITMSafeCall(cudaMallocHost((void**)&allocationTempData_host, sizeof(AllocationTempData)));
 
-	int noTotalEntries = ITMVoxelBlockHash::noTotalEntries;
-	ITMSafeCall(cudaMalloc((void**)&entriesAllocType_device, noTotalEntries));
-	ITMSafeCall(cudaMalloc((void**)&blockCoords_device, noTotalEntries * sizeof(Vector4s)));
+	// sized to the scene's hash table in ResetScene
+	entriesAllocType_device = NULL;
+	blockCoords_device = NULL;
 }
 
 template<class TVoxel>
@@ -80,9 +81,20 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel,ITMVoxelBlockHash>::ResetScene(ITM
 	ITMHashEntry *hashEntry_ptr = scene->index.GetEntries();
 	memsetKernel<ITMHashEntry>(hashEntry_ptr, tmpEntry, scene->index.noTotalEntries);
 	int *excessList_ptr = scene->index.GetExcessAllocationList();
-	fillArrayKernel<int>(excessList_ptr, SDF_EXCESS_LIST_SIZE);
+	int noExcessEntries = scene->index.GetExcessListSize();
+	fillArrayKernel<int>(excessList_ptr, noExcessEntries);
+
+	scene->index.SetLastFreeExcessListId(noExcessEntries - 1);
+	scene->index.SetNoAllocatedEntries(0);
 
-	scene->index.SetLastFreeExcessListId(SDF_EXCESS_LIST_SIZE - 1);
+	// the swap queues and stored blocks refer to the entries just removed
+	if (scene->useSwapping) scene->globalCache->Reset();
+
+	int noTotalEntries = scene->index.noTotalEntries;
+	ITMSafeCall(cudaFree(entriesAllocType_device));
+	ITMSafeCall(cudaFree(blockCoords_device));
+	ITMSafeCall(cudaMalloc((void**)&entriesAllocType_device, noTotalEntries));
+	ITMSafeCall(cudaMalloc((void**)&blockCoords_device, noTotalEntries * sizeof(ITMBlockCoords)));
 }
 
 template<class TVoxel>
@@ -113,6 +125,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 	ITMHashSwapState *swapStates = scene->useSwapping ? scene->globalCache->GetSwapStates(true) : 0;
 
 	int noTotalEntries = scene->index.noTotalEntries;
+	int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
 
 	int *visibleEntryIDs = renderState_vh->GetVisibleEntryIDs();
 	uchar *entriesVisibleType = renderState_vh->GetEntriesVisibleType();
@@ -132,6 +145,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 	tempData->noAllocatedVoxelEntries = scene->localVBA.lastFreeBlockId;
 	tempData->noAllocatedExcessEntries = scene->index.GetLastFreeExcessListId();
 	tempData->noVisibleEntries = 0;
+	tempData->noAllocatedEntries = scene->index.GetNoAllocatedEntries();
 	ITMSafeCall(cudaMemcpyAsync(allocationTempData_device, tempData, sizeof(AllocationTempData), cudaMemcpyHostToDevice));
 
 	ITMSafeCall(cudaMemsetAsync(entriesAllocType_device, 0, sizeof(unsigned char)* noTotalEntries));
@@ -148,14 +162,14 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 	{
 		allocateVoxelBlocksList_device << <gridSizeAL, cudaBlockSizeAL >> >(voxelAllocationList, excessAllocationList, hashTable,
 			noTotalEntries, (AllocationTempData*)allocationTempData_device, entriesAllocType_device, entriesVisibleType,
-			blockCoords_device);
+			blockCoords_device, scene->index.GetAllocatedEntryIDs());
 	}
 
 	if (useSwapping)
-		buildVisibleList_device<true> << <gridSizeAL, cudaBlockSizeAL >> >(hashTable, swapStates, noTotalEntries, visibleEntryIDs,
+		buildVisibleList_device<true> << <gridSizeAL, cudaBlockSizeAL >> >(hashTable, swapStates, noTotalEntries, noLocalBlocks, visibleEntryIDs,
 			(AllocationTempData*)allocationTempData_device, entriesVisibleType, M_d, projParams_d, depthImgSize, voxelSize);
 	else
-		buildVisibleList_device<false> << <gridSizeAL, cudaBlockSizeAL >> >(hashTable, swapStates, noTotalEntries, visibleEntryIDs,
+		buildVisibleList_device<false> << <gridSizeAL, cudaBlockSizeAL >> >(hashTable, swapStates, noTotalEntries, noLocalBlocks, visibleEntryIDs,
 			(AllocationTempData*)allocationTempData_device, entriesVisibleType, M_d, projParams_d, depthImgSize, voxelSize);
 
 	if (useSwapping)
@@ -165,9 +179,11 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::AllocateScene
 	}
 
 	ITMSafeCall(cudaMemcpy(tempData, allocationTempData_device, sizeof(AllocationTempData), cudaMemcpyDeviceToHost));
-	renderState_vh->noVisibleEntries = tempData->noVisibleEntries;
-	scene->localVBA.lastFreeBlockId = tempData->noAllocatedVoxelEntries;
-	scene->index.SetLastFreeExcessListId(tempData->noAllocatedExcessEntries);
+	renderState_vh->noVisibleEntries = MIN(tempData->noVisibleEntries, noLocalBlocks);
+	// counters run past -1 when the voxel block array or excess list is exhausted
+	scene->localVBA.lastFreeBlockId = MAX(tempData->noAllocatedVoxelEntries, -1);
+	scene->index.SetLastFreeExcessListId(MAX(tempData->noAllocatedExcessEntries, -1));
+	scene->index.SetNoAllocatedEntries(tempData->noAllocatedEntries);
 }
 
 template<class TVoxel>
@@ -189,7 +205,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockHash>::IntegrateInto
 	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
 	projParams_rgb = view->calib->intrinsics_rgb.projectionParamsSimple.all;
 
-	float mu = scene->sceneParams->mu; int maxW = scene->sceneParams->maxW;
+	float mu = scene->sceneParams->mu; int maxW = MIN(scene->sceneParams->maxW, TVoxel::W_maxValue());
 
 	float *depth = view->depth->GetData(MEMORYDEVICE_CUDA);
 	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CUDA);
@@ -255,7 +271,7 @@ void ITMSceneReconstructionEngine_CUDA<TVoxel, ITMPlainVoxelArray>::IntegrateInt
 	projParams_d = view->calib->intrinsics_d.projectionParamsSimple.all;
 	projParams_rgb = view->calib->intrinsics_rgb.projectionParamsSimple.all;
 
-	float mu = scene->sceneParams->mu; int maxW = scene->sceneParams->maxW;
+	float mu = scene->sceneParams->mu; int maxW = MIN(scene->sceneParams->maxW, TVoxel::W_maxValue());
 
 	float *depth = view->depth->GetData(MEMORYDEVICE_CUDA);
 	Vector4u *rgb = view->rgb->GetData(MEMORYDEVICE_CUDA);
@@ -343,7 +359,7 @@ __global__ void integrateIntoScene_device(TVoxel *localVBA, const ITMHashEntry *
 	ComputeUpdatedVoxelInfo<TVoxel::hasColorInformation,TVoxel>::compute(localVoxelBlock[locId], pt_model, M_d, projParams_d, M_rgb, projParams_rgb, mu, maxW, depth, depthImgSize, rgb, rgbImgSize);
 }
 
-__global__ void buildHashAllocAndVisibleType_device(uchar *entriesAllocType, uchar *entriesVisibleType, Vector4s *blockCoords, const float *depth,
+__global__ void buildHashAllocAndVisibleType_device(uchar *entriesAllocType, uchar *entriesVisibleType, ITMBlockCoords *blockCoords, const float *depth,
 	Matrix4f invM_d, Vector4f projParams_d, float mu, Vector2i _imgSize, float _voxelSize, ITMHashEntry *hashTable, float viewFrustum_min,
 	float viewFrustum_max)
 {
@@ -352,7 +368,7 @@ __global__ void buildHashAllocAndVisibleType_device(uchar *entriesAllocType, uch
 	if (x > _imgSize.x - 1 || y > _imgSize.y - 1) return;
 
 	buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, invM_d,
-		projParams_d, mu, _imgSize, _voxelSize, hashTable, viewFrustum_min, viewFrustum_max);
+		projParams_d, mu, _imgSize, _voxelSize, hashTable, SDF_HASH_MASK, viewFrustum_min, viewFrustum_max);
 }
 
 __global__ void setToType3(uchar *entriesVisibleType, int *visibleEntryIDs, int noVisibleEntries)
@@ -363,7 +379,7 @@ __global__ void setToType3(uchar *entriesVisibleType, int *visibleEntryIDs, int
 }
 
 __global__ void allocateVoxelBlocksList_device(int *voxelAllocationList, int *excessAllocationList, ITMHashEntry *hashTable, int noTotalEntries,
-	AllocationTempData *allocData, uchar *entriesAllocType, uchar *entriesVisibleType, Vector4s *blockCoords)
+	AllocationTempData *allocData, uchar *entriesAllocType, uchar *entriesVisibleType, ITMBlockCoords *blockCoords, int *allocatedEntryIDs)
 {
 	int targetIdx = threadIdx.x + blockIdx.x * blockDim.x;
 	if (targetIdx > noTotalEntries - 1) return;
@@ -377,14 +393,15 @@ __global__ void allocateVoxelBlocksList_device(int *voxelAllocationList, int *ex
 
 		if (vbaIdx >= 0) //there is room in the voxel block array
 		{
-			Vector4s pt_block_all = blockCoords[targetIdx];
+			ITMBlockCoords pt_block_all = blockCoords[targetIdx];
 
 			ITMHashEntry hashEntry;
-			hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
+			hashEntry.pos = ITMBlockPos(pt_block_all.x, pt_block_all.y, pt_block_all.z);
 			hashEntry.ptr = voxelAllocationList[vbaIdx];
 			hashEntry.offset = 0;
 
 			hashTable[targetIdx] = hashEntry;
+			allocatedEntryIDs[atomicAdd(&allocData->noAllocatedEntries, 1)] = targetIdx;
 		}
 		break;
 
@@ -394,10 +411,10 @@ __global__ void allocateVoxelBlocksList_device(int *voxelAllocationList, int *ex
 
 		if (vbaIdx >= 0 && exlIdx >= 0) //there is room in the voxel block array and excess list
 		{
-			Vector4s pt_block_all = blockCoords[targetIdx];
+			ITMBlockCoords pt_block_all = blockCoords[targetIdx];
 
 			ITMHashEntry hashEntry;
-			hashEntry.pos.x = pt_block_all.x; hashEntry.pos.y = pt_block_all.y; hashEntry.pos.z = pt_block_all.z;
+			hashEntry.pos = ITMBlockPos(pt_block_all.x, pt_block_all.y, pt_block_all.z);
 			hashEntry.ptr = voxelAllocationList[vbaIdx];
 			hashEntry.offset = 0;
 
@@ -408,6 +425,7 @@ __global__ void allocateVoxelBlocksList_device(int *voxelAllocationList, int *ex
 			hashTable[SDF_BUCKET_NUM + exlOffset] = hashEntry; //add child to the excess list
 
 			entriesVisibleType[SDF_BUCKET_NUM + exlOffset] = 1; //make child visible
+			allocatedEntryIDs[atomicAdd(&allocData->noAllocatedEntries, 1)] = SDF_BUCKET_NUM + exlOffset;
 		}
 
 		break;
@@ -431,7 +449,7 @@ __global__ void reAllocateSwappedOutVoxelBlocks_device(int *voxelAllocationList,
 }
 
 template<bool useSwapping>
-__global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapState *swapStates, int noTotalEntries,
+__global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapState *swapStates, int noTotalEntries, int noLocalBlocks,
 	int *visibleEntryIDs, AllocationTempData *allocData, uchar *entriesVisibleType, 
 	Matrix4f M_d, Vector4f projParams_d, Vector2i depthImgSize, float voxelSize)
 {
@@ -451,10 +469,10 @@ __global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapStat
 
 		if (useSwapping)
 		{
-			checkBlockVisibility<true>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
+			checkBlockVisibility<true>(isVisible, isVisibleEnlarged, hashEntry.pos.toInt(), M_d, projParams_d, voxelSize, depthImgSize);
 			if (!isVisibleEnlarged) hashVisibleType = 0;
 		} else {
-			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M_d, projParams_d, voxelSize, depthImgSize);
+			checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos.toInt(), M_d, projParams_d, voxelSize, depthImgSize);
 			if (!isVisible) hashVisibleType = 0;
 		}
 		entriesVisibleType[targetIdx] = hashVisibleType;
@@ -472,7 +490,7 @@ __global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapStat
 	if (shouldPrefix)
 	{
 		int offset = computePrefixSum_device<int>(hashVisibleType > 0, &allocData->noVisibleEntries, blockDim.x * blockDim.y, threadIdx.x);
-		if (offset != -1) visibleEntryIDs[offset] = targetIdx;
+		if (offset != -1 && offset < noLocalBlocks) visibleEntryIDs[offset] = targetIdx;
 	}
 
 #if 0
@@ -488,5 +506,5 @@ __global__ void buildVisibleList_device(ITMHashEntry *hashTable, ITMHashSwapStat
 #endif
 }
 
-template class ITMLib::Engine::ITMSceneReconstructionEngine_CUDA<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMSceneReconstructionEngine_CUDA)
 
@@ -19,7 +19,7 @@ namespace ITMLib
 			void *allocationTempData_device;
 			void *allocationTempData_host;
 			unsigned char *entriesAllocType_device;
-			Vector4s *blockCoords_device;
+			ITMBlockCoords *blockCoords_device;
 
 		public:
 			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockHash> *scene);
@@ -34,6 +34,40 @@ namespace ITMLib
 			~ITMSceneReconstructionEngine_CUDA(void);
 		};
 
+		/** The open addressing hash is only implemented by the CPU
+		engines, ITMMainEngine falls back to the voxel block hash on
+		CUDA devices.
+		*/
+		template<class TVoxel>
+		class ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockOpenHash> : public ITMSceneReconstructionEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		public:
+			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene) { }
+
+			void AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState, bool onlyUpdateVisibleList = false) { }
+
+			void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState) { }
+		};
+
+		/** The voxel block octree is only implemented by the CPU
+		engines, ITMMainEngine falls back to the voxel block hash on
+		CUDA devices.
+		*/
+		template<class TVoxel>
+		class ITMSceneReconstructionEngine_CUDA<TVoxel, ITMVoxelBlockOctree> : public ITMSceneReconstructionEngine < TVoxel, ITMVoxelBlockOctree >
+		{
+		public:
+			void ResetScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene) { }
+
+			void AllocateSceneFromDepth(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState, bool onlyUpdateVisibleList = false) { }
+
+			void IntegrateIntoScene(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene, const ITMView *view, const ITMTrackingState *trackingState,
+				const ITMRenderState *renderState) { }
+		};
+
 		template<class TVoxel>
 		class ITMSceneReconstructionEngine_CUDA<TVoxel, ITMPlainVoxelArray> : public ITMSceneReconstructionEngine < TVoxel, ITMPlainVoxelArray >
 		{
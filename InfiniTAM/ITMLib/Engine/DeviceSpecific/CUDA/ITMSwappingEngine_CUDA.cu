@@ -7,18 +7,19 @@
 
 using namespace ITMLib::Engine;
 
-__global__ void buildListToSwapIn_device(int *neededEntryIDs, int *noNeededEntries, ITMHashSwapState *swapStates, int noTotalEntries);
+__global__ void buildListToSwapIn_device(int *neededEntryIDs, int *noNeededEntries, ITMHashSwapState *swapStates, const ITMHashEntry *hashTable,
+	int noTotalEntries, int noTransferBlocks);
 
 template<class TVoxel>
 __global__ void integrateOldIntoActiveData_device(TVoxel *localVBA, ITMHashSwapState *swapStates, TVoxel *syncedVoxelBlocks_local,
 	int *neededEntryIDs_local, ITMHashEntry *hashTable, int maxW);
 
 __global__ void buildListToSwapOut_device(int *neededEntryIDs, int *noNeededEntries, ITMHashSwapState *swapStates,
-	ITMHashEntry *hashTable, uchar *entriesVisibleType, int noTotalEntries);
+	ITMHashEntry *hashTable, uchar *entriesVisibleType, int noTotalEntries, int noTransferBlocks);
 
 template<class TVoxel>
 __global__ void cleanMemory_device(int *voxelAllocationList, int *noAllocatedVoxelEntries, ITMHashSwapState *swapStates,
-	ITMHashEntry *hashTable, TVoxel *localVBA, int *neededEntryIDs_local, int noNeededEntries);
+	ITMHashEntry *hashTable, TVoxel *localVBA, int *neededEntryIDs_local, int noNeededEntries, int noLocalBlocks);
 
 template<class TVoxel>
 __global__ void moveActiveDataToTransferBuffer_device(TVoxel *syncedVoxelBlocks_local, bool *hasSyncedData_local,
@@ -59,14 +60,14 @@ int ITMSwappingEngine_CUDA<TVoxel,ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 	ITMSafeCall(cudaMemset(noNeededEntries_device, 0, sizeof(int)));
 
 	buildListToSwapIn_device << <gridSize, blockSize >> >(neededEntryIDs_local, noNeededEntries_device, swapStates,
-		scene->globalCache->noTotalEntries);
+		scene->index.GetEntries(), scene->globalCache->noTotalEntries, globalCache->noTransferBlocks);
 
 	int noNeededEntries;
 	ITMSafeCall(cudaMemcpy(&noNeededEntries, noNeededEntries_device, sizeof(int), cudaMemcpyDeviceToHost));
 
 	if (noNeededEntries > 0)
 	{
-		noNeededEntries = MIN(noNeededEntries, SDF_TRANSFER_BLOCK_NUM);
+		noNeededEntries = MIN(noNeededEntries, globalCache->noTransferBlocks);
 		ITMSafeCall(cudaMemcpy(neededEntryIDs_global, neededEntryIDs_local, sizeof(int) * noNeededEntries, cudaMemcpyDeviceToHost));
 
 		memset(syncedVoxelBlocks_global, 0, noNeededEntries * SDF_BLOCK_SIZE3 * sizeof(TVoxel));
@@ -78,7 +79,7 @@ int ITMSwappingEngine_CUDA<TVoxel,ITMVoxelBlockHash>::LoadFromGlobalMemory(ITMSc
 			if (globalCache->HasStoredData(entryId))
 			{
 				hasSyncedData_global[i] = true;
-				memcpy(syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3, globalCache->GetStoredVoxelBlock(entryId), SDF_BLOCK_SIZE3 * sizeof(TVoxel));
+				globalCache->GetStoredData(entryId, syncedVoxelBlocks_global + i * SDF_BLOCK_SIZE3);
 			}
 		}
 
@@ -105,7 +106,7 @@ void ITMSwappingEngine_CUDA<TVoxel, ITMVoxelBlockHash>::IntegrateGlobalIntoLocal
 
 	int noNeededEntries = this->LoadFromGlobalMemory(scene);
 
-	int maxW = scene->sceneParams->maxW;
+	int maxW = MIN(scene->sceneParams->maxW, TVoxel::W_maxValue());
 
 	if (noNeededEntries > 0) {
 		dim3 blockSize(SDF_BLOCK_SIZE, SDF_BLOCK_SIZE, SDF_BLOCK_SIZE);
@@ -149,14 +150,14 @@ void ITMSwappingEngine_CUDA<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSc
 		ITMSafeCall(cudaMemset(noNeededEntries_device, 0, sizeof(int)));
 
 		buildListToSwapOut_device << <gridSize, blockSize >> >(neededEntryIDs_local, noNeededEntries_device, swapStates,
-			hashTable, entriesVisibleType, noTotalEntries);
+			hashTable, entriesVisibleType, noTotalEntries, globalCache->noTransferBlocks);
 
 		ITMSafeCall(cudaMemcpy(&noNeededEntries, noNeededEntries_device, sizeof(int), cudaMemcpyDeviceToHost));
 	}
 
 	if (noNeededEntries > 0)
 	{
-		noNeededEntries = MIN(noNeededEntries, SDF_TRANSFER_BLOCK_NUM);
+		noNeededEntries = MIN(noNeededEntries, globalCache->noTransferBlocks);
 		{
 			blockSize = dim3(SDF_BLOCK_SIZE, SDF_BLOCK_SIZE, SDF_BLOCK_SIZE);
 			gridSize = dim3(noNeededEntries);
@@ -172,11 +173,11 @@ void ITMSwappingEngine_CUDA<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSc
 			ITMSafeCall(cudaMemcpy(noAllocatedVoxelEntries_device, &scene->localVBA.lastFreeBlockId, sizeof(int), cudaMemcpyHostToDevice));
 
 			cleanMemory_device << <gridSize, blockSize >> >(voxelAllocationList, noAllocatedVoxelEntries_device, swapStates, hashTable, localVBA,
-				neededEntryIDs_local, noNeededEntries);
+				neededEntryIDs_local, noNeededEntries, scene->index.getNumAllocatedVoxelBlocks());
 
 			ITMSafeCall(cudaMemcpy(&scene->localVBA.lastFreeBlockId, noAllocatedVoxelEntries_device, sizeof(int), cudaMemcpyDeviceToHost));
 			scene->localVBA.lastFreeBlockId = MAX(scene->localVBA.lastFreeBlockId, 0);
-			scene->localVBA.lastFreeBlockId = MIN(scene->localVBA.lastFreeBlockId, SDF_LOCAL_BLOCK_NUM);
+			scene->localVBA.lastFreeBlockId = MIN(scene->localVBA.lastFreeBlockId, scene->index.getNumAllocatedVoxelBlocks());
 		}
 
 		ITMSafeCall(cudaMemcpy(neededEntryIDs_global, neededEntryIDs_local, sizeof(int) * noNeededEntries, cudaMemcpyDeviceToHost));
@@ -191,7 +192,8 @@ void ITMSwappingEngine_CUDA<TVoxel, ITMVoxelBlockHash>::SaveToGlobalMemory(ITMSc
 	}
 }
 
-__global__ void buildListToSwapIn_device(int *neededEntryIDs, int *noNeededEntries, ITMHashSwapState *swapStates, int noTotalEntries)
+__global__ void buildListToSwapIn_device(int *neededEntryIDs, int *noNeededEntries, ITMHashSwapState *swapStates, const ITMHashEntry *hashTable,
+	int noTotalEntries, int noTransferBlocks)
 {
 	int targetIdx = threadIdx.x + blockIdx.x * blockDim.x;
 	if (targetIdx > noTotalEntries - 1) return;
@@ -201,7 +203,8 @@ __global__ void buildListToSwapIn_device(int *neededEntryIDs, int *noNeededEntri
 	shouldPrefix = false;
 	__syncthreads();
 
-	bool isNeededId = (swapStates[targetIdx].state == 1);
+	// blocks that could not be reallocated because the local VBA is full stay in the global memory
+	bool isNeededId = (swapStates[targetIdx].state == 1 && hashTable[targetIdx].ptr >= 0);
 
 	if (isNeededId) shouldPrefix = true;
 	__syncthreads();
@@ -209,12 +212,12 @@ __global__ void buildListToSwapIn_device(int *neededEntryIDs, int *noNeededEntri
 	if (shouldPrefix)
 	{
 		int offset = computePrefixSum_device<int>(isNeededId, noNeededEntries, blockDim.x * blockDim.y, threadIdx.x);
-		if (offset != -1 && offset < SDF_TRANSFER_BLOCK_NUM) neededEntryIDs[offset] = targetIdx;
+		if (offset != -1 && offset < noTransferBlocks) neededEntryIDs[offset] = targetIdx;
 	}
 }
 
 __global__ void buildListToSwapOut_device(int *neededEntryIDs, int *noNeededEntries, ITMHashSwapState *swapStates,
-	ITMHashEntry *hashTable, uchar *entriesVisibleType, int noTotalEntries)
+	ITMHashEntry *hashTable, uchar *entriesVisibleType, int noTotalEntries, int noTransferBlocks)
 {
 	int targetIdx = threadIdx.x + blockIdx.x * blockDim.x;
 	if (targetIdx > noTotalEntries - 1) return;
@@ -235,13 +238,13 @@ __global__ void buildListToSwapOut_device(int *neededEntryIDs, int *noNeededEntr
 	if (shouldPrefix)
 	{
 		int offset = computePrefixSum_device<int>(isNeededId, noNeededEntries, blockDim.x * blockDim.y, threadIdx.x);
-		if (offset != -1 && offset < SDF_TRANSFER_BLOCK_NUM) neededEntryIDs[offset] = targetIdx;
+		if (offset != -1 && offset < noTransferBlocks) neededEntryIDs[offset] = targetIdx;
 	}
 }
 
 template<class TVoxel>
 __global__ void cleanMemory_device(int *voxelAllocationList, int *noAllocatedVoxelEntries, ITMHashSwapState *swapStates,
-	ITMHashEntry *hashTable, TVoxel *localVBA, int *neededEntryIDs_local, int noNeededEntries)
+	ITMHashEntry *hashTable, TVoxel *localVBA, int *neededEntryIDs_local, int noNeededEntries, int noLocalBlocks)
 {
 	int locId = threadIdx.x + blockIdx.x * blockDim.x;
 	
@@ -252,7 +255,7 @@ __global__ void cleanMemory_device(int *voxelAllocationList, int *noAllocatedVox
 	swapStates[entryDestId].state = 0;
 
 	int vbaIdx = atomicAdd(&noAllocatedVoxelEntries[0], 1);
-	if (vbaIdx < SDF_LOCAL_BLOCK_NUM - 1)
+	if (vbaIdx < noLocalBlocks - 1)
 	{
 		voxelAllocationList[vbaIdx + 1] = hashTable[entryDestId].ptr;
 		hashTable[entryDestId].ptr = -1;
@@ -293,4 +296,4 @@ __global__ void integrateOldIntoActiveData_device(TVoxel *localVBA, ITMHashSwapS
 	if (vIdx == 0) swapStates[entryDestId].state = 2;
 }
 
-template class ITMLib::Engine::ITMSwappingEngine_CUDA<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMSwappingEngine_CUDA)
@@ -112,7 +112,7 @@ template<class TVoxel>
 ITMRenderState_VH* ITMVisualisationEngine_CUDA<TVoxel, ITMVoxelBlockHash>::CreateRenderState(const Vector2i & imgSize) const
 {
 	return new ITMRenderState_VH(
-		ITMVoxelBlockHash::noTotalEntries, imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CUDA
+		this->scene->index.noTotalEntries, this->scene->index.getNumAllocatedVoxelBlocks(), imgSize, this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CUDA
 	);
 }
 
@@ -463,7 +463,7 @@ __global__ void buildVisibleList_device(const ITMHashEntry *hashTable, /*ITMHash
 		shouldPrefix = true;
 
 		bool isVisible, isVisibleEnlarged;
-		checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos, M, projParams, voxelSize, imgSize);
+		checkBlockVisibility<false>(isVisible, isVisibleEnlarged, hashEntry.pos.toInt(), M, projParams, voxelSize, imgSize);
 
 		hashVisibleType = isVisible;
 	}
@@ -491,7 +491,7 @@ __global__ void projectAndSplitBlocks_device(const ITMHashEntry *hashEntries, co
 	Vector2f zRange;
 	bool validProjection = false;
 	if (in_offset < noVisibleEntries) if (blockData.ptr >= 0)
-		validProjection = ProjectSingleBlock(blockData.pos, pose_M, intrinsics, imgSize, voxelSize, upperLeft, lowerRight, zRange);
+		validProjection = ProjectSingleBlock(blockData.pos.toInt(), pose_M, intrinsics, imgSize, voxelSize, upperLeft, lowerRight, zRange);
 
 	Vector2i requiredRenderingBlocks(ceilf((float)(lowerRight.x - upperLeft.x + 1) / renderingBlockSizeX),
 		ceilf((float)(lowerRight.y - upperLeft.y + 1) / renderingBlockSizeY));
@@ -718,4 +718,4 @@ __global__ void renderColour_device(Vector4u *outRendering, const Vector4f *ptsR
 	processPixelColour<TVoxel, TIndex>(outRendering[locId], ptRay.toVector3(), ptRay.w > 0, voxelData, voxelIndex, lightSource);
 }
 
-template class ITMLib::Engine::ITMVisualisationEngine_CUDA < ITMVoxel, ITMVoxelIndex > ;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMVisualisationEngine_CUDA)
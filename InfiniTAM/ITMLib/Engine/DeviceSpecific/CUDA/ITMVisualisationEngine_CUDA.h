@@ -55,5 +55,59 @@ namespace ITMLib
 
 			ITMRenderState_VH* CreateRenderState(const Vector2i & imgSize) const;
 		};
+
+		/** The open addressing hash is only implemented by the CPU
+		engines, ITMMainEngine falls back to the voxel block hash on
+		CUDA devices.
+		*/
+		template<class TVoxel>
+		class ITMVisualisationEngine_CUDA<TVoxel, ITMVoxelBlockOpenHash> : public ITMVisualisationEngine < TVoxel, ITMVoxelBlockOpenHash >
+		{
+		public:
+			explicit ITMVisualisationEngine_CUDA(ITMScene<TVoxel, ITMVoxelBlockOpenHash> *scene)
+				: ITMVisualisationEngine<TVoxel, ITMVoxelBlockOpenHash>(scene) { }
+
+			void FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const { }
+			void CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const { }
+			void RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState, 
+				ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const { }
+			void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const { }
+			void CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState, bool skipPoints) const { }
+			void CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const { }
+			void ForwardRender(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const { }
+
+			ITMRenderState_VH* CreateRenderState(const Vector2i & imgSize) const
+			{
+				return new ITMRenderState_VH(this->scene->index.noTotalEntries, this->scene->index.getNumAllocatedVoxelBlocks(), imgSize,
+					this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CUDA);
+			}
+		};
+
+		/** The voxel block octree is only implemented by the CPU
+		engines, ITMMainEngine falls back to the voxel block hash on
+		CUDA devices.
+		*/
+		template<class TVoxel>
+		class ITMVisualisationEngine_CUDA<TVoxel, ITMVoxelBlockOctree> : public ITMVisualisationEngine < TVoxel, ITMVoxelBlockOctree >
+		{
+		public:
+			explicit ITMVisualisationEngine_CUDA(ITMScene<TVoxel, ITMVoxelBlockOctree> *scene)
+				: ITMVisualisationEngine<TVoxel, ITMVoxelBlockOctree>(scene) { }
+
+			void FindVisibleBlocks(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const { }
+			void CreateExpectedDepths(const ITMPose *pose, const ITMIntrinsics *intrinsics, ITMRenderState *renderState) const { }
+			void RenderImage(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState, 
+				ITMUChar4Image *outputImage, IITMVisualisationEngine::RenderImageType type = IITMVisualisationEngine::RENDER_SHADED_GREYSCALE) const { }
+			void FindSurface(const ITMPose *pose, const ITMIntrinsics *intrinsics, const ITMRenderState *renderState) const { }
+			void CreatePointCloud(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState, bool skipPoints) const { }
+			void CreateICPMaps(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const { }
+			void ForwardRender(const ITMView *view, ITMTrackingState *trackingState, ITMRenderState *renderState) const { }
+
+			ITMRenderState_VH* CreateRenderState(const Vector2i & imgSize) const
+			{
+				return new ITMRenderState_VH(this->scene->index.noTotalEntries, this->scene->index.getNumAllocatedVoxelBlocks(), imgSize,
+					this->scene->sceneParams->viewFrustum_min, this->scene->sceneParams->viewFrustum_max, MEMORYDEVICE_CUDA);
+			}
+		};
 	}
 }
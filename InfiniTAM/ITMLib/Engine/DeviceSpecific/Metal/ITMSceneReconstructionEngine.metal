@@ -63,5 +63,5 @@ kernel void buildAllocAndVisibleType_vh_device(DEVICEPTR(unsigned char) *entries
     
     buildHashAllocAndVisibleTypePP(entriesAllocType, entriesVisibleType, x, y, blockCoords, depth, params->invM_d,
                                    params->invProjParams_d, params->others.x, params->depthImgSize, params->others.y,
-                                   hashTable, params->others.z, params->others.w);
+                                   hashTable, SDF_HASH_MASK, params->others.z, params->others.w);
 }
\ No newline at end of file
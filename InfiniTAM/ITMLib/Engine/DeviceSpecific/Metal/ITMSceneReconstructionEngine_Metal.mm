@@ -48,7 +48,7 @@ void ITMSceneReconstructionEngine_Metal<TVoxel,ITMVoxelBlockHash>::IntegrateInto
     params->depthImgSize = view->depth->noDims;
     params->others.x = scene->sceneParams->voxelSize;
     params->others.y = scene->sceneParams->mu;
-    params->others.z = scene->sceneParams->maxW;
+    params->others.z = MIN(scene->sceneParams->maxW, TVoxel::W_maxValue());
 //    params->others.w = (float)scene->sceneParams->stopIntegratingAtMaxW;
     params->others.w = trackingState->requiresFullRendering;
     params->M_d = trackingState->pose_d->GetM();
@@ -162,6 +162,7 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
     uchar *entriesAllocType = this->entriesAllocType->GetData(MEMORYDEVICE_CPU);
     Vector4s *blockCoords = this->blockCoords->GetData(MEMORYDEVICE_CPU);
     int noTotalEntries = scene->index.noTotalEntries;
+    int noLocalBlocks = scene->index.getNumAllocatedVoxelBlocks();
     
     bool useSwapping = scene->useSwapping;
     
@@ -169,6 +170,8 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
     
     int lastFreeVoxelBlockId = scene->localVBA.lastFreeBlockId;
     int lastFreeExcessListId = scene->index.GetLastFreeExcessListId();
+    int *allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+    int noAllocatedEntries = scene->index.GetNoAllocatedEntries();
     
     int noVisibleEntries = 0;
     
@@ -204,7 +207,9 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
                     hashEntry.offset = 0;
                     
                     hashTable[targetIdx] = hashEntry;
+                    allocatedEntryIDs[noAllocatedEntries++] = targetIdx;
                 }
+                else entriesVisibleType[targetIdx] = 0; //no block to allocate, the entry stays empty
                 
                 break;
                 case 2: //needs allocation in the excess list
@@ -227,6 +232,7 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
                     hashTable[SDF_BUCKET_NUM + exlOffset] = hashEntry; //add child to the excess list
                     
                     entriesVisibleType[SDF_BUCKET_NUM + exlOffset] = 1; //make child visible and in memory
+                    allocatedEntryIDs[noAllocatedEntries++] = SDF_BUCKET_NUM + exlOffset;
                 }
                 
                 break;
@@ -234,9 +240,10 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
         }
     }
     
-    //build visible list
-    for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+    //build visible list, only entries present in the hash table can be visible
+    for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
     {
+        int targetIdx = allocatedEntryIDs[listIdx];
         unsigned char hashVisibleType = entriesVisibleType[targetIdx];
         const ITMHashEntry &hashEntry = hashTable[targetIdx];
         
@@ -260,7 +267,7 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
             if (hashVisibleType > 0 && swapStates[targetIdx].state != 2) swapStates[targetIdx].state = 1;
         }
         
-        if (hashVisibleType > 0)
+        if (hashVisibleType > 0 && noVisibleEntries < noLocalBlocks)
         {	
             visibleEntryIDs[noVisibleEntries] = targetIdx;
             noVisibleEntries++;
@@ -279,8 +286,9 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
     //reallocate deleted ones from previous swap operation
     if (useSwapping)
     {
-        for (int targetIdx = 0; targetIdx < noTotalEntries; targetIdx++)
+        for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
         {
+            int targetIdx = allocatedEntryIDs[listIdx];
             int vbaIdx;
             ITMHashEntry hashEntry = hashTable[targetIdx];
             
@@ -294,10 +302,16 @@ void ITMSceneReconstructionEngine_Metal<TVoxel, ITMVoxelBlockHash>::AllocateScen
     
     renderState_vh->noVisibleEntries = noVisibleEntries;
     
-    scene->localVBA.lastFreeBlockId = lastFreeVoxelBlockId;
-    scene->index.SetLastFreeExcessListId(lastFreeExcessListId);
+    // counters run past -1 when the voxel block array or excess list is exhausted
+    int oldLastFreeBlockId = scene->localVBA.lastFreeBlockId;
+    scene->localVBA.lastFreeBlockId = MAX(lastFreeVoxelBlockId, -1);
+    scene->index.SetLastFreeExcessListId(MAX(lastFreeExcessListId, -1));
+    scene->index.SetNoAllocatedEntries(noAllocatedEntries);
+    
+    this->ClearHandedOutBlocks(scene, oldLastFreeBlockId);
+    this->LinkHandedOutBlocks(scene, oldLastFreeBlockId);
 }
 
-template class ITMLib::Engine::ITMSceneReconstructionEngine_Metal<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMSceneReconstructionEngine_Metal)
 
 #endif
\ No newline at end of file
@@ -293,6 +293,6 @@ void ITMVisualisationEngine_Metal<TVoxel,ITMVoxelBlockHash>::CreateExpectedDepth
     }
 }
 
-template class ITMLib::Engine::ITMVisualisationEngine_Metal<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMVisualisationEngine_Metal)
 
 #endif
\ No newline at end of file
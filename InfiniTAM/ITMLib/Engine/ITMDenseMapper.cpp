@@ -12,6 +12,8 @@ template<class TVoxel, class TIndex>
 ITMDenseMapper<TVoxel, TIndex>::ITMDenseMapper(const ITMLibSettings *settings)
 {
 	swappingEngine = NULL;
+	noFramesSinceGarbageCollection = 0;
+	noFramesSinceDefragmentation = 0;
 
 	switch (settings->deviceType)
 	{
@@ -62,6 +64,32 @@ void ITMDenseMapper<TVoxel,TIndex>::ProcessFrame(const ITMView *view, const ITMT
 		// swapping: GPU -> CPU
 		swappingEngine->SaveToGlobalMemory(scene, renderState);
 	}
+
+	// garbage collection of blocks without surface
+	int garbageCollectionInterval = scene->sceneParams->garbageCollectionInterval;
+	if (garbageCollectionInterval > 0 && ++noFramesSinceGarbageCollection >= garbageCollectionInterval)
+	{
+		sceneRecoEngine->CollectGarbage(scene, renderState);
+		noFramesSinceGarbageCollection = 0;
+	}
+
+	// defragmentation of the voxel block array
+	int defragmentationInterval = scene->sceneParams->defragmentationInterval;
+	if (defragmentationInterval > 0 && ++noFramesSinceDefragmentation >= defragmentationInterval)
+		DefragmentScene(scene);
+}
+
+template<class TVoxel, class TIndex>
+void ITMDenseMapper<TVoxel,TIndex>::DefragmentScene(ITMScene<TVoxel,TIndex> *scene)
+{
+	sceneRecoEngine->DefragmentScene(scene);
+	noFramesSinceDefragmentation = 0;
+}
+
+template<class TVoxel, class TIndex>
+bool ITMDenseMapper<TVoxel,TIndex>::RecenterScene(ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState, const Vector3i &shift)
+{
+	return sceneRecoEngine->RecenterScene(scene, renderState, shift);
 }
 
 template<class TVoxel, class TIndex>
@@ -70,4 +98,4 @@ void ITMDenseMapper<TVoxel,TIndex>::UpdateVisibleList(const ITMView *view, const
 	sceneRecoEngine->AllocateSceneFromDepth(scene, view, trackingState, renderState, true);
 }
 
-template class ITMLib::Engine::ITMDenseMapper<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMDenseMapper)
@@ -26,12 +26,21 @@ namespace ITMLib
 			ITMSceneReconstructionEngine<TVoxel,TIndex> *sceneRecoEngine;
 			ITMSwappingEngine<TVoxel,TIndex> *swappingEngine;
 
+			int noFramesSinceGarbageCollection;
+			int noFramesSinceDefragmentation;
+
 		public:
 			void ResetScene(ITMScene<TVoxel,TIndex> *scene);
 
 			/// Process a single frame
 			void ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState_live);
 
+			/// Reorder the voxel blocks of the scene for memory locality
+			void DefragmentScene(ITMScene<TVoxel,TIndex> *scene);
+
+			/// Move the origin of the scene by a number of voxel blocks, possibly over several calls, returns false until the scene is moved
+			bool RecenterScene(ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState, const Vector3i &shift);
+
 			/// Update the visible list (this can be called to update the visible list when fusion is turned off)
 			void UpdateVisibleList(const ITMView *view, const ITMTrackingState *trackingState, ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState);
 
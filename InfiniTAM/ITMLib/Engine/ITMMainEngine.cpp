@@ -4,6 +4,139 @@
 
 using namespace ITMLib::Engine;
 
+template<class TVoxel, class TIndex>
+ITMSceneEngine<TVoxel, TIndex>::ITMSceneEngine(const ITMLibSettings *settings, bool createMeshingEngine)
+{
+	this->settings = settings;
+	recenteringShift = Vector3i(0, 0, 0);
+
+	scene = new ITMScene<TVoxel, TIndex>(&(settings->sceneParams), settings->useSwapping, 
+		settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU);
+
+	meshingEngine = NULL;
+	switch (settings->deviceType)
+	{
+	case ITMLibSettings::DEVICE_CPU:
+		visualisationEngine = new ITMVisualisationEngine_CPU<TVoxel, TIndex>(scene);
+		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<TVoxel, TIndex>();
+		break;
+	case ITMLibSettings::DEVICE_CUDA:
+#ifndef COMPILE_WITHOUT_CUDA
+		visualisationEngine = new ITMVisualisationEngine_CUDA<TVoxel, TIndex>(scene);
+		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CUDA<TVoxel, TIndex>();
+#endif
+		break;
+	case ITMLibSettings::DEVICE_METAL:
+#ifdef COMPILE_WITH_METAL
+		visualisationEngine = new ITMVisualisationEngine_Metal<TVoxel, TIndex>(scene);
+		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<TVoxel, TIndex>();
+#endif
+		break;
+	}
+
+	denseMapper = new ITMDenseMapper<TVoxel, TIndex>(settings);
+}
+
+template<class TVoxel, class TIndex>
+ITMSceneEngine<TVoxel, TIndex>::~ITMSceneEngine(void)
+{
+	delete denseMapper;
+	delete visualisationEngine;
+	if (meshingEngine != NULL) delete meshingEngine;
+	delete scene;
+}
+
+template<class TVoxel, class TIndex>
+ITMTracker* ITMSceneEngine<TVoxel, TIndex>::MakeTracker(const Vector2i &trackedImageSize, const ITMLowLevelEngine *lowLevelEngine,
+	ITMIMUCalibrator *imuCalibrator)
+{
+	return ITMTrackerFactory<TVoxel, TIndex>::Instance().Make(trackedImageSize, settings, lowLevelEngine, imuCalibrator, scene);
+}
+
+template<class TVoxel, class TIndex>
+void ITMSceneEngine<TVoxel, TIndex>::ResetScene(void)
+{
+	denseMapper->ResetScene(scene);
+	recenteringShift = Vector3i(0, 0, 0);
+}
+
+template<class TVoxel, class TIndex>
+void ITMSceneEngine<TVoxel, TIndex>::ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMRenderState *renderState_live)
+{
+	denseMapper->ProcessFrame(view, trackingState, scene, renderState_live);
+}
+
+template<class TVoxel, class TIndex>
+void ITMSceneEngine<TVoxel, TIndex>::MeshScene(ITMMesh *mesh)
+{
+	if (meshingEngine != NULL) meshingEngine->MeshScene(mesh, scene);
+}
+
+template<class TVoxel>
+static bool getHashStatistics(ITMHashStatistics *stats, const ITMScene<TVoxel, ITMVoxelBlockHash> *scene)
+{
+	scene->index.GetStatistics(stats, scene->localVBA.lastFreeBlockId);
+	return true;
+}
+
+template<class TVoxel, class TIndex>
+static bool getHashStatistics(ITMHashStatistics *stats, const ITMScene<TVoxel, TIndex> *scene) { return false; }
+
+template<class TVoxel, class TIndex>
+bool ITMSceneEngine<TVoxel, TIndex>::GetHashStatistics(ITMHashStatistics *stats) const
+{
+	return getHashStatistics(stats, scene);
+}
+
+template<class TVoxel, class TIndex>
+bool ITMSceneEngine<TVoxel, TIndex>::RecenterScene(ITMTrackingState *trackingState, ITMRenderState *renderState_live)
+{
+	float recenteringDistance = settings->sceneParams.recenteringDistance;
+	if (recenteringDistance <= 0.0f) return false;
+
+	ITMPose *pose_d = trackingState->pose_d;
+	float blockSize = settings->sceneParams.voxelSize * SDF_BLOCK_SIZE;
+
+	// a move under way goes on with its shift, wherever the camera went meanwhile
+	if (recenteringShift == Vector3i(0, 0, 0))
+	{
+		Vector3f cameraCenter = -1.0f * (pose_d->GetR().t() * pose_d->GetT());
+		if (length(cameraCenter) <= recenteringDistance) return false;
+		recenteringShift = (cameraCenter / blockSize).toIntRound();
+	}
+
+	Vector3i shift = recenteringShift;
+	if (!denseMapper->RecenterScene(scene, renderState_live, shift)) return false;
+	recenteringShift = Vector3i(0, 0, 0);
+
+	// a point x in the new scene coordinates is x + offset in the old ones
+	Vector3f offset = shift.toFloat() * blockSize;
+	pose_d->SetT(pose_d->GetT() + pose_d->GetR() * offset);
+	ITMPose *pose_pointCloud = trackingState->pose_pointCloud;
+	pose_pointCloud->SetT(pose_pointCloud->GetT() + pose_pointCloud->GetR() * offset);
+
+	// the point cloud is still in the old coordinates, so it is raycast anew
+	trackingState->requiresFullRendering = true;
+
+	scene->blockOrigin += shift;
+	return true;
+}
+
+template<class TIndex>
+static IITMSceneEngine* MakeSceneEngine(const ITMLibSettings *settings, ITMLibSettings::VoxelType voxelType, bool createMeshingEngine)
+{
+	switch (voxelType)
+	{
+	case ITMLibSettings::VOXEL_S: return new ITMSceneEngine<ITMVoxel_s, TIndex>(settings, createMeshingEngine);
+	case ITMLibSettings::VOXEL_F: return new ITMSceneEngine<ITMVoxel_f, TIndex>(settings, createMeshingEngine);
+	case ITMLibSettings::VOXEL_H: return new ITMSceneEngine<ITMVoxel_h, TIndex>(settings, createMeshingEngine);
+	case ITMLibSettings::VOXEL_B: return new ITMSceneEngine<ITMVoxel_b, TIndex>(settings, createMeshingEngine);
+	case ITMLibSettings::VOXEL_S_RGB: return new ITMSceneEngine<ITMVoxel_s_rgb, TIndex>(settings, createMeshingEngine);
+	case ITMLibSettings::VOXEL_F_RGB: return new ITMSceneEngine<ITMVoxel_f_rgb, TIndex>(settings, createMeshingEngine);
+	}
+	return NULL;
+}
+
 ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib *calib, Vector2i imgSize_rgb, Vector2i imgSize_d)
 {
 	// create all the things required for marching cubes and mesh extraction
@@ -14,49 +147,85 @@ ITMMainEngine::ITMMainEngine(const ITMLibSettings *settings, const ITMRGBDCalib
 
 	this->settings = settings;
 
-	this->scene = new ITMScene<ITMVoxel, ITMVoxelIndex>(&(settings->sceneParams), settings->useSwapping, 
-		settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU);
+	if (settings->sceneParams.useSoAVoxelBlocks && settings->deviceType != ITMLibSettings::DEVICE_CPU)
+		printf("Error: The structure of arrays voxel layout is only supported by the CPU engines!\n");
+
+	// the Metal kernels are compiled for the default voxel type and index only
+	ITMLibSettings::VoxelType voxelType = settings->voxelType;
+	ITMLibSettings::IndexType indexType = settings->indexType;
+	if (settings->deviceType == ITMLibSettings::DEVICE_METAL &&
+		(voxelType != ITMVoxelTypeOf<ITMVoxel>::value || indexType != ITMIndexTypeOf<ITMVoxelIndex>::value))
+	{
+		printf("Error: The Metal engines only support the default voxel type and index, using these instead!\n");
+		voxelType = ITMVoxelTypeOf<ITMVoxel>::value;
+		indexType = ITMIndexTypeOf<ITMVoxelIndex>::value;
+	}
+
+	if (settings->trackerType == ITMLibSettings::TRACKER_COLOR &&
+		voxelType != ITMLibSettings::VOXEL_S_RGB && voxelType != ITMLibSettings::VOXEL_F_RGB)
+		printf("Error: Color tracker requires a voxel type with color information!\n");
+
+	if (indexType == ITMLibSettings::INDEX_OPEN_HASH && settings->deviceType != ITMLibSettings::DEVICE_CPU)
+	{
+		printf("Error: The open addressing hash is only supported by the CPU engines, using the voxel block hash instead!\n");
+		indexType = ITMLibSettings::INDEX_HASH;
+	}
+	if (indexType == ITMLibSettings::INDEX_OPEN_HASH && settings->useSwapping)
+	{
+		printf("Error: The open addressing hash does not support swapping, using the voxel block hash instead!\n");
+		indexType = ITMLibSettings::INDEX_HASH;
+	}
+	if (indexType == ITMLibSettings::INDEX_OCTREE && settings->deviceType != ITMLibSettings::DEVICE_CPU)
+	{
+		printf("Error: The voxel block octree is only supported by the CPU engines, using the voxel block hash instead!\n");
+		indexType = ITMLibSettings::INDEX_HASH;
+	}
+	if (indexType == ITMLibSettings::INDEX_OCTREE && settings->useSwapping)
+	{
+		printf("Error: The voxel block octree does not support swapping, using the voxel block hash instead!\n");
+		indexType = ITMLibSettings::INDEX_HASH;
+	}
+
+	if (indexType == ITMLibSettings::INDEX_PLAIN) sceneEngine = MakeSceneEngine<ITMPlainVoxelArray>(settings, voxelType, createMeshingEngine);
+	else if (indexType == ITMLibSettings::INDEX_OPEN_HASH) sceneEngine = MakeSceneEngine<ITMVoxelBlockOpenHash>(settings, voxelType, createMeshingEngine);
+	else if (indexType == ITMLibSettings::INDEX_OCTREE) sceneEngine = MakeSceneEngine<ITMVoxelBlockOctree>(settings, voxelType, createMeshingEngine);
+	else sceneEngine = MakeSceneEngine<ITMVoxelBlockHash>(settings, voxelType, createMeshingEngine);
+
+	visualisationEngine = sceneEngine->GetVisualisationEngine();
 
-	meshingEngine = NULL;
 	switch (settings->deviceType)
 	{
 	case ITMLibSettings::DEVICE_CPU:
 		lowLevelEngine = new ITMLowLevelEngine_CPU();
 		viewBuilder = new ITMViewBuilder_CPU(calib);
-		visualisationEngine = new ITMVisualisationEngine_CPU<ITMVoxel, ITMVoxelIndex>(scene);
-		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelIndex>();
 		break;
 	case ITMLibSettings::DEVICE_CUDA:
 #ifndef COMPILE_WITHOUT_CUDA
 		lowLevelEngine = new ITMLowLevelEngine_CUDA();
 		viewBuilder = new ITMViewBuilder_CUDA(calib);
-		visualisationEngine = new ITMVisualisationEngine_CUDA<ITMVoxel, ITMVoxelIndex>(scene);
-		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CUDA<ITMVoxel, ITMVoxelIndex>();
 #endif
 		break;
 	case ITMLibSettings::DEVICE_METAL:
 #ifdef COMPILE_WITH_METAL
 		lowLevelEngine = new ITMLowLevelEngine_Metal();
 		viewBuilder = new ITMViewBuilder_Metal(calib);
-		visualisationEngine = new ITMVisualisationEngine_Metal<ITMVoxel, ITMVoxelIndex>(scene);
-		if (createMeshingEngine) meshingEngine = new ITMMeshingEngine_CPU<ITMVoxel, ITMVoxelIndex>();
 #endif
 		break;
 	}
 
 	mesh = NULL;
-	if (createMeshingEngine) mesh = new ITMMesh(settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU);
+	if (createMeshingEngine) mesh = new ITMMesh(settings->deviceType == ITMLibSettings::DEVICE_CUDA ? MEMORYDEVICE_CUDA : MEMORYDEVICE_CPU,
+		settings->sceneParams.noLocalBlocks);
 
 	Vector2i trackedImageSize = ITMTrackingController::GetTrackedImageSize(settings, imgSize_rgb, imgSize_d);
 
 	renderState_live = visualisationEngine->CreateRenderState(trackedImageSize);
 	renderState_freeview = NULL; //will be created by the visualisation engine
 
-	denseMapper = new ITMDenseMapper<ITMVoxel, ITMVoxelIndex>(settings);
-	denseMapper->ResetScene(scene);
+	sceneEngine->ResetScene();
 
 	imuCalibrator = new ITMIMUCalibrator_iPad();
-	tracker = ITMTrackerFactory<ITMVoxel, ITMVoxelIndex>::Instance().Make(trackedImageSize, settings, lowLevelEngine, imuCalibrator, scene);
+	tracker = sceneEngine->MakeTracker(trackedImageSize, lowLevelEngine, imuCalibrator);
 	trackingController = new ITMTrackingController(tracker, visualisationEngine, lowLevelEngine, settings);
 
 	trackingState = trackingController->BuildTrackingState(trackedImageSize);
@@ -74,9 +243,6 @@ ITMMainEngine::~ITMMainEngine()
 	delete renderState_live;
 	if (renderState_freeview!=NULL) delete renderState_freeview;
 
-	delete scene;
-
-	delete denseMapper;
 	delete trackingController;
 
 	delete tracker;
@@ -88,23 +254,21 @@ ITMMainEngine::~ITMMainEngine()
 	delete trackingState;
 	if (view != NULL) delete view;
 
-	delete visualisationEngine;
-
-	if (meshingEngine != NULL) delete meshingEngine;
+	delete sceneEngine;
 
 	if (mesh != NULL) delete mesh;
 }
 
 ITMMesh* ITMMainEngine::UpdateMesh(void)
 {
-	if (mesh != NULL) meshingEngine->MeshScene(mesh, scene);
+	if (mesh != NULL) sceneEngine->MeshScene(mesh);
 	return mesh;
 }
 
 void ITMMainEngine::SaveSceneToMesh(const char *objFileName)
 {
 	if (mesh == NULL) return;
-	meshingEngine->MeshScene(mesh, scene);
+	sceneEngine->MeshScene(mesh);
 	mesh->WriteSTL(objFileName);
 }
 
@@ -120,12 +284,20 @@ void ITMMainEngine::ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDep
 	trackingController->Track(trackingState, view);
 
 	// fusion
-	if (fusionActive) denseMapper->ProcessFrame(view, trackingState, scene, renderState_live);
+	if (fusionActive) sceneEngine->ProcessFrame(view, trackingState, renderState_live);
+
+	// move the scene origin to the camera once it is far away
+	sceneEngine->RecenterScene(trackingState, renderState_live);
 
 	// raycast to renderState_live for tracking and free visualisation
 	trackingController->Prepare(trackingState, view, renderState_live);
 }
 
+Vector3f ITMMainEngine::GetSceneOrigin(void) const
+{
+	return sceneEngine->GetBlockOrigin().toFloat() * (settings->sceneParams.voxelSize * SDF_BLOCK_SIZE);
+}
+
 Vector2i ITMMainEngine::GetImageSize(void) const
 {
 	return renderState_live->raycastImage->noDims;
@@ -195,3 +367,5 @@ void ITMMainEngine::turnOnIntegration() { fusionActive = true; }
 void ITMMainEngine::turnOffIntegration() { fusionActive = false; }
 void ITMMainEngine::turnOnMainProcessing() { mainProcessingActive = true; }
 void ITMMainEngine::turnOffMainProcessing() { mainProcessingActive = false; }
+
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMSceneEngine)
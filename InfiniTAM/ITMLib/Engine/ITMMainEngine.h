@@ -19,6 +19,79 @@ namespace ITMLib
 {
   namespace Engine
   {
+    /** \brief
+        Interface to the world model and the engines that are templated on
+        its voxel type and index. The main engine makes one of these for
+        the types selected in ITMLibSettings, so the kernels stay compiled
+        for a single type each.
+    */
+    class IITMSceneEngine
+    {
+    public:
+      virtual ~IITMSceneEngine(void) {}
+
+      virtual bool HasColorInformation(void) const = 0;
+
+      virtual IITMVisualisationEngine* GetVisualisationEngine(void) = 0;
+
+      virtual ITMTracker* MakeTracker(const Vector2i &trackedImageSize, const ITMLowLevelEngine *lowLevelEngine,
+        ITMIMUCalibrator *imuCalibrator) = 0;
+
+      virtual void ResetScene(void) = 0;
+
+      virtual void ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMRenderState *renderState_live) = 0;
+
+      virtual void MeshScene(ITMMesh *mesh) = 0;
+
+      virtual bool GetHashStatistics(ITMHashStatistics *stats) const = 0;
+
+      virtual bool RecenterScene(ITMTrackingState *trackingState, ITMRenderState *renderState_live) = 0;
+
+      virtual Vector3i GetBlockOrigin(void) const = 0;
+    };
+
+    template<class TVoxel, class TIndex>
+    class ITMSceneEngine : public IITMSceneEngine
+    {
+    private:
+      const ITMLibSettings *settings;
+
+      IITMVisualisationEngine *visualisationEngine;
+      ITMMeshingEngine<TVoxel, TIndex> *meshingEngine;
+      ITMDenseMapper<TVoxel, TIndex> *denseMapper;
+
+      /// Shift of the move of the scene origin under way, 0 if there is none
+      Vector3i recenteringShift;
+
+    public:
+      ITMScene<TVoxel, TIndex> *scene;
+
+      bool HasColorInformation(void) const { return TVoxel::hasColorInformation; }
+
+      ITMMeshingEngine<TVoxel, TIndex>* GetMeshingEngine(void) { return meshingEngine; }
+      IITMVisualisationEngine* GetVisualisationEngine(void) { return visualisationEngine; }
+
+      ITMTracker* MakeTracker(const Vector2i &trackedImageSize, const ITMLowLevelEngine *lowLevelEngine,
+        ITMIMUCalibrator *imuCalibrator);
+
+      void ResetScene(void);
+      void ProcessFrame(const ITMView *view, const ITMTrackingState *trackingState, ITMRenderState *renderState_live);
+      void MeshScene(ITMMesh *mesh);
+      bool GetHashStatistics(ITMHashStatistics *stats) const;
+
+      /** Moves the origin of the scene to the camera once it is
+          further away than ITMSceneParams::recenteringDistance, and
+          moves the camera poses of @p trackingState with it. The
+          move may be spread over several frames, returns true in
+          the frame it is done. */
+      bool RecenterScene(ITMTrackingState *trackingState, ITMRenderState *renderState_live);
+
+      Vector3i GetBlockOrigin(void) const { return scene->blockOrigin; }
+
+      ITMSceneEngine(const ITMLibSettings *settings, bool createMeshingEngine);
+      ~ITMSceneEngine(void);
+    };
+
     /** \brief
         Main engine, that instantiates all the other engines and
         provides a simplified interface to them.
@@ -55,11 +128,10 @@ namespace ITMLib
       ITMLowLevelEngine *lowLevelEngine;
       IITMVisualisationEngine *visualisationEngine;
 
-      ITMMeshingEngine<ITMVoxel, ITMVoxelIndex> *meshingEngine;
       ITMMesh *mesh;
 
       ITMViewBuilder *viewBuilder;
-      ITMDenseMapper<ITMVoxel,ITMVoxelIndex> *denseMapper;
+      IITMSceneEngine *sceneEngine;
       ITMTrackingController *trackingController;
 
       ITMTracker *tracker;
@@ -68,7 +140,6 @@ namespace ITMLib
       ITMView *view;
       ITMTrackingState *trackingState;
 
-      ITMScene<ITMVoxel, ITMVoxelIndex> *scene;
       ITMRenderState *renderState_live;
       ITMRenderState *renderState_freeview;
 
@@ -92,7 +163,14 @@ namespace ITMLib
       double getPoseTimeStamp(){return pose_time_stamp;}
 
       /// Gives access to the meshing engine, is needed to get a full mesh.
-      ITMMeshingEngine<ITMVoxel, ITMVoxelIndex> * GetMeshingEngine(void) { return meshingEngine; }
+      /// Returns NULL if the scene does not use these voxel and index types.
+      template<class TVoxel, class TIndex>
+      ITMMeshingEngine<TVoxel, TIndex>* GetMeshingEngine(void)
+      {
+        ITMSceneEngine<TVoxel, TIndex> *typedSceneEngine = dynamic_cast<ITMSceneEngine<TVoxel, TIndex>*>(sceneEngine);
+        return typedSceneEngine != NULL ? typedSceneEngine->GetMeshingEngine() : NULL;
+      }
+      ITMMeshingEngine<ITMVoxel, ITMVoxelIndex> * GetMeshingEngine(void) { return GetMeshingEngine<ITMVoxel, ITMVoxelIndex>(); }
 
       /// Gives access to the current input frame
       ITMView* GetView() { return view; }
@@ -100,8 +178,28 @@ namespace ITMLib
       /// Gives access to the current camera pose and additional tracking information
       ITMTrackingState* GetTrackingState(void) { return trackingState; }
 
-      /// Gives access to the internal world representation
-      ITMScene<ITMVoxel, ITMVoxelIndex>* GetScene(void) { return scene; }
+      /// Gives access to the internal world representation.
+      /// Returns NULL if the scene does not use these voxel and index types.
+      template<class TVoxel, class TIndex>
+      ITMScene<TVoxel, TIndex>* GetScene(void)
+      {
+        ITMSceneEngine<TVoxel, TIndex> *typedSceneEngine = dynamic_cast<ITMSceneEngine<TVoxel, TIndex>*>(sceneEngine);
+        return typedSceneEngine != NULL ? typedSceneEngine->scene : NULL;
+      }
+      ITMScene<ITMVoxel, ITMVoxelIndex>* GetScene(void) { return GetScene<ITMVoxel, ITMVoxelIndex>(); }
+
+      /// Fills in the load of the voxel block hash and the local voxel block array.
+      /// Returns false if the scene does not use the voxel block hash.
+      bool GetHashStatistics(ITMHashStatistics *stats) const { return sceneEngine->GetHashStatistics(stats); }
+
+      /// Position of the origin of the scene in the world, in meters. The scene and the
+      /// camera poses are given relative to it, and it moves with the camera, see
+      /// ITMSceneParams::recenteringDistance. Poses from outside, e.g. of an external
+      /// tracker, have to be moved by it. Meshes are already moved back by it.
+      Vector3f GetSceneOrigin(void) const;
+
+      /// Whether the voxels of the internal world representation store colour
+      bool HasColorInformation(void) const { return sceneEngine->HasColorInformation(); }
 
       /// Process a frame with rgb and depth images and optionally a corresponding imu measurement
       void ProcessFrame(ITMUChar4Image *rgbImage, ITMShortImage *rawDepthImage, ITMIMUMeasurement *imuMeasurement = NULL);
@@ -303,5 +303,5 @@ static inline bool minimizeLM(const ITMRenTracker<TVoxel,TIndex> & tracker, ITMP
 	return true;
 }
 
-template class ITMLib::Engine::ITMRenTracker<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMRenTracker)
 
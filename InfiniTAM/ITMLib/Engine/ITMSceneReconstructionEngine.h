@@ -47,6 +47,34 @@ namespace ITMLib
 			virtual void IntegrateIntoScene(ITMScene<TVoxel,TIndex> *scene, const ITMView *view, const ITMTrackingState *trackingState,
 				const ITMRenderState *renderState) = 0;
 
+			/** Free a budgeted number of voxel blocks that hold no
+			    surface and are not visible in @p renderState, see
+			    ITMSceneParams::garbageCollectionBudget. Engines
+			    without garbage collection keep all blocks.
+			*/
+			virtual void CollectGarbage(ITMScene<TVoxel,TIndex> *scene, const ITMRenderState *renderState) { }
+
+			/** Reorder the voxel blocks in the local voxel block
+			    array by the Morton order of their positions and
+			    update the index accordingly. Engines without
+			    defragmentation leave the blocks where they are.
+			*/
+			virtual void DefragmentScene(ITMScene<TVoxel,TIndex> *scene) { }
+
+			/** Move the origin of the scene by @p shift voxel
+			    blocks, i.e. subtract @p shift from the positions of
+			    all blocks and rehash them, and update the visible
+			    lists of @p renderState. The voxels stay where they
+			    are. Engines may spread the move over several calls
+			    with the same @p shift, one per frame, and leave the
+			    scene unchanged until the last. Returns true once
+			    the scene is moved, and false while it is not, also
+			    if the engine does not support re-centering or the
+			    blocks do not fit into the index at their new
+			    positions.
+			*/
+			virtual bool RecenterScene(ITMScene<TVoxel,TIndex> *scene, ITMRenderState *renderState, const Vector3i &shift) { return false; }
+
 			ITMSceneReconstructionEngine(void) { }
 			virtual ~ITMSceneReconstructionEngine(void) { }
 		};
@@ -2,4 +2,4 @@
 
 #include "ITMTrackerFactory.h"
 
-template class ITMLib::Engine::ITMTrackerFactory<ITMVoxel, ITMVoxelIndex>;
+ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(ITMLib::Engine::ITMTrackerFactory)
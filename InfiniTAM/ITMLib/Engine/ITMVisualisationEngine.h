@@ -82,6 +82,8 @@ namespace ITMLib
 
 		template<class TIndex> struct IndexToRenderState { typedef ITMRenderState type; };
 		template<> struct IndexToRenderState<ITMVoxelBlockHash> { typedef ITMRenderState_VH type; };
+		template<> struct IndexToRenderState<ITMVoxelBlockOpenHash> { typedef ITMRenderState_VH type; };
+		template<> struct IndexToRenderState<ITMVoxelBlockOctree> { typedef ITMRenderState_VH type; };
 
 		/** \brief
 			Interface to engines helping with the visualisation of
@@ -4,8 +4,18 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <vector>
 
 #include "../Utils/ITMLibDefines.h"
+#include "ITMSceneParams.h"
+#include "ITMStoredBlockReader.h"
+#include "ITMVoxelBlockCodec.h"
 #ifndef COMPILE_WITHOUT_CUDA
 #include "../../ORUtils/CUDADefines.h"
 #endif
@@ -14,26 +24,562 @@ namespace ITMLib
 {
 	namespace Objects
 	{
+		/** \brief
+		Host memory for the voxel blocks swapped out of the local
+		voxel block array, and the swap state of each hash entry.
+
+		Stored blocks are encoded with ITMVoxelBlockCodec, unless
+		ITMSceneParams::useCompressedGlobalCache is off, and kept in
+		pools of slots that hold 1/SDF_GLOBAL_CACHE_SIZE_CLASSES,
+		2/SDF_GLOBAL_CACHE_SIZE_CLASSES, ... of a voxel block. Each
+		hash entry refers to the slot of its block. Blocks that do
+		not encode into the smaller slots go to the pool of the
+		largest slots as they are. The pools grow by chunks of
+		SDF_GLOBAL_CACHE_CHUNK_SIZE slots, so a cache with few
+		stored blocks only takes the memory of these, plus an int
+		per entry.
+
+		With ITMSceneParams::globalCacheMemoryLimit set, the least
+		recently stored or loaded blocks are moved to pools of the
+		same slot sizes in a file on disk once the blocks in memory
+		take more than that. Blocks on disk are read back by a
+		background thread, see RequestStoredData.
+
+		On the CPU, the entries to be swapped in and out are kept in
+		two queues, which are fed while the list of visible entries
+		is built. The queue of entries to be swapped in holds every
+		entry in swap state 1 once. The queue of entries to be
+		swapped out holds every invisible entry in swap state 2 at
+		least once, and may hold entries that changed since, which
+		are dropped when they are reached.
+		*/
 		template<class TVoxel>
 		class ITMGlobalCache
 		{
 		private:
-			bool *hasStoredData;
-			TVoxel *storedVoxelBlocks;
+			/** Slots of one size, in chunks that never move. */
+			struct StoredBlockPool
+			{
+				int slotSize;
+
+				/** The chunks in memory, NULL for pools on disk. */
+				uchar **chunks;
+				/** Offset of each chunk in its file, -1 for chunks on the heap. */
+				off_t *chunkOffsets;
+				int noChunks;
+
+				/** Slots not in use, the lowest on top. */
+				int *freeSlots;
+				int noFreeSlots;
+
+				/** Address of the entry each slot in use belongs to. */
+				int *slotOwners;
+
+				/** For slots in memory, the slots used before and
+				after them, see lruFirstSlot. For slots on disk, the
+				ID of the read of the slot in flight, 0 if none.
+				*/
+				int *lruPrevSlots, *lruNextSlots;
+				int *readIds;
+			};
+
+			StoredBlockPool storedBlockPools[SDF_GLOBAL_CACHE_SIZE_CLASSES];
+			StoredBlockPool diskBlockPools[SDF_GLOBAL_CACHE_SIZE_CLASSES];
+
+			/** Slot of the stored block of each entry, -1 for
+			entries without stored data. Slot i >= 0 is slot
+			i / SDF_GLOBAL_CACHE_SIZE_CLASSES of the pool
+			i % SDF_GLOBAL_CACHE_SIZE_CLASSES in memory, slot
+			i <= -2 is slot -2 - i of the pools on disk.
+			*/
+			int *storedSlots;
+
+			bool useCompression;
+			uchar *encodedBlock;
+
+			/** Slots in memory from the most to the least
+			recently used, -1 if there are none. */
+			int lruFirstSlot, lruLastSlot;
+
+			/** Bytes of the slots in use in memory, and how many
+			they may take before blocks are moved to disk, 0 for
+			no limit.
+			*/
+			size_t storedBlocksSize, memoryLimit;
+
 			ITMHashSwapState *swapStates_host, *swapStates_device;
 
 			bool *hasSyncedData_host, *hasSyncedData_device;
 			TVoxel *syncedVoxelBlocks_host, *syncedVoxelBlocks_device;
 
 			int *neededEntryIDs_host, *neededEntryIDs_device;
+
+			/** Queues of the entries to be swapped in and out, oldest
+			first, each sized to the number of entries. */
+			int *swapInEntryIDs, *swapOutEntryIDs;
+			int noSwapInEntries, noSwapOutEntries;
+			bool *isQueuedForSwapOut;
+
+			/** Unlinked temporary file the chunks are mapped from,
+			see ITMSceneParams::useMappedGlobalCache. -1 if they
+			are allocated on the heap.
+			*/
+			int storedBlocksFile;
+			off_t storedBlocksFileSize;
+			bool useMappedStorage;
+
+			/** Unlinked temporary file of the pools on disk, -1
+			until the first block is moved there. */
+			int diskBlocksFile;
+			off_t diskBlocksFileSize;
+
+			/** Reads of slots on disk, requested by the main
+			thread and done in the background. */
+			ITMStoredBlockReader *storedBlockReader;
+			int lastReadId;
+
+			/** Replace the entries of a swap queue by their new
+			addresses, dropping those not in swap state @p state and
+			those listed twice. isQueuedForSwapOut marks the entries
+			kept, it must be clear before.
+			*/
+			void moveSwapQueue(int *entryIDs, int &noEntries, const int *newAddressOf, uchar state)
+			{
+				int noKeptEntries = 0;
+				for (int i = 0; i < noEntries; i++)
+				{
+					int address = newAddressOf[entryIDs[i]];
+					if (swapStates_host[address].state != state || isQueuedForSwapOut[address]) continue;
+					isQueuedForSwapOut[address] = true;
+					entryIDs[noKeptEntries++] = address;
+				}
+				noEntries = noKeptEntries;
+			}
+
+			/** Create an unlinked temporary file in $TMPDIR, or
+			/tmp. Returns -1 if it could not be created. */
+			static int createTemporaryFile(void)
+			{
+#ifndef _WIN32
+				const char *tmpDir = getenv("TMPDIR");
+				char fileName[4096];
+				snprintf(fileName, sizeof(fileName), "%s/itm_global_cache_XXXXXX", tmpDir != NULL ? tmpDir : "/tmp");
+				int file = mkstemp(fileName);
+				if (file >= 0) unlink(fileName);
+				return file;
+#else
+				return -1;
+#endif
+			}
+
+			/** Map @p chunkSize more bytes from storedBlocksFile,
+			creating the file or growing it first. Returns NULL if
+			they could not be mapped.
+			*/
+			uchar *mapStoredBlockChunk(size_t chunkSize)
+			{
+#ifndef _WIN32
+				if (storedBlocksFile < 0) storedBlocksFile = createTemporaryFile();
+				if (storedBlocksFile < 0) return NULL;
+
+				if (ftruncate(storedBlocksFile, storedBlocksFileSize + (off_t)chunkSize) != 0) return NULL;
+
+				void *chunk = mmap(NULL, chunkSize, PROT_READ | PROT_WRITE, MAP_SHARED, storedBlocksFile, storedBlocksFileSize);
+				if (chunk == MAP_FAILED) return NULL;
+
+				storedBlocksFileSize += chunkSize;
+				return (uchar*)chunk;
+#else
+				return NULL;
+#endif
+			}
+
+			/** Add a chunk to @p pool and its slots to the free
+			slots. Chunks of pools on disk are appended to
+			diskBlocksFile.
+			*/
+			void addStoredBlockChunk(StoredBlockPool &pool, bool onDisk)
+			{
+				size_t chunkSize = (size_t)SDF_GLOBAL_CACHE_CHUNK_SIZE * pool.slotSize;
+				off_t chunkOffset = -1;
+
+				uchar *chunk = NULL;
+				if (onDisk)
+				{
+					chunkOffset = diskBlocksFileSize;
+					diskBlocksFileSize += chunkSize;
+				}
+				else
+				{
+					if (useMappedStorage)
+					{
+						chunkOffset = storedBlocksFileSize;
+						chunk = mapStoredBlockChunk(chunkSize);
+						if (chunk == NULL)
+						{
+							printf("Error: Could not map the global cache from a temporary file, allocating it on the heap instead!\n");
+							useMappedStorage = false;
+						}
+					}
+					if (chunk == NULL)
+					{
+						chunk = (uchar*)malloc(chunkSize);
+						chunkOffset = -1;
+					}
+				}
+
+				int chunkIdx = pool.noChunks++;
+				int noSlots = pool.noChunks * SDF_GLOBAL_CACHE_CHUNK_SIZE;
+				if (!onDisk)
+				{
+					pool.chunks = (uchar**)realloc(pool.chunks, pool.noChunks * sizeof(uchar*));
+					pool.chunks[chunkIdx] = chunk;
+					pool.lruPrevSlots = (int*)realloc(pool.lruPrevSlots, noSlots * sizeof(int));
+					pool.lruNextSlots = (int*)realloc(pool.lruNextSlots, noSlots * sizeof(int));
+				}
+				else
+				{
+					pool.readIds = (int*)realloc(pool.readIds, noSlots * sizeof(int));
+					memset(pool.readIds + chunkIdx * SDF_GLOBAL_CACHE_CHUNK_SIZE, 0, SDF_GLOBAL_CACHE_CHUNK_SIZE * sizeof(int));
+				}
+				pool.chunkOffsets = (off_t*)realloc(pool.chunkOffsets, pool.noChunks * sizeof(off_t));
+				pool.chunkOffsets[chunkIdx] = chunkOffset;
+				pool.slotOwners = (int*)realloc(pool.slotOwners, noSlots * sizeof(int));
+
+				pool.freeSlots = (int*)realloc(pool.freeSlots, noSlots * sizeof(int));
+				for (int i = SDF_GLOBAL_CACHE_CHUNK_SIZE - 1; i >= 0; i--)
+					pool.freeSlots[pool.noFreeSlots++] = chunkIdx * SDF_GLOBAL_CACHE_CHUNK_SIZE + i;
+			}
+
+			static void initStoredBlockPools(StoredBlockPool *pools)
+			{
+				for (int sizeClass = 0; sizeClass < SDF_GLOBAL_CACHE_SIZE_CLASSES; sizeClass++)
+				{
+					StoredBlockPool &pool = pools[sizeClass];
+					pool.slotSize = ITMVoxelBlockCodec<TVoxel>::noBlockBytes / SDF_GLOBAL_CACHE_SIZE_CLASSES * (sizeClass + 1);
+					pool.chunks = NULL; pool.chunkOffsets = NULL; pool.noChunks = 0;
+					pool.freeSlots = NULL; pool.noFreeSlots = 0;
+					pool.slotOwners = NULL; pool.lruPrevSlots = NULL; pool.lruNextSlots = NULL; pool.readIds = NULL;
+				}
+			}
+
+			static void freeStoredBlockPools(StoredBlockPool *pools)
+			{
+				for (int sizeClass = 0; sizeClass < SDF_GLOBAL_CACHE_SIZE_CLASSES; sizeClass++)
+				{
+					StoredBlockPool &pool = pools[sizeClass];
+					for (int chunkIdx = 0; pool.chunks != NULL && chunkIdx < pool.noChunks; chunkIdx++)
+					{
+#ifndef _WIN32
+						if (pool.chunkOffsets[chunkIdx] >= 0)
+						{
+							munmap(pool.chunks[chunkIdx], (size_t)SDF_GLOBAL_CACHE_CHUNK_SIZE * pool.slotSize);
+							continue;
+						}
+#endif
+						free(pool.chunks[chunkIdx]);
+					}
+					free(pool.chunks);
+					free(pool.chunkOffsets);
+					free(pool.freeSlots);
+					free(pool.slotOwners);
+					free(pool.lruPrevSlots);
+					free(pool.lruNextSlots);
+					free(pool.readIds);
+				}
+			}
+
+			inline StoredBlockPool &poolOf(int slot) { return slot >= 0 ? storedBlockPools[slot % SDF_GLOBAL_CACHE_SIZE_CLASSES] : diskBlockPools[(-2 - slot) % SDF_GLOBAL_CACHE_SIZE_CLASSES]; }
+			inline const StoredBlockPool &poolOf(int slot) const { return slot >= 0 ? storedBlockPools[slot % SDF_GLOBAL_CACHE_SIZE_CLASSES] : diskBlockPools[(-2 - slot) % SDF_GLOBAL_CACHE_SIZE_CLASSES]; }
+			static inline int poolSlotOf(int slot) { return (slot >= 0 ? slot : -2 - slot) / SDF_GLOBAL_CACHE_SIZE_CLASSES; }
+			static inline int sizeClassOf(int slot) { return (slot >= 0 ? slot : -2 - slot) % SDF_GLOBAL_CACHE_SIZE_CLASSES; }
+
+			inline uchar *storedBlock(int slot) const
+			{
+				const StoredBlockPool &pool = poolOf(slot);
+				int poolSlot = poolSlotOf(slot);
+				return pool.chunks[poolSlot / SDF_GLOBAL_CACHE_CHUNK_SIZE] + (size_t)(poolSlot % SDF_GLOBAL_CACHE_CHUNK_SIZE) * pool.slotSize;
+			}
+
+			inline off_t storedBlockOffset(int slot) const
+			{
+				const StoredBlockPool &pool = poolOf(slot);
+				int poolSlot = poolSlotOf(slot);
+				off_t chunkOffset = pool.chunkOffsets[poolSlot / SDF_GLOBAL_CACHE_CHUNK_SIZE];
+				return chunkOffset >= 0 ? chunkOffset + (off_t)(poolSlot % SDF_GLOBAL_CACHE_CHUNK_SIZE) * pool.slotSize : -1;
+			}
+
+			/** Take a slot of @p sizeClass for @p address, in memory
+			or on disk. Slots in memory become the most recently
+			used.
+			*/
+			int allocateSlot(int sizeClass, bool onDisk, int address)
+			{
+				StoredBlockPool &pool = onDisk ? diskBlockPools[sizeClass] : storedBlockPools[sizeClass];
+				if (pool.noFreeSlots == 0) addStoredBlockChunk(pool, onDisk);
+
+				int poolSlot = pool.freeSlots[--pool.noFreeSlots];
+				pool.slotOwners[poolSlot] = address;
+
+				int slot = poolSlot * SDF_GLOBAL_CACHE_SIZE_CLASSES + sizeClass;
+				if (onDisk) return -2 - slot;
+
+				storedBlocksSize += pool.slotSize;
+				linkSlot(slot);
+				return slot;
+			}
+
+			void releaseSlot(int slot)
+			{
+				StoredBlockPool &pool = poolOf(slot);
+				int poolSlot = poolSlotOf(slot);
+				if (slot >= 0)
+				{
+					unlinkSlot(slot);
+					storedBlocksSize -= pool.slotSize;
+				}
+				// a read of the slot in flight is dropped when it finishes
+				else pool.readIds[poolSlot] = 0;
+				pool.freeSlots[pool.noFreeSlots++] = poolSlot;
+			}
+
+			void linkSlot(int slot)
+			{
+				StoredBlockPool &pool = poolOf(slot);
+				int poolSlot = poolSlotOf(slot);
+				pool.lruPrevSlots[poolSlot] = -1;
+				pool.lruNextSlots[poolSlot] = lruFirstSlot;
+				if (lruFirstSlot >= 0) poolOf(lruFirstSlot).lruPrevSlots[poolSlotOf(lruFirstSlot)] = slot;
+				else lruLastSlot = slot;
+				lruFirstSlot = slot;
+			}
+
+			void unlinkSlot(int slot)
+			{
+				StoredBlockPool &pool = poolOf(slot);
+				int poolSlot = poolSlotOf(slot);
+				int prevSlot = pool.lruPrevSlots[poolSlot], nextSlot = pool.lruNextSlots[poolSlot];
+				if (prevSlot >= 0) poolOf(prevSlot).lruNextSlots[poolSlotOf(prevSlot)] = nextSlot;
+				else lruFirstSlot = nextSlot;
+				if (nextSlot >= 0) poolOf(nextSlot).lruPrevSlots[poolSlotOf(nextSlot)] = prevSlot;
+				else lruLastSlot = prevSlot;
+			}
+
+			/** Write @p size bytes to the slot @p slot in memory. */
+			void writeStoredBlock(int slot, const uchar *data, int size)
+			{
+				off_t offset = storedBlockOffset(slot);
+#ifndef _WIN32
+				// writing through the mapping faults in the pages of the file one at a time, which is far slower
+				if (offset >= 0 && pwrite(storedBlocksFile, data, size, offset) == (ssize_t)size) return;
+#endif
+				memcpy(storedBlock(slot), data, size);
+			}
+
+			/** Decode the slot @p slot, in memory or on disk, into
+			@p data. Returns false if it could not be read. */
+			bool readStoredBlock(int slot, TVoxel *data) const
+			{
+				const uchar *block = NULL;
+				if (slot >= 0) block = storedBlock(slot);
+#ifndef _WIN32
+				else if (pread(diskBlocksFile, encodedBlock, poolOf(slot).slotSize, storedBlockOffset(slot)) == (ssize_t)poolOf(slot).slotSize) block = encodedBlock;
+#endif
+				if (block == NULL) return false;
+
+				if (sizeClassOf(slot) == SDF_GLOBAL_CACHE_SIZE_CLASSES - 1) memcpy(data, block, ITMVoxelBlockCodec<TVoxel>::noBlockBytes);
+				else ITMVoxelBlockCodec<TVoxel>::Decode(block, data);
+				return true;
+			}
+
+			/** Move the least recently used blocks to disk until the
+			blocks in memory take no more than memoryLimit. */
+			void evictStoredBlocks(void)
+			{
+				while (memoryLimit > 0 && storedBlocksSize > memoryLimit && lruLastSlot >= 0)
+				{
+					int slot = lruLastSlot;
+					int address = poolOf(slot).slotOwners[poolSlotOf(slot)];
+
+					bool isWritten = false;
+#ifndef _WIN32
+					if (diskBlocksFile < 0) diskBlocksFile = createTemporaryFile();
+					if (diskBlocksFile >= 0)
+					{
+						int diskSlot = allocateSlot(sizeClassOf(slot), true, address);
+						int size = poolOf(slot).slotSize;
+						isWritten = pwrite(diskBlocksFile, storedBlock(slot), size, storedBlockOffset(diskSlot)) == (ssize_t)size;
+						if (isWritten)
+						{
+							releaseSlot(slot);
+							storedSlots[address] = diskSlot;
+						}
+						else releaseSlot(diskSlot);
+					}
+#endif
+					if (!isWritten)
+					{
+						printf("Error: Could not move blocks of the global cache to disk, keeping them all in memory instead!\n");
+						memoryLimit = 0;
+					}
+				}
+			}
+
 		public:
-			inline void SetStoredData(int address, TVoxel *data) 
-			{ 
-				hasStoredData[address] = true; 
-				memcpy(storedVoxelBlocks + address * SDF_BLOCK_SIZE3, data, sizeof(TVoxel) * SDF_BLOCK_SIZE3);
+			inline void SetStoredData(int address, TVoxel *data)
+			{
+				const int noBlockBytes = ITMVoxelBlockCodec<TVoxel>::noBlockBytes;
+				const int largestClass = SDF_GLOBAL_CACHE_SIZE_CLASSES - 1;
+
+				int size = useCompression ? ITMVoxelBlockCodec<TVoxel>::Encode(data, encodedBlock, storedBlockPools[largestClass - 1].slotSize) : -1;
+				int sizeClass = size >= 0 ? (size * SDF_GLOBAL_CACHE_SIZE_CLASSES - 1) / noBlockBytes : largestClass;
+
+				int slot = storedSlots[address];
+				if (slot >= 0 && sizeClassOf(slot) == sizeClass)
+				{
+					unlinkSlot(slot);
+					linkSlot(slot);
+				}
+				else
+				{
+					ClearStoredData(address);
+					storedSlots[address] = allocateSlot(sizeClass, false, address);
+				}
+
+				if (sizeClass == largestClass) writeStoredBlock(storedSlots[address], (const uchar*)data, noBlockBytes);
+				else writeStoredBlock(storedSlots[address], encodedBlock, size);
+
+				evictStoredBlocks();
+			}
+			inline void ClearStoredData(int address)
+			{
+				int slot = storedSlots[address];
+				if (slot == -1) return;
+
+				releaseSlot(slot);
+				storedSlots[address] = -1;
+			}
+			inline bool HasStoredData(int address) const { return storedSlots[address] != -1; }
+
+			/** Decode the stored block of @p address into @p data.
+			Blocks on disk are read right away, which stalls until
+			the read finishes, see RequestStoredData.
+			*/
+			inline void GetStoredData(int address, TVoxel *data)
+			{
+				int slot = storedSlots[address];
+				if (slot >= 0)
+				{
+					unlinkSlot(slot);
+					linkSlot(slot);
+				}
+
+				if (!readStoredBlock(slot, data))
+				{
+					printf("Error: Could not read a block of the global cache from disk!\n");
+					for (int locId = 0; locId < SDF_BLOCK_SIZE3; locId++) data[locId] = TVoxel();
+				}
+			}
+
+			/** Give the stored block of @p fromAddress to @p toAddress,
+			whose own stored block is discarded. */
+			inline void MoveStoredData(int fromAddress, int toAddress)
+			{
+				if (fromAddress == toAddress) return;
+				ClearStoredData(toAddress);
+
+				int slot = storedSlots[fromAddress];
+				storedSlots[toAddress] = slot;
+				storedSlots[fromAddress] = -1;
+				if (slot != -1) poolOf(slot).slotOwners[poolSlotOf(slot)] = toAddress;
+			}
+
+			/** Returns whether the stored block of @p address, if
+			any, is in memory. If it is on disk, it is read in the
+			background, and brought to memory by the first call of
+			CollectStoredData after the read finished.
+			*/
+			bool RequestStoredData(int address)
+			{
+				int slot = storedSlots[address];
+				if (slot >= -1) return true;
+
+				int &readId = poolOf(slot).readIds[poolSlotOf(slot)];
+				if (readId != 0) return false;
+
+				if (++lastReadId <= 0) lastReadId = 1;
+				readId = lastReadId;
+
+				ITMStoredBlockRead read;
+				read.diskSlot = slot; read.readId = readId;
+				read.offset = storedBlockOffset(slot); read.size = poolOf(slot).slotSize;
+				read.data = NULL;
+
+				storedBlockReader->RequestRead(diskBlocksFile, read);
+
+				return false;
+			}
+
+			/** Bring the blocks read from disk since the last call
+			to memory, see RequestStoredData. */
+			void CollectStoredData(void)
+			{
+				std::vector<ITMStoredBlockRead> reads;
+				storedBlockReader->CollectReads(reads);
+
+				for (size_t readIdx = 0; readIdx < reads.size(); readIdx++)
+				{
+					const ITMStoredBlockRead &read = reads[readIdx];
+					StoredBlockPool &diskPool = poolOf(read.diskSlot);
+					int poolSlot = poolSlotOf(read.diskSlot);
+
+					// the slot was released, and maybe taken again, while it was read
+					if (diskPool.readIds[poolSlot] != read.readId) { free(read.data); continue; }
+					diskPool.readIds[poolSlot] = 0;
+
+					if (read.data == NULL)
+					{
+						printf("Error: Could not read a block of the global cache from disk!\n");
+						continue;
+					}
+
+					int address = diskPool.slotOwners[poolSlot];
+					int slot = allocateSlot(sizeClassOf(read.diskSlot), false, address);
+					writeStoredBlock(slot, read.data, read.size);
+					releaseSlot(read.diskSlot);
+					storedSlots[address] = slot;
+
+					free(read.data);
+				}
+
+				evictStoredBlocks();
+			}
+
+			/** Number of stored blocks, in memory and on disk. */
+			int GetNoStoredBlocks(void) const
+			{
+				int noStoredBlocks = 0;
+				for (int sizeClass = 0; sizeClass < SDF_GLOBAL_CACHE_SIZE_CLASSES; sizeClass++)
+				{
+					noStoredBlocks += storedBlockPools[sizeClass].noChunks * SDF_GLOBAL_CACHE_CHUNK_SIZE - storedBlockPools[sizeClass].noFreeSlots;
+					noStoredBlocks += diskBlockPools[sizeClass].noChunks * SDF_GLOBAL_CACHE_CHUNK_SIZE - diskBlockPools[sizeClass].noFreeSlots;
+				}
+				return noStoredBlocks;
 			}
-			inline bool HasStoredData(int address) const { return hasStoredData[address]; }
-			inline TVoxel *GetStoredVoxelBlock(int address) { return storedVoxelBlocks + address * SDF_BLOCK_SIZE3; }
+
+			/** Bytes of the slots the stored blocks in memory take,
+			of all chunks of the pools in memory, and of the file
+			of the pools on disk.
+			*/
+			size_t GetStoredBlocksSize(void) const { return storedBlocksSize; }
+			size_t GetStoredBlockPoolsSize(void) const
+			{
+				size_t poolsSize = 0;
+				for (int sizeClass = 0; sizeClass < SDF_GLOBAL_CACHE_SIZE_CLASSES; sizeClass++)
+					poolsSize += (size_t)storedBlockPools[sizeClass].noChunks * SDF_GLOBAL_CACHE_CHUNK_SIZE * storedBlockPools[sizeClass].slotSize;
+				return poolsSize;
+			}
+			size_t GetDiskBlockPoolsSize(void) const { return diskBlocksFileSize; }
 
 			bool *GetHasSyncedData(bool useGPU) const { return useGPU ? hasSyncedData_device : hasSyncedData_host; }
 			TVoxel *GetSyncedVoxelBlocks(bool useGPU) const { return useGPU ? syncedVoxelBlocks_device : syncedVoxelBlocks_host; }
@@ -41,55 +587,203 @@ namespace ITMLib
 			ITMHashSwapState *GetSwapStates(bool useGPU) { return useGPU ? swapStates_device : swapStates_host; }
 			int *GetNeededEntryIDs(bool useGPU) { return useGPU ? neededEntryIDs_device : neededEntryIDs_host; }
 
-			int noTotalEntries; 
+			/** Get the queue of the entries to be swapped in. Only
+			the first GetNoSwapInEntries() elements are valid.
+			*/
+			int *GetSwapInEntryIDs(void) { return swapInEntryIDs; }
+			int GetNoSwapInEntries(void) const { return noSwapInEntries; }
+			void SetNoSwapInEntries(int noSwapInEntries) { this->noSwapInEntries = noSwapInEntries; }
+
+			/** Get the queue of the entries to be swapped out, and
+			whether each entry is in it. Only the first
+			GetNoSwapOutEntries() elements are valid.
+			*/
+			int *GetSwapOutEntryIDs(void) { return swapOutEntryIDs; }
+			int GetNoSwapOutEntries(void) const { return noSwapOutEntries; }
+			void SetNoSwapOutEntries(int noSwapOutEntries) { this->noSwapOutEntries = noSwapOutEntries; }
+			bool *GetIsQueuedForSwapOut(void) { return isQueuedForSwapOut; }
+
+			int noTotalEntries;
+
+			/** Maximum number of blocks transferred in one swap operation. */
+			int noTransferBlocks;
+
+			explicit ITMGlobalCache(const ITMSceneParams *sceneParams)
+				: noTotalEntries(SDF_BUCKET_NUM + sceneParams->noExcessEntries), noTransferBlocks(sceneParams->noTransferBlocks)
+			{
+				storedSlots = (int*)malloc(noTotalEntries * sizeof(int));
+				for (int i = 0; i < noTotalEntries; i++) storedSlots[i] = -1;
+
+				// the pools grow with the first block stored in them
+				initStoredBlockPools(storedBlockPools);
+				initStoredBlockPools(diskBlockPools);
+
+				useCompression = sceneParams->useCompressedGlobalCache;
+				encodedBlock = (uchar*)malloc(ITMVoxelBlockCodec<TVoxel>::noBlockBytes);
+
+				lruFirstSlot = -1; lruLastSlot = -1;
+				storedBlocksSize = 0;
+				memoryLimit = (size_t)sceneParams->globalCacheMemoryLimit * 1024 * 1024;
+#ifdef _WIN32
+				if (memoryLimit > 0) printf("Error: Moving the global cache to disk is not supported on this platform, keeping it in memory instead!\n");
+				memoryLimit = 0;
+#endif
+
+				storedBlocksFile = -1; storedBlocksFileSize = 0;
+				useMappedStorage = sceneParams->useMappedGlobalCache;
+
+				diskBlocksFile = -1; diskBlocksFileSize = 0;
 
-			ITMGlobalCache() : noTotalEntries(SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE)
-			{	
-				hasStoredData = (bool*)malloc(noTotalEntries * sizeof(bool));
-				storedVoxelBlocks = (TVoxel*)malloc(noTotalEntries * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
-				memset(hasStoredData, 0, noTotalEntries);
+				storedBlockReader = new ITMStoredBlockReader();
+				lastReadId = 0;
 
 				swapStates_host = (ITMHashSwapState *)malloc(noTotalEntries * sizeof(ITMHashSwapState));
 				memset(swapStates_host, 0, sizeof(ITMHashSwapState) * noTotalEntries);
 
+				swapInEntryIDs = (int*)malloc(noTotalEntries * sizeof(int));
+				swapOutEntryIDs = (int*)malloc(noTotalEntries * sizeof(int));
+				noSwapInEntries = 0; noSwapOutEntries = 0;
+				isQueuedForSwapOut = (bool*)calloc(noTotalEntries, sizeof(bool));
+
 #ifndef COMPILE_WITHOUT_CUDA
-				ITMSafeCall(cudaMallocHost((void**)&syncedVoxelBlocks_host, SDF_TRANSFER_BLOCK_NUM * sizeof(TVoxel) * SDF_BLOCK_SIZE3));
-				ITMSafeCall(cudaMallocHost((void**)&hasSyncedData_host, SDF_TRANSFER_BLOCK_NUM * sizeof(bool)));
-				ITMSafeCall(cudaMallocHost((void**)&neededEntryIDs_host, SDF_TRANSFER_BLOCK_NUM * sizeof(int)));
+				ITMSafeCall(cudaMallocHost((void**)&syncedVoxelBlocks_host, noTransferBlocks * sizeof(TVoxel) * SDF_BLOCK_SIZE3));
+				ITMSafeCall(cudaMallocHost((void**)&hasSyncedData_host, noTransferBlocks * sizeof(bool)));
+				ITMSafeCall(cudaMallocHost((void**)&neededEntryIDs_host, noTransferBlocks * sizeof(int)));
 
 				ITMSafeCall(cudaMalloc((void**)&swapStates_device, noTotalEntries * sizeof(ITMHashSwapState)));
 				ITMSafeCall(cudaMemset(swapStates_device, 0, noTotalEntries * sizeof(ITMHashSwapState)));
 
-				ITMSafeCall(cudaMalloc((void**)&syncedVoxelBlocks_device, SDF_TRANSFER_BLOCK_NUM * sizeof(TVoxel) * SDF_BLOCK_SIZE3));
-				ITMSafeCall(cudaMalloc((void**)&hasSyncedData_device, SDF_TRANSFER_BLOCK_NUM * sizeof(bool)));
+				ITMSafeCall(cudaMalloc((void**)&syncedVoxelBlocks_device, noTransferBlocks * sizeof(TVoxel) * SDF_BLOCK_SIZE3));
+				ITMSafeCall(cudaMalloc((void**)&hasSyncedData_device, noTransferBlocks * sizeof(bool)));
 
-				ITMSafeCall(cudaMalloc((void**)&neededEntryIDs_device, SDF_TRANSFER_BLOCK_NUM * sizeof(int)));
+				ITMSafeCall(cudaMalloc((void**)&neededEntryIDs_device, noTransferBlocks * sizeof(int)));
 #else
-				syncedVoxelBlocks_host = (TVoxel *)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
-				hasSyncedData_host = (bool*)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(bool));
-				neededEntryIDs_host = (int*)malloc(SDF_TRANSFER_BLOCK_NUM * sizeof(int));
+				syncedVoxelBlocks_host = (TVoxel *)malloc(noTransferBlocks * sizeof(TVoxel) * SDF_BLOCK_SIZE3);
+				hasSyncedData_host = (bool*)malloc(noTransferBlocks * sizeof(bool));
+				neededEntryIDs_host = (int*)malloc(noTransferBlocks * sizeof(int));
+#endif
+			}
+
+			/** Grow the host data to @p noTotalEntries entries,
+			new entries have no stored data. The swap states on
+			the GPU are not resized. The pools of stored blocks
+			are left as they are.
+			*/
+			void Resize(int noTotalEntries)
+			{
+				if (noTotalEntries <= this->noTotalEntries) return;
+
+				storedSlots = (int*)realloc(storedSlots, noTotalEntries * sizeof(int));
+				for (int i = this->noTotalEntries; i < noTotalEntries; i++) storedSlots[i] = -1;
+
+				swapStates_host = (ITMHashSwapState *)realloc(swapStates_host, noTotalEntries * sizeof(ITMHashSwapState));
+				memset(swapStates_host + this->noTotalEntries, 0, sizeof(ITMHashSwapState) * (noTotalEntries - this->noTotalEntries));
+
+				swapInEntryIDs = (int*)realloc(swapInEntryIDs, noTotalEntries * sizeof(int));
+				swapOutEntryIDs = (int*)realloc(swapOutEntryIDs, noTotalEntries * sizeof(int));
+				isQueuedForSwapOut = (bool*)realloc(isQueuedForSwapOut, noTotalEntries * sizeof(bool));
+				memset(isQueuedForSwapOut + this->noTotalEntries, 0, sizeof(bool) * (noTotalEntries - this->noTotalEntries));
+
+				this->noTotalEntries = noTotalEntries;
+			}
+
+			/** Move the swap states and stored data of the entries at
+			@p oldAddresses to @p newAddresses, for a hash table whose
+			entries were rehashed. Both lists must hold distinct
+			addresses. Every address of @p newAddresses ends up with
+			the data of its old address, or none; old addresses that
+			receive nothing are cleared. Only the slots of the stored
+			blocks move, no block is copied. The queues of entries to
+			be swapped in and out follow their entries. The swap
+			states on the GPU are not moved.
+			*/
+			void MoveEntries(const int *oldAddresses, const int *newAddresses, int noEntries)
+			{
+				ITMHashSwapState *movedSwapStates = (ITMHashSwapState *)malloc(noEntries * sizeof(ITMHashSwapState));
+				int *movedSlots = (int*)malloc(noEntries * sizeof(int));
+
+				for (int i = 0; i < noEntries; i++)
+				{
+					movedSwapStates[i] = swapStates_host[oldAddresses[i]];
+					swapStates_host[oldAddresses[i]].state = 0;
+
+					movedSlots[i] = storedSlots[oldAddresses[i]];
+					storedSlots[oldAddresses[i]] = -1;
+				}
+
+				for (int i = 0; i < noEntries; i++)
+				{
+					// a block still stored here belongs to an entry that is not moved, and is replaced
+					ClearStoredData(newAddresses[i]);
+
+					swapStates_host[newAddresses[i]] = movedSwapStates[i];
+					storedSlots[newAddresses[i]] = movedSlots[i];
+					if (movedSlots[i] != -1) poolOf(movedSlots[i]).slotOwners[poolSlotOf(movedSlots[i])] = newAddresses[i];
+				}
+
+				free(movedSwapStates);
+				free(movedSlots);
+
+				int *newAddressOf = (int*)malloc(noTotalEntries * sizeof(int));
+				for (int i = 0; i < noTotalEntries; i++) newAddressOf[i] = i;
+				for (int i = 0; i < noEntries; i++) newAddressOf[oldAddresses[i]] = newAddresses[i];
+
+				for (int i = 0; i < noSwapOutEntries; i++) isQueuedForSwapOut[swapOutEntryIDs[i]] = false;
+
+				moveSwapQueue(swapInEntryIDs, noSwapInEntries, newAddressOf, 1);
+				for (int i = 0; i < noSwapInEntries; i++) isQueuedForSwapOut[swapInEntryIDs[i]] = false;
+				moveSwapQueue(swapOutEntryIDs, noSwapOutEntries, newAddressOf, 2);
+
+				free(newAddressOf);
+			}
+
+			/** Drop the stored data, swap states and swap queues of
+			all entries, for a hash table that was emptied. The pools
+			of stored blocks keep their chunks, reads from disk in
+			flight are dropped when they finish.
+			*/
+			void Reset(void)
+			{
+				for (int i = 0; i < noTotalEntries; i++) ClearStoredData(i);
+
+				memset(swapStates_host, 0, sizeof(ITMHashSwapState) * noTotalEntries);
+#ifndef COMPILE_WITHOUT_CUDA
+				ITMSafeCall(cudaMemset(swapStates_device, 0, noTotalEntries * sizeof(ITMHashSwapState)));
 #endif
+
+				noSwapInEntries = 0; noSwapOutEntries = 0;
+				memset(isQueuedForSwapOut, 0, sizeof(bool) * noTotalEntries);
 			}
 
+			/** Write the stored blocks to @p fileName, as a flag
+			for each entry followed by a block for each entry. */
 			void SaveToFile(char *fileName) const
 			{
-				TVoxel *storedData = storedVoxelBlocks;
+				TVoxel *storedData = (TVoxel*)calloc(SDF_BLOCK_SIZE3, sizeof(TVoxel));
+				TVoxel *emptyBlock = (TVoxel*)calloc(SDF_BLOCK_SIZE3, sizeof(TVoxel));
 
 				FILE *f = fopen(fileName, "wb");
 
-				fwrite(hasStoredData, sizeof(bool), noTotalEntries, f);
 				for (int i = 0; i < noTotalEntries; i++)
 				{
-					fwrite(storedData, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
-					storedData += SDF_BLOCK_SIZE3;
+					bool hasStoredData = storedSlots[i] != -1;
+					fwrite(&hasStoredData, sizeof(bool), 1, f);
+				}
+				for (int i = 0; i < noTotalEntries; i++)
+				{
+					bool hasStoredData = storedSlots[i] != -1 && readStoredBlock(storedSlots[i], storedData);
+					fwrite(hasStoredData ? storedData : emptyBlock, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
 				}
 
 				fclose(f);
+				free(storedData);
+				free(emptyBlock);
 			}
 
 			void ReadFromFile(char *fileName)
 			{
-				TVoxel *storedData = storedVoxelBlocks;
+				bool *hasStoredData = (bool*)malloc(noTotalEntries * sizeof(bool));
+				TVoxel *storedData = (TVoxel*)malloc(SDF_BLOCK_SIZE3 * sizeof(TVoxel));
 				FILE *f = fopen(fileName, "rb");
 
 				size_t tmp = fread(hasStoredData, sizeof(bool), noTotalEntries, f);
@@ -97,19 +791,33 @@ namespace ITMLib
 					for (int i = 0; i < noTotalEntries; i++)
 					{
 						fread(storedData, sizeof(TVoxel) * SDF_BLOCK_SIZE3, 1, f);
-						storedData += SDF_BLOCK_SIZE3;
+						if (hasStoredData[i]) SetStoredData(i, storedData);
+						else ClearStoredData(i);
 					}
 				}
 
 				fclose(f);
+				free(hasStoredData);
+				free(storedData);
 			}
 
-			~ITMGlobalCache(void) 
+			~ITMGlobalCache(void)
 			{
-				free(hasStoredData);
-				free(storedVoxelBlocks);
+				delete storedBlockReader;
+
+				freeStoredBlockPools(storedBlockPools);
+				freeStoredBlockPools(diskBlockPools);
+				free(storedSlots);
+				free(encodedBlock);
+#ifndef _WIN32
+				if (storedBlocksFile >= 0) close(storedBlocksFile);
+				if (diskBlocksFile >= 0) close(diskBlocksFile);
+#endif
 
 				free(swapStates_host);
+				free(swapInEntryIDs);
+				free(swapOutEntryIDs);
+				free(isQueuedForSwapOut);
 
 #ifndef COMPILE_WITHOUT_CUDA
 				ITMSafeCall(cudaFreeHost(hasSyncedData_host));
@@ -41,12 +41,26 @@ namespace ITMLib
 			{
 				this->memoryType = memoryType;
 
-				allocatedSize = noBlocks * blockSize;
+				// whole multiples of SDF_BLOCK_SIZE3, so that the
+				// structure of arrays layout also fits plain arrays
+				allocatedSize = ((noBlocks * blockSize + SDF_BLOCK_SIZE3 - 1) / SDF_BLOCK_SIZE3) * SDF_BLOCK_SIZE3;
 
 				voxelBlocks = new ORUtils::MemoryBlock<TVoxel>(allocatedSize, memoryType);
 				allocationList = new ORUtils::MemoryBlock<int>(noBlocks, memoryType);
 			}
 
+			/** Grow the array to @p noBlocks blocks, keeping the
+			voxels and the allocation list. Blocks keep their
+			index, but the data pointers change.
+			*/
+			void Resize(int noBlocks, int blockSize)
+			{
+				allocatedSize = ((noBlocks * blockSize + SDF_BLOCK_SIZE3 - 1) / SDF_BLOCK_SIZE3) * SDF_BLOCK_SIZE3;
+
+				voxelBlocks->Resize(allocatedSize);
+				allocationList->Resize(noBlocks);
+			}
+
 			~ITMLocalVBA(void)
 			{
 				delete voxelBlocks;
@@ -19,14 +19,15 @@ namespace ITMLib
 			MemoryDeviceType memoryType;
 
 			uint noTotalTriangles;
-			static const uint noMaxTriangles = SDF_LOCAL_BLOCK_NUM * 32;
+			uint noMaxTriangles;
 
 			ORUtils::MemoryBlock<Triangle> *triangles;
 
-			explicit ITMMesh(MemoryDeviceType memoryType)
+			ITMMesh(MemoryDeviceType memoryType, int noLocalBlocks)
 			{
 				this->memoryType = memoryType;
 				this->noTotalTriangles = 0;
+				this->noMaxTriangles = noLocalBlocks * 32;
 
 				triangles = new ORUtils::MemoryBlock<Triangle>(noMaxTriangles, memoryType);
 			}
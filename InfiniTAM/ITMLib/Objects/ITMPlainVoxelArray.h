@@ -7,6 +7,9 @@
 #endif
 
 #include "../Utils/ITMLibDefines.h"
+#ifndef __METALC__
+#include "ITMSceneParams.h"
+#endif
 #include "../../ORUtils/MemoryBlock.h"
 
 namespace ITMLib
@@ -46,7 +49,7 @@ namespace ITMLib
 
 #ifndef __METALC__
 		public:
-			ITMPlainVoxelArray(MemoryDeviceType memoryType)
+			ITMPlainVoxelArray(const ITMSceneParams *sceneParams, MemoryDeviceType memoryType)
 			{
 				this->memoryType = memoryType;
 
@@ -35,12 +35,12 @@ namespace ITMLib
 			/** Number of entries in the live list. */
 			int noVisibleEntries;
             
-			ITMRenderState_VH(int noTotalEntries, const Vector2i & imgSize, float vf_min, float vf_max, MemoryDeviceType memoryType = MEMORYDEVICE_CPU)
+			ITMRenderState_VH(int noTotalEntries, int noLocalBlocks, const Vector2i & imgSize, float vf_min, float vf_max, MemoryDeviceType memoryType = MEMORYDEVICE_CPU)
 				: ITMRenderState(imgSize, vf_min, vf_max, memoryType)
             {
 				this->memoryType = memoryType;
 
-				visibleEntryIDs = new ORUtils::MemoryBlock<int>(SDF_LOCAL_BLOCK_NUM, memoryType);
+				visibleEntryIDs = new ORUtils::MemoryBlock<int>(noLocalBlocks, memoryType);
 				entriesVisibleType = new ORUtils::MemoryBlock<uchar>(noTotalEntries, memoryType);
 				
 				noVisibleEntries = 0;
@@ -63,6 +63,16 @@ namespace ITMLib
 			*/
 			uchar *GetEntriesVisibleType(void) { return entriesVisibleType->GetData(memoryType); }
 
+			/** Grow the lists for a scene whose hash table or
+			local voxel block array has grown, keeping the
+			visibility information.
+			*/
+			void Resize(int noTotalEntries, int noLocalBlocks)
+			{
+				if (entriesVisibleType->dataSize < (size_t)noTotalEntries) entriesVisibleType->Resize(noTotalEntries);
+				if (visibleEntryIDs->dataSize < (size_t)noLocalBlocks) visibleEntryIDs->Resize(noLocalBlocks);
+			}
+
 #ifdef COMPILE_WITH_METAL
 			const void* GetVisibleEntryIDs_MB(void) { return visibleEntryIDs->GetMetalBuffer(); }
 			const void* GetEntriesVisibleType_MB(void) { return entriesVisibleType->GetMetalBuffer(); }
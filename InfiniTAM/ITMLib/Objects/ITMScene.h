@@ -34,12 +34,18 @@ namespace ITMLib
 			/** Global content of the 8x8x8 voxel blocks -- stored on host only */
 			ITMGlobalCache<TVoxel> *globalCache;
 
+			/** Position of the origin of the scene coordinates in the
+			    world, in voxel blocks. Re-centering the scene moves it,
+			    see ITMSceneParams::recenteringDistance. */
+			Vector3i blockOrigin;
+
 			ITMScene(const ITMSceneParams *sceneParams, bool useSwapping, MemoryDeviceType memoryType)
-				: index(memoryType), localVBA(memoryType, index.getNumAllocatedVoxelBlocks(), index.getVoxelBlockSize())
+				: index(sceneParams, memoryType), localVBA(memoryType, index.getNumAllocatedVoxelBlocks(), index.getVoxelBlockSize())
 			{
 				this->sceneParams = sceneParams;
 				this->useSwapping = useSwapping;
-				if (useSwapping) globalCache = new ITMGlobalCache<TVoxel>();
+				this->blockOrigin = Vector3i(0, 0, 0);
+				if (useSwapping) globalCache = new ITMGlobalCache<TVoxel>(sceneParams);
 			}
 
 			~ITMScene(void)
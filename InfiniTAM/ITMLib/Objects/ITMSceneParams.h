@@ -1,8 +1,12 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
-#pragma once
+// the capacity defaults come from ITMLibDefines.h, whose index classes
+// include this header again and need it complete, so it is guarded below
+// the include rather than with #pragma once
+#include "../Utils/ITMLibDefines.h"
 
-#include "../Objects/ITMIntrinsics.h"
+#ifndef ITMLIB_ITMSCENEPARAMS_H
+#define ITMLIB_ITMSCENEPARAMS_H
 
 namespace ITMLib
 {
@@ -46,6 +50,118 @@ namespace ITMLib
 			/** Stop integration once maxW has been reached. */
 			bool stopIntegratingAtMaxW;
 
+			/** @{ */
+			/** \brief
+			    Capacities of the voxel block hash: number of
+			    voxel blocks kept in the local voxel block array,
+			    number of entries in the excess (collision) list
+			    and maximum number of blocks moved in one swap
+			    operation. The defaults are SDF_LOCAL_BLOCK_NUM,
+			    SDF_EXCESS_LIST_SIZE and SDF_TRANSFER_BLOCK_NUM.
+			*/
+			int noLocalBlocks, noExcessEntries, noTransferBlocks;
+
+			/** @} */
+			/** Run the block allocation and visible list passes
+			    of the CPU reconstruction engine in parallel. The
+			    result is identical to the serial passes.
+			*/
+			bool useParallelAllocation;
+
+			/** Integrate voxels of the CPU reconstruction engine
+			    a row at a time with SIMD instructions. Only used
+			    for voxel types without colour information.
+			*/
+			bool useVectorisedIntegration;
+
+			/** Store the voxels of each voxel block as separate
+			    planes of SDF values, weights and colours instead
+			    of an array of voxel structs. Honoured by the CPU
+			    engines only.
+			*/
+			bool useSoAVoxelBlocks;
+
+			/** @{ */
+			/** \brief
+			    Every @ref garbageCollectionInterval frames, look
+			    at up to @ref garbageCollectionBudget allocated
+			    hash entries and free the voxel blocks that hold
+			    no surface, i.e. whose voxels all have no weight
+			    or the truncation value. An interval of 0 turns
+			    garbage collection off.
+			*/
+			int garbageCollectionInterval, garbageCollectionBudget;
+
+			/** @} */
+			/** Keep at most this fraction of the buckets, the
+			    excess list and the local voxel block array of the
+			    CPU voxel block hash in use. The buckets double and
+			    all entries are rehashed once there are more
+			    entries than this fraction of them. The excess list
+			    and the voxel block array grow before the blocks of
+			    a frame are handed out, by half of their capacity,
+			    but at least by @ref noExcessEntries or
+			    @ref noLocalBlocks. A value of 0 keeps the
+			    capacities fixed.
+			*/
+			float growthThreshold;
+
+			/** Every @ref defragmentationInterval frames, move the
+			    voxel blocks of the CPU engines to the front of the
+			    local voxel block array, sorted by the Morton order
+			    of their block positions, so that neighbouring
+			    blocks are close in memory. A value of 0 only
+			    defragments on request.
+			*/
+			int defragmentationInterval;
+
+			/** Once the camera is further than this from the
+			    origin of the scene, usually given in meters, move
+			    the origin to the nearest voxel block corner under
+			    the camera. This keeps the scene coordinates and
+			    block positions small on long trajectories. A value
+			    of 0 keeps the origin where it is.
+			*/
+			float recenteringDistance;
+
+			/** Number of hash entries the CPU voxel block hash
+			    moves to the new origin per frame. The blocks are
+			    rehashed into a second table over several frames,
+			    which then replaces the table in use. This should
+			    stay well above the number of blocks allocated per
+			    frame for the move to finish.
+			*/
+			int recenteringBudget;
+
+			/** Map the chunks of voxel blocks swapped out to
+			    ITMGlobalCache from a temporary file instead of
+			    allocating them on the heap. The file grows with
+			    the pool of stored blocks, and the OS can write
+			    cold ones back to it rather than keep them in RAM.
+			    The file is created in $TMPDIR, or /tmp.
+			*/
+			bool useMappedGlobalCache;
+
+			/** Encode the voxel blocks swapped out to
+			    ITMGlobalCache with ITMVoxelBlockCodec, so that
+			    they take a fraction of the host memory, at the
+			    cost of encoding them on every swap out and
+			    decoding them on every swap in.
+			*/
+			bool useCompressedGlobalCache;
+
+			/** Once the voxel blocks swapped out to ITMGlobalCache
+			    take more than this many MB of host memory, move the
+			    least recently used ones to a temporary file on
+			    disk, created in $TMPDIR, or /tmp. They are read
+			    back in the background when they are swapped in
+			    again. A value of 0 keeps all of them in memory.
+			*/
+			int globalCacheMemoryLimit;
+
+			/** The other parameters are set to the capacities of
+			    ITMLibDefines.h, with all optional features off.
+			*/
 			ITMSceneParams(float mu, int maxW, float voxelSize, 
 				float viewFrustum_min, float viewFrustum_max, bool stopIntegratingAtMaxW)
 			{
@@ -54,6 +170,21 @@ namespace ITMLib
 				this->voxelSize = voxelSize;
 				this->viewFrustum_min = viewFrustum_min; this->viewFrustum_max = viewFrustum_max;
 				this->stopIntegratingAtMaxW = stopIntegratingAtMaxW;
+				this->noLocalBlocks = SDF_LOCAL_BLOCK_NUM;
+				this->noExcessEntries = SDF_EXCESS_LIST_SIZE;
+				this->noTransferBlocks = SDF_TRANSFER_BLOCK_NUM;
+				this->useParallelAllocation = false;
+				this->useVectorisedIntegration = false;
+				this->useSoAVoxelBlocks = false;
+				this->garbageCollectionInterval = 0;
+				this->garbageCollectionBudget = 4096;
+				this->growthThreshold = 0.0f;
+				this->defragmentationInterval = 0;
+				this->recenteringDistance = 0.0f;
+				this->recenteringBudget = 16384;
+				this->useMappedGlobalCache = false;
+				this->useCompressedGlobalCache = false;
+				this->globalCacheMemoryLimit = 0;
 			}
 
 			explicit ITMSceneParams(const ITMSceneParams *sceneParams) { this->SetFrom(sceneParams); }
@@ -66,7 +197,24 @@ namespace ITMLib
 				this->mu = sceneParams->mu;
 				this->maxW = sceneParams->maxW;
 				this->stopIntegratingAtMaxW = sceneParams->stopIntegratingAtMaxW;
+				this->noLocalBlocks = sceneParams->noLocalBlocks;
+				this->noExcessEntries = sceneParams->noExcessEntries;
+				this->noTransferBlocks = sceneParams->noTransferBlocks;
+				this->useParallelAllocation = sceneParams->useParallelAllocation;
+				this->useVectorisedIntegration = sceneParams->useVectorisedIntegration;
+				this->useSoAVoxelBlocks = sceneParams->useSoAVoxelBlocks;
+				this->garbageCollectionInterval = sceneParams->garbageCollectionInterval;
+				this->garbageCollectionBudget = sceneParams->garbageCollectionBudget;
+				this->growthThreshold = sceneParams->growthThreshold;
+				this->defragmentationInterval = sceneParams->defragmentationInterval;
+				this->recenteringDistance = sceneParams->recenteringDistance;
+				this->recenteringBudget = sceneParams->recenteringBudget;
+				this->useMappedGlobalCache = sceneParams->useMappedGlobalCache;
+				this->useCompressedGlobalCache = sceneParams->useCompressedGlobalCache;
+				this->globalCacheMemoryLimit = sceneParams->globalCacheMemoryLimit;
 			}
 		};
 	}
 }
+
+#endif
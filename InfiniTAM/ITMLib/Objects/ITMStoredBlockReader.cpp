@@ -0,0 +1,88 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include "ITMStoredBlockReader.h"
+
+#include <stdlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace ITMLib::Objects;
+
+struct ITMStoredBlockReader::ReadThread
+{
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::vector<std::pair<int, ITMStoredBlockRead> > requestedReads;
+	std::vector<ITMStoredBlockRead> finishedReads;
+	bool stopReading;
+
+	ReadThread(void) : stopReading(false) { thread = std::thread(&ReadThread::run, this); }
+
+	void run(void)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			condition.wait(lock, [this] { return stopReading || !requestedReads.empty(); });
+			if (stopReading) return;
+
+			int file = requestedReads.front().first;
+			ITMStoredBlockRead read = requestedReads.front().second;
+			requestedReads.erase(requestedReads.begin());
+			lock.unlock();
+
+			read.data = (uchar*)malloc(read.size);
+#ifndef _WIN32
+			if (pread(file, read.data, read.size, read.offset) != (ssize_t)read.size)
+#endif
+			{
+				free(read.data);
+				read.data = NULL;
+			}
+
+			lock.lock();
+			finishedReads.push_back(read);
+		}
+	}
+};
+
+ITMStoredBlockReader::ITMStoredBlockReader(void) { readThread = NULL; }
+
+ITMStoredBlockReader::~ITMStoredBlockReader(void)
+{
+	if (readThread == NULL) return;
+
+	{
+		std::lock_guard<std::mutex> lock(readThread->mutex);
+		readThread->stopReading = true;
+		readThread->condition.notify_one();
+	}
+	readThread->thread.join();
+
+	for (size_t readIdx = 0; readIdx < readThread->finishedReads.size(); readIdx++) free(readThread->finishedReads[readIdx].data);
+	delete readThread;
+}
+
+void ITMStoredBlockReader::RequestRead(int file, const ITMStoredBlockRead &read)
+{
+	if (readThread == NULL) readThread = new ReadThread();
+
+	std::lock_guard<std::mutex> lock(readThread->mutex);
+	readThread->requestedReads.push_back(std::make_pair(file, read));
+	readThread->condition.notify_one();
+}
+
+void ITMStoredBlockReader::CollectReads(std::vector<ITMStoredBlockRead> &reads)
+{
+	if (readThread == NULL) return;
+
+	std::lock_guard<std::mutex> lock(readThread->mutex);
+	reads.insert(reads.end(), readThread->finishedReads.begin(), readThread->finishedReads.end());
+	readThread->finishedReads.clear();
+}
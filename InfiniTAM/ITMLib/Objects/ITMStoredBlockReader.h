@@ -0,0 +1,51 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <sys/types.h>
+#include <vector>
+
+#include "../Utils/ITMLibDefines.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** A read of a slot of ITMGlobalCache on disk. */
+		struct ITMStoredBlockRead
+		{
+			int diskSlot;
+			int readId;
+			off_t offset;
+			int size;
+			/** The slot read, NULL if it could not be read. */
+			uchar *data;
+		};
+
+		/** \brief
+		Reads slots of ITMGlobalCache on disk in a background
+		thread, which is started by the first request.
+
+		The thread and its synchronisation are kept out of this
+		header, so it can be included from CUDA code.
+		*/
+		class ITMStoredBlockReader
+		{
+		private:
+			struct ReadThread;
+			ReadThread *readThread;
+
+		public:
+			/** Queue a read of @p read.size bytes at @p read.offset
+			of @p file. */
+			void RequestRead(int file, const ITMStoredBlockRead &read);
+
+			/** Append the reads finished since the last call to
+			@p reads, their data is to be freed by the caller. */
+			void CollectReads(std::vector<ITMStoredBlockRead> &reads);
+
+			ITMStoredBlockReader(void);
+			~ITMStoredBlockReader(void);
+		};
+	}
+}
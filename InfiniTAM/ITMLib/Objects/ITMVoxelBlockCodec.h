@@ -0,0 +1,146 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "../Utils/ITMLibDefines.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		Lossless codec for the voxel blocks stored in ITMGlobalCache.
+
+		The bytes of a block are regrouped into one plane for each
+		byte of the voxel type, e.g. the low and high bytes of the
+		SDF values and the weights, and each plane is replaced by
+		the differences of its consecutive bytes. Voxels that were
+		never observed, and weights that stopped at maxW, then turn
+		into runs of zeros. The result is written as a sequence of
+		tokens: a byte 0 <= t < 128 followed by t + 1 literal bytes,
+		or a byte t >= 128 for t - 126 zeros.
+
+		The codec only looks at bytes, so it works on the array of
+		structures and structure of arrays layouts alike.
+		*/
+		template<class TVoxel>
+		class ITMVoxelBlockCodec
+		{
+		private:
+			static inline int ctz64(unsigned long long x)
+			{
+#ifdef _MSC_VER
+				unsigned long idx;
+				_BitScanForward64(&idx, x);
+				return (int)idx;
+#else
+				return __builtin_ctzll(x);
+#endif
+			}
+
+		public:
+			static const int noBlockBytes = SDF_BLOCK_SIZE3 * sizeof(TVoxel);
+
+			/** Encode @p block into @p dst. Returns the number of
+			bytes written, or -1 if they would be more than
+			@p maxSize.
+			*/
+			static int Encode(const TVoxel *block, uchar *dst, int maxSize)
+			{
+				const uchar *src = (const uchar*)block;
+				uchar residuals[noBlockBytes + 8];
+
+				for (int byteIdx = 0; byteIdx < (int)sizeof(TVoxel); byteIdx++)
+				{
+					uchar *plane = residuals + byteIdx * SDF_BLOCK_SIZE3;
+					uchar prev = 0;
+					for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
+					{
+						uchar value = src[vIdx * sizeof(TVoxel) + byteIdx];
+						plane[vIdx] = (uchar)(value - prev);
+						prev = value;
+					}
+				}
+
+				// the bytes past the residuals stop the scans for zeros
+				memset(residuals + noBlockBytes, 1, 8);
+
+				int size = 0;
+				for (int i = 0; i < noBlockBytes;)
+				{
+					int noZeros = 0;
+					while (noZeros < 129 && residuals[i + noZeros] == 0) noZeros++;
+
+					if (noZeros >= 2)
+					{
+						if (size + 1 > maxSize) return -1;
+						dst[size++] = (uchar)(noZeros + 126);
+						i += noZeros;
+						continue;
+					}
+
+					// literals up to the next two zeros, which are worth a token
+					int noLiterals = 1;
+					while (noLiterals < 128 && i + noLiterals < noBlockBytes)
+					{
+						unsigned long long word;
+						memcpy(&word, residuals + i + noLiterals, sizeof(word));
+						unsigned long long zeroBytes = ~(((word & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | word | 0x7f7f7f7f7f7f7f7fULL);
+						unsigned long long zeroPairs = zeroBytes & (zeroBytes >> 8);
+						if (zeroPairs != 0) { noLiterals += ctz64(zeroPairs) / 8; break; }
+						noLiterals += 7;
+					}
+					if (noLiterals > 128) noLiterals = 128;
+					if (noLiterals > noBlockBytes - i) noLiterals = noBlockBytes - i;
+
+					if (size + 1 + noLiterals > maxSize) return -1;
+					dst[size++] = (uchar)(noLiterals - 1);
+					memcpy(dst + size, residuals + i, noLiterals);
+					size += noLiterals;
+					i += noLiterals;
+				}
+
+				return size;
+			}
+
+			/** Decode the block encoded at @p src into @p block. */
+			static void Decode(const uchar *src, TVoxel *block)
+			{
+				uchar residuals[noBlockBytes];
+
+				for (int i = 0; i < noBlockBytes;)
+				{
+					int token = *src++;
+					if (token >= 128)
+					{
+						memset(residuals + i, 0, token - 126);
+						i += token - 126;
+					}
+					else
+					{
+						memcpy(residuals + i, src, token + 1);
+						src += token + 1;
+						i += token + 1;
+					}
+				}
+
+				uchar *dst = (uchar*)block;
+				for (int byteIdx = 0; byteIdx < (int)sizeof(TVoxel); byteIdx++)
+				{
+					const uchar *plane = residuals + byteIdx * SDF_BLOCK_SIZE3;
+					uchar value = 0;
+					for (int vIdx = 0; vIdx < SDF_BLOCK_SIZE3; vIdx++)
+					{
+						value = (uchar)(value + plane[vIdx]);
+						dst[vIdx * sizeof(TVoxel) + byteIdx] = value;
+					}
+				}
+			}
+		};
+	}
+}
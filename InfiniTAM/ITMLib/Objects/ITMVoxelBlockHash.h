@@ -8,12 +8,52 @@
 
 #include "../Utils/ITMLibDefines.h"
 
+#ifndef __METALC__
+#include "ITMSceneParams.h"
+#endif
+
 #include "../../ORUtils/MemoryBlock.h"
 
 namespace ITMLib
 {
 	namespace Objects
 	{
+#ifndef __METALC__
+		/** \brief
+		Load of a voxel block hash and its local voxel block array,
+		see ITMVoxelBlockHash::GetStatistics().
+		*/
+		struct ITMHashStatistics
+		{
+			/** Number of buckets, and of buckets whose first entry
+			is present.
+			*/
+			int noBuckets, noOccupiedBuckets;
+			/** Size of the excess list, and number of its entries
+			that are handed out.
+			*/
+			int noExcessEntries, noUsedExcessEntries;
+			/** Longest and average number of entries in the chain
+			of an occupied bucket, counting the bucket itself.
+			*/
+			int maxChainLength;
+			float avgChainLength;
+			/** Size of the local voxel block array, and number of
+			its blocks that are handed out.
+			*/
+			int noLocalBlocks, noUsedLocalBlocks;
+			/** Number of entries present in the hash table, and of
+			those that are swapped out.
+			*/
+			int noAllocatedEntries, noSwappedOutEntries;
+			/** Number of blocks that could not be allocated in the
+			last frame and since the scene was reset, because the
+			local voxel block array or the excess list was full.
+			*/
+			int noDroppedBlocks, noDroppedBlocksTotal;
+		};
+#endif
+
 		/** \brief
 		This is the central class for the voxel block hash
 		implementation. It contains all the data needed on the CPU
@@ -24,22 +64,63 @@ namespace ITMLib
 		public:
 			typedef ITMHashEntry IndexData;
 
+			/** The cache also carries the bucket mask of the table it
+			reads, see GetHashMask(). Only the CPU hash changes its
+			number of buckets, so caches that are not made for a
+			particular table use SDF_HASH_MASK.
+			*/
 			struct IndexCache {
 				Vector3i blockPos;
 				int blockPtr;
+				int hashMask;
 				// _CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1) {}
-        _CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1) {}
-
+        _CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1), hashMask(SDF_HASH_MASK) {}
+				_CPU_AND_GPU_CODE_ IndexCache(int hashMask) : blockPos(0x7fffffff), blockPtr(-1), hashMask(hashMask) {}
 			};
 
-			/** Maximum number of total entries. */
-			static const CONSTPTR(int) noTotalEntries = SDF_BUCKET_NUM + SDF_EXCESS_LIST_SIZE;
 			static const CONSTPTR(int) voxelBlockSize = SDF_BLOCK_SIZE * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
 
 #ifndef __METALC__
+			/** Cache that also follows the block neighbour table,
+			so that reading a voxel of a block next to the cached
+			one needs no hash lookup. It carries the block
+			occupancy grid as well, for rays to leap over empty
+			cells, and the last cell of its first level found
+			to hold blocks.
+			*/
+			struct NeighbourCache {
+				Vector3i blockPos;
+				int blockPtr;
+				const int *blockNeighbours;
+				const int *blockOccupancy;
+				int blockOccupancyMask;
+				Vector3i occupiedCellPos;
+				int hashMask;
+				_CPU_AND_GPU_CODE_ NeighbourCache(const int *blockNeighbours, const int *blockOccupancy, int blockOccupancyMask, int hashMask)
+					: blockPos(0x7fffffff), blockPtr(-1), blockNeighbours(blockNeighbours), blockOccupancy(blockOccupancy),
+					blockOccupancyMask(blockOccupancyMask), occupiedCellPos(0x7fffffff), hashMask(hashMask) {}
+			};
+
+			/** Maximum number of total entries: GetBucketNum()
+			buckets followed by the excess list.
+			*/
+			int noTotalEntries;
+
 		private:
 			int lastFreeExcessListId;
 
+			/** Number of buckets, a power of two. SDF_BUCKET_NUM
+			unless the CPU reconstruction engine rehashed the
+			table into more buckets, see SwapEntries().
+			*/
+			int noBuckets;
+
+			/** Number of entries in the excess list and number
+			of voxel blocks in the local voxel block array,
+			initially as given by the scene parameters.
+			*/
+			int noExcessEntries, noLocalBlocks;
+
 			/** The actual data in the hash table. */
 			ORUtils::MemoryBlock<ITMHashEntry> *hashEntries;
 
@@ -50,20 +131,74 @@ namespace ITMLib
 			*/
 			ORUtils::MemoryBlock<int> *excessAllocationList;
 
+			/** Compact list of the entries that are present in the
+			hash table, i.e. allocated or swapped out, in order
+			of allocation. Engines iterate over this list instead
+			of scanning all @ref noTotalEntries entries.
+			*/
+			ORUtils::MemoryBlock<int> *allocatedEntryIDs;
+			int noAllocatedEntries;
+
+			/** Number of blocks that could not be allocated in the
+			last frame and since the scene was reset. Only counted
+			by the CPU engine.
+			*/
+			int noDroppedBlocks, noDroppedBlocksTotal;
+
+			/** For each voxel block of the local voxel block array,
+			the blocks at the SDF_BLOCK_NEIGHBOUR_NUM positions
+			around it, see blockNeighbourIdx(), or -1 where that
+			block is not in memory. Only kept on the CPU.
+			*/
+			ORUtils::MemoryBlock<int> *blockNeighbours;
+
+			/** Number of voxel blocks in memory in each cell of the
+			SDF_OCCUPANCY_LEVEL_NUM levels of the block occupancy
+			grid, see blockOccupancyIdx(). Cells that share a slot
+			add up, so a count of 0 always means the cell is
+			empty. Each level has noOccupancyCells slots, at least
+			as many as there are voxel blocks, so that the cells
+			holding blocks rarely share one. Only kept on the CPU.
+			*/
+			ORUtils::MemoryBlock<int> *blockOccupancy;
+			int noOccupancyCells;
+
+			static int occupancyCellsFor(int noLocalBlocks)
+			{
+				int noCells = SDF_OCCUPANCY_CELL_NUM;
+				while (noCells < noLocalBlocks) noCells *= 2;
+				return noCells;
+			}
+
 			MemoryDeviceType memoryType;
 
 		public:
-			ITMVoxelBlockHash(MemoryDeviceType memoryType)
+			ITMVoxelBlockHash(const ITMSceneParams *sceneParams, MemoryDeviceType memoryType)
 			{
 				this->memoryType = memoryType;
+				this->noExcessEntries = sceneParams->noExcessEntries;
+				this->noLocalBlocks = sceneParams->noLocalBlocks;
+				this->noBuckets = SDF_BUCKET_NUM;
+				this->noTotalEntries = noBuckets + noExcessEntries;
+
 				hashEntries = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, memoryType);
-				excessAllocationList = new ORUtils::MemoryBlock<int>(SDF_EXCESS_LIST_SIZE, memoryType);
+				excessAllocationList = new ORUtils::MemoryBlock<int>(noExcessEntries, memoryType);
+				allocatedEntryIDs = new ORUtils::MemoryBlock<int>(noTotalEntries, memoryType);
+				noAllocatedEntries = 0;
+				noDroppedBlocks = noDroppedBlocksTotal = 0;
+
+				blockNeighbours = memoryType == MEMORYDEVICE_CPU ? new ORUtils::MemoryBlock<int>(noLocalBlocks * SDF_BLOCK_NEIGHBOUR_NUM, memoryType) : NULL;
+				noOccupancyCells = occupancyCellsFor(noLocalBlocks);
+				blockOccupancy = memoryType == MEMORYDEVICE_CPU ? new ORUtils::MemoryBlock<int>(SDF_OCCUPANCY_LEVEL_NUM * noOccupancyCells, memoryType) : NULL;
 			}
 
 			~ITMVoxelBlockHash(void)
 			{
 				delete hashEntries;
 				delete excessAllocationList;
+				delete allocatedEntryIDs;
+				delete blockNeighbours;
+				delete blockOccupancy;
 			}
 
 			/** Get the list of actual entries in the hash table. */
@@ -81,16 +216,180 @@ namespace ITMLib
 			int *GetExcessAllocationList(void) { return excessAllocationList->GetData(memoryType); }
 
 			int GetLastFreeExcessListId(void) { return lastFreeExcessListId; }
+			int GetExcessListSize(void) const { return noExcessEntries; }
+
+			/** Get the number of buckets, and the mask that maps a
+			hash value to a bucket. Entry @p i of the excess list
+			is at GetBucketNum() + i.
+			*/
+			int GetBucketNum(void) const { return noBuckets; }
+			int GetHashMask(void) const { return noBuckets - 1; }
+
+			/** Get the compact list of entries that are allocated
+			or swapped out. Only the first GetNoAllocatedEntries()
+			elements are valid.
+			*/
+			const int *GetAllocatedEntryIDs(void) const { return allocatedEntryIDs->GetData(memoryType); }
+			int *GetAllocatedEntryIDs(void) { return allocatedEntryIDs->GetData(memoryType); }
+
+			int GetNoAllocatedEntries(void) const { return noAllocatedEntries; }
+			void SetNoAllocatedEntries(int noAllocatedEntries) { this->noAllocatedEntries = noAllocatedEntries; }
 			void SetLastFreeExcessListId(int lastFreeExcessListId) { this->lastFreeExcessListId = lastFreeExcessListId; }
 
+			/** Exchange the hash table, the excess list, the top of
+			the excess list and the block occupancy grid with
+			@p hashEntries, @p excessAllocationList,
+			@p lastFreeExcessListId and @p blockOccupancy, to
+			switch to a table that was rebuilt on the side. The
+			new table has @p noBuckets buckets in front of an
+			excess list of the same size. The allocated entry list
+			and anything else that refers to entries by their
+			address is left to the caller.
+			*/
+			void SwapEntries(ORUtils::MemoryBlock<ITMHashEntry> *&hashEntries, ORUtils::MemoryBlock<int> *&excessAllocationList,
+				int &lastFreeExcessListId, ORUtils::MemoryBlock<int> *&blockOccupancy, int noBuckets)
+			{
+				this->noBuckets = noBuckets;
+				this->noTotalEntries = noBuckets + noExcessEntries;
+				allocatedEntryIDs->Resize(noTotalEntries);
+
+				ORUtils::MemoryBlock<ITMHashEntry> *oldHashEntries = this->hashEntries;
+				this->hashEntries = hashEntries;
+				hashEntries = oldHashEntries;
+
+				ORUtils::MemoryBlock<int> *oldExcessAllocationList = this->excessAllocationList;
+				this->excessAllocationList = excessAllocationList;
+				excessAllocationList = oldExcessAllocationList;
+
+				int oldLastFreeExcessListId = this->lastFreeExcessListId;
+				this->lastFreeExcessListId = lastFreeExcessListId;
+				lastFreeExcessListId = oldLastFreeExcessListId;
+
+				ORUtils::MemoryBlock<int> *oldBlockOccupancy = this->blockOccupancy;
+				this->blockOccupancy = blockOccupancy;
+				blockOccupancy = oldBlockOccupancy;
+			}
+
+			/** Record the number of blocks that could not be
+			allocated in this frame, or clear both counters if
+			@p resetTotal is set.
+			*/
+			void SetNoDroppedBlocks(int noDroppedBlocks, bool resetTotal = false)
+			{
+				this->noDroppedBlocks = noDroppedBlocks;
+				this->noDroppedBlocksTotal = resetTotal ? noDroppedBlocks : noDroppedBlocksTotal + noDroppedBlocks;
+			}
+
+			/** Get the block neighbour table, NULL unless the hash
+			is kept on the CPU.
+			*/
+			const int *GetBlockNeighbours(void) const { return blockNeighbours != NULL ? blockNeighbours->GetData(memoryType) : NULL; }
+			int *GetBlockNeighbours(void) { return blockNeighbours != NULL ? blockNeighbours->GetData(memoryType) : NULL; }
+
+			/** Get the block occupancy grid, NULL unless the hash
+			is kept on the CPU.
+			*/
+			const int *GetBlockOccupancy(void) const { return blockOccupancy != NULL ? blockOccupancy->GetData(memoryType) : NULL; }
+			int *GetBlockOccupancy(void) { return blockOccupancy != NULL ? blockOccupancy->GetData(memoryType) : NULL; }
+
+			/** Get the number of slots per level of the block
+			occupancy grid minus one, see blockOccupancyIdx().
+			*/
+			int GetBlockOccupancyMask(void) const { return noOccupancyCells - 1; }
+
+			/** Fill in the load of the hash table. The chains are
+			followed from the allocated entry list only, so this
+			takes time in the number of present entries rather
+			than the size of the table. Hash tables kept on the
+			GPU are copied to the host first. The local voxel
+			block array is described by @p lastFreeBlockId, see
+			ITMLocalVBA.
+			*/
+			void GetStatistics(ITMHashStatistics *stats, int lastFreeBlockId) const
+			{
+				const ITMHashEntry *entries = hashEntries->GetData(MEMORYDEVICE_CPU);
+				const int *entryIDs = allocatedEntryIDs->GetData(MEMORYDEVICE_CPU);
+
+				ORUtils::MemoryBlock<ITMHashEntry> *entries_host = NULL;
+				ORUtils::MemoryBlock<int> *entryIDs_host = NULL;
+				if (memoryType == MEMORYDEVICE_CUDA)
+				{
+					entries_host = new ORUtils::MemoryBlock<ITMHashEntry>(noTotalEntries, MEMORYDEVICE_CPU);
+					entryIDs_host = new ORUtils::MemoryBlock<int>(noTotalEntries, MEMORYDEVICE_CPU);
+					entries_host->SetFrom(hashEntries, ORUtils::MemoryBlock<ITMHashEntry>::CUDA_TO_CPU);
+					entryIDs_host->SetFrom(allocatedEntryIDs, ORUtils::MemoryBlock<int>::CUDA_TO_CPU);
+					entries = entries_host->GetData(MEMORYDEVICE_CPU);
+					entryIDs = entryIDs_host->GetData(MEMORYDEVICE_CPU);
+				}
+
+				int noOccupiedBuckets = 0, noSwappedOutEntries = 0, maxChainLength = 0, noChainedEntries = 0;
+				for (int listIdx = 0; listIdx < noAllocatedEntries; listIdx++)
+				{
+					int targetIdx = entryIDs[listIdx];
+					if (entries[targetIdx].ptr == -1) noSwappedOutEntries++;
+					if (targetIdx >= noBuckets) continue;
+
+					int chainLength = 1;
+					for (int offset = entries[targetIdx].offset; offset >= 1; offset = entries[noBuckets + offset - 1].offset)
+						chainLength++;
+
+					noOccupiedBuckets++;
+					noChainedEntries += chainLength;
+					maxChainLength = MAX(maxChainLength, chainLength);
+				}
+
+				delete entries_host;
+				delete entryIDs_host;
+
+				stats->noBuckets = noBuckets;
+				stats->noOccupiedBuckets = noOccupiedBuckets;
+				stats->noExcessEntries = noExcessEntries;
+				stats->noUsedExcessEntries = noExcessEntries - 1 - lastFreeExcessListId;
+				stats->maxChainLength = maxChainLength;
+				stats->avgChainLength = noOccupiedBuckets > 0 ? (float)noChainedEntries / (float)noOccupiedBuckets : 0.0f;
+				stats->noLocalBlocks = noLocalBlocks;
+				stats->noUsedLocalBlocks = noLocalBlocks - 1 - lastFreeBlockId;
+				stats->noAllocatedEntries = noAllocatedEntries;
+				stats->noSwappedOutEntries = noSwappedOutEntries;
+				stats->noDroppedBlocks = noDroppedBlocks;
+				stats->noDroppedBlocksTotal = noDroppedBlocksTotal;
+			}
+
+			/** Grow the excess list to @p noExcessEntries entries
+			and the local voxel block array to @p noLocalBlocks
+			blocks, keeping all present entries. The buckets are
+			not touched, so entry IDs and block pointers stay
+			valid. Setting up the new entries is left to the
+			reconstruction engine.
+			*/
+			void Resize(int noExcessEntries, int noLocalBlocks)
+			{
+				this->noExcessEntries = noExcessEntries;
+				this->noLocalBlocks = noLocalBlocks;
+				this->noTotalEntries = noBuckets + noExcessEntries;
+
+				hashEntries->Resize(noTotalEntries);
+				excessAllocationList->Resize(noExcessEntries);
+				allocatedEntryIDs->Resize(noTotalEntries);
+				if (blockNeighbours != NULL) blockNeighbours->Resize(noLocalBlocks * SDF_BLOCK_NEIGHBOUR_NUM);
+
+				// the cells hash to other slots in a larger grid, the counts are left to be rebuilt
+				if (occupancyCellsFor(noLocalBlocks) != noOccupancyCells)
+				{
+					noOccupancyCells = occupancyCellsFor(noLocalBlocks);
+					if (blockOccupancy != NULL) blockOccupancy->Resize(SDF_OCCUPANCY_LEVEL_NUM * noOccupancyCells);
+				}
+			}
+
 #ifdef COMPILE_WITH_METAL
 			const void* GetEntries_MB(void) { return hashEntries->GetMetalBuffer(); }
 			const void* GetExcessAllocationList_MB(void) { return excessAllocationList->GetMetalBuffer(); }
+			const void* GetAllocatedEntryIDs_MB(void) { return allocatedEntryIDs->GetMetalBuffer(); }
 			const void* getIndexData_MB(void) const { return hashEntries->GetMetalBuffer(); }
 #endif
 
 			/** Maximum number of total entries. */
-			int getNumAllocatedVoxelBlocks(void) { return SDF_LOCAL_BLOCK_NUM; }
+			int getNumAllocatedVoxelBlocks(void) const { return noLocalBlocks; }
 			int getVoxelBlockSize(void) { return SDF_BLOCK_SIZE3; }
 
 			// Suppress the default copy constructor and assignment operator
@@ -0,0 +1,150 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#ifndef __METALC__
+#include <stdlib.h>
+#endif
+
+#include "../Utils/ITMLibDefines.h"
+
+#ifndef __METALC__
+#include "ITMSceneParams.h"
+#endif
+
+#include "../../ORUtils/MemoryBlock.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		Sparse octree over the voxel blocks. The root spans
+		2^SDF_OCTREE_DEPTH blocks along each axis, centred on the
+		origin, and is node 0. Nodes only exist where there are
+		blocks below them, so a lookup that ends at an empty octant
+		knows the whole octant is empty, and rays leap over it.
+
+		Entry IDs identify the children of the nodes, i.e. entry i
+		is child i % 8 of node i / 8. Only children of the last
+		level refer to voxel blocks, and only these are listed as
+		allocated or visible.
+
+		Blocks are never removed, so neither swapping nor garbage
+		collection are supported. The nodes are taken from a pool
+		of one node per voxel block, surfaces need far fewer. Blocks
+		outside of the root, or below a node that could not be
+		taken from the pool, are not allocated.
+		*/
+		class ITMVoxelBlockOctree
+		{
+		public:
+			typedef ITMOctreeNode IndexData;
+
+			/** Caches the last block found, and the node of the
+			last level above it, so that its seven siblings are
+			found without descending from the root. Lookups of
+			other blocks start at the last node of level
+			SDF_OCTREE_CACHED_LEVEL passed, if it holds them. A
+			failed lookup leaves the empty octant it ended at.
+			*/
+			struct IndexCache {
+				Vector3i blockPos;
+				int blockPtr;
+				Vector3i nodePos;
+				int nodeIdx;
+				Vector3i subtreePos;
+				int subtreeIdx;
+				/** Corner and width of the empty octant, in voxel blocks. 0 if unknown. */
+				Vector3i emptyPos;
+				int emptySize;
+				_CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1), nodePos(0x7fffffff), nodeIdx(-1),
+					subtreePos(0x7fffffff), subtreeIdx(-1), emptyPos(0x7fffffff), emptySize(0) {}
+			};
+
+			static const CONSTPTR(int) voxelBlockSize = SDF_BLOCK_SIZE * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+
+#ifndef __METALC__
+			/** Number of children of all nodes in the pool. */
+			int noTotalEntries;
+
+		private:
+			/** Number of voxel blocks in the local voxel block
+			array, as given by the scene parameters. The pool has
+			as many nodes.
+			*/
+			int noLocalBlocks;
+
+			/** The nodes, the root first and the others in the
+			order they were taken from the pool. */
+			ORUtils::MemoryBlock<ITMOctreeNode> *nodes;
+			int noUsedNodes;
+
+			/** Compact list of the children that refer to voxel
+			blocks, in order of allocation. Engines iterate over
+			this list instead of traversing the tree.
+			*/
+			ORUtils::MemoryBlock<int> *allocatedEntryIDs;
+			int noAllocatedEntries;
+
+			MemoryDeviceType memoryType;
+
+		public:
+			ITMVoxelBlockOctree(const ITMSceneParams *sceneParams, MemoryDeviceType memoryType)
+			{
+				this->memoryType = memoryType;
+				this->noLocalBlocks = sceneParams->noLocalBlocks;
+				this->noTotalEntries = noLocalBlocks * 8;
+
+				nodes = new ORUtils::MemoryBlock<ITMOctreeNode>(noLocalBlocks, memoryType);
+				allocatedEntryIDs = new ORUtils::MemoryBlock<int>(noLocalBlocks, memoryType);
+				noUsedNodes = 0;
+				noAllocatedEntries = 0;
+			}
+
+			~ITMVoxelBlockOctree(void)
+			{
+				delete nodes;
+				delete allocatedEntryIDs;
+			}
+
+			/** Get the nodes of the octree, the root first. */
+			const ITMOctreeNode *GetNodes(void) const { return nodes->GetData(memoryType); }
+			ITMOctreeNode *GetNodes(void) { return nodes->GetData(memoryType); }
+
+			const IndexData *getIndexData(void) const { return nodes->GetData(memoryType); }
+			IndexData *getIndexData(void) { return nodes->GetData(memoryType); }
+
+			/** Number of nodes taken from the pool, and the size
+			of the pool. */
+			int GetNoUsedNodes(void) const { return noUsedNodes; }
+			void SetNoUsedNodes(int noUsedNodes) { this->noUsedNodes = noUsedNodes; }
+			int GetNoNodes(void) const { return noLocalBlocks; }
+
+			/** Get the compact list of children that refer to
+			voxel blocks. Only the first GetNoAllocatedEntries()
+			elements are valid.
+			*/
+			const int *GetAllocatedEntryIDs(void) const { return allocatedEntryIDs->GetData(memoryType); }
+			int *GetAllocatedEntryIDs(void) { return allocatedEntryIDs->GetData(memoryType); }
+
+			int GetNoAllocatedEntries(void) const { return noAllocatedEntries; }
+			void SetNoAllocatedEntries(int noAllocatedEntries) { this->noAllocatedEntries = noAllocatedEntries; }
+
+#ifdef COMPILE_WITH_METAL
+			const void* GetNodes_MB(void) { return nodes->GetMetalBuffer(); }
+			const void* GetAllocatedEntryIDs_MB(void) { return allocatedEntryIDs->GetMetalBuffer(); }
+			const void* getIndexData_MB(void) const { return nodes->GetMetalBuffer(); }
+#endif
+
+			/** Number of voxel blocks in the local voxel block array. */
+			int getNumAllocatedVoxelBlocks(void) const { return noLocalBlocks; }
+			int getVoxelBlockSize(void) { return SDF_BLOCK_SIZE3; }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMVoxelBlockOctree(const ITMVoxelBlockOctree&);
+			ITMVoxelBlockOctree& operator=(const ITMVoxelBlockOctree&);
+#endif
+		};
+	}
+}
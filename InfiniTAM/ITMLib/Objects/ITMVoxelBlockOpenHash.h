@@ -0,0 +1,118 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#pragma once
+
+#ifndef __METALC__
+#include <stdlib.h>
+#endif
+
+#include "../Utils/ITMLibDefines.h"
+
+#ifndef __METALC__
+#include "ITMSceneParams.h"
+#endif
+
+#include "../../ORUtils/MemoryBlock.h"
+
+namespace ITMLib
+{
+	namespace Objects
+	{
+		/** \brief
+		Voxel block hash with open addressing instead of an excess
+		list. Colliding blocks are put into the next bucket with a
+		free slot, and each bucket keeps the keys of its
+		SDF_OPEN_HASH_SLOT_NUM slots next to each other, so that a
+		lookup compares all of them at once. Entry IDs identify
+		slots, i.e. entry i is slot i % SDF_OPEN_HASH_SLOT_NUM of
+		bucket i / SDF_OPEN_HASH_SLOT_NUM.
+
+		Blocks are never removed from the table, so neither
+		swapping nor garbage collection are supported.
+		*/
+		class ITMVoxelBlockOpenHash
+		{
+		public:
+			typedef ITMOpenHashBucket IndexData;
+
+			struct IndexCache {
+				Vector3i blockPos;
+				int blockPtr;
+				_CPU_AND_GPU_CODE_ IndexCache(void) : blockPos(0x7fffffff), blockPtr(-1) {}
+			};
+
+			static const CONSTPTR(int) voxelBlockSize = SDF_BLOCK_SIZE * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE;
+
+#ifndef __METALC__
+			/** Number of slots in all buckets. */
+			int noTotalEntries;
+
+		private:
+			/** Number of voxel blocks in the local voxel block
+			array, as given by the scene parameters.
+			*/
+			int noLocalBlocks;
+
+			/** The actual data in the hash table. */
+			ORUtils::MemoryBlock<ITMOpenHashBucket> *buckets;
+
+			/** Compact list of the taken slots, in order of
+			allocation. Engines iterate over this list instead of
+			scanning all @ref noTotalEntries slots.
+			*/
+			ORUtils::MemoryBlock<int> *allocatedEntryIDs;
+			int noAllocatedEntries;
+
+			MemoryDeviceType memoryType;
+
+		public:
+			ITMVoxelBlockOpenHash(const ITMSceneParams *sceneParams, MemoryDeviceType memoryType)
+			{
+				this->memoryType = memoryType;
+				this->noLocalBlocks = sceneParams->noLocalBlocks;
+				this->noTotalEntries = SDF_OPEN_HASH_BUCKET_NUM * SDF_OPEN_HASH_SLOT_NUM;
+
+				buckets = new ORUtils::MemoryBlock<ITMOpenHashBucket>(SDF_OPEN_HASH_BUCKET_NUM, memoryType);
+				allocatedEntryIDs = new ORUtils::MemoryBlock<int>(noLocalBlocks, memoryType);
+				noAllocatedEntries = 0;
+			}
+
+			~ITMVoxelBlockOpenHash(void)
+			{
+				delete buckets;
+				delete allocatedEntryIDs;
+			}
+
+			/** Get the buckets of the hash table. */
+			const ITMOpenHashBucket *GetBuckets(void) const { return buckets->GetData(memoryType); }
+			ITMOpenHashBucket *GetBuckets(void) { return buckets->GetData(memoryType); }
+
+			const IndexData *getIndexData(void) const { return buckets->GetData(memoryType); }
+			IndexData *getIndexData(void) { return buckets->GetData(memoryType); }
+
+			/** Get the compact list of taken slots. Only the first
+			GetNoAllocatedEntries() elements are valid.
+			*/
+			const int *GetAllocatedEntryIDs(void) const { return allocatedEntryIDs->GetData(memoryType); }
+			int *GetAllocatedEntryIDs(void) { return allocatedEntryIDs->GetData(memoryType); }
+
+			int GetNoAllocatedEntries(void) const { return noAllocatedEntries; }
+			void SetNoAllocatedEntries(int noAllocatedEntries) { this->noAllocatedEntries = noAllocatedEntries; }
+
+#ifdef COMPILE_WITH_METAL
+			const void* GetBuckets_MB(void) { return buckets->GetMetalBuffer(); }
+			const void* GetAllocatedEntryIDs_MB(void) { return allocatedEntryIDs->GetMetalBuffer(); }
+			const void* getIndexData_MB(void) const { return buckets->GetMetalBuffer(); }
+#endif
+
+			/** Number of voxel blocks in the local voxel block array. */
+			int getNumAllocatedVoxelBlocks(void) const { return noLocalBlocks; }
+			int getVoxelBlockSize(void) { return SDF_BLOCK_SIZE3; }
+
+			// Suppress the default copy constructor and assignment operator
+			ITMVoxelBlockOpenHash(const ITMVoxelBlockOpenHash&);
+			ITMVoxelBlockOpenHash& operator=(const ITMVoxelBlockOpenHash&);
+#endif
+		};
+	}
+}
@@ -38,7 +38,8 @@
 #define SDF_BLOCK_SIZE3 \
   512  // SDF_BLOCK_SIZE3 = SDF_BLOCK_SIZE * SDF_BLOCK_SIZE * SDF_BLOCK_SIZE
 #define SDF_LOCAL_BLOCK_NUM \
-  0x10000  // Number of locally stored blocks, currently 2^17
+  0x10000  // Default number of locally stored blocks, currently 2^17. Used
+           // to initialise ITMSceneParams::noLocalBlocks
 // #define SDF_LOCAL_BLOCK_NUM 0x08000 // Number of locally stored blocks,
 // currently 2^17
 
@@ -46,7 +47,12 @@
   0x120000  // Number of globally stored blocks: SDF_BUCKET_NUM +
             // SDF_EXCESS_LIST_SIZE
 #define SDF_TRANSFER_BLOCK_NUM \
-  0x1000  // Maximum number of blocks transfered in one swap operation
+  0x1000  // Default maximum number of blocks transfered in one swap
+          // operation, see ITMSceneParams::noTransferBlocks
+#define SDF_GLOBAL_CACHE_CHUNK_SIZE \
+  0x400  // Number of slots by which the pools of ITMGlobalCache grow
+#define SDF_GLOBAL_CACHE_SIZE_CLASSES \
+  16  // Number of slot sizes of ITMGlobalCache, in fractions of a voxel block
 
 #define SDF_BUCKET_NUM \
   0x100000  // Number of Hash Bucket, should be 2^n and bigger than
@@ -58,19 +64,109 @@
   0xfffff  // Used for get hashing value of the bucket index,  SDF_HASH_MASK =
            // SDF_BUCKET_NUM - 1
 #define SDF_EXCESS_LIST_SIZE \
-  0x20000  // 0x20000 Size of excess list, used to handle collisions. Also max
-           // offset (unsigned short) value.
+  0x20000  // 0x20000 Default size of excess list, used to handle collisions,
+           // see ITMSceneParams::noExcessEntries
+#define SDF_BLOCK_NEIGHBOUR_NUM \
+  27  // Entries per voxel block in the block neighbour table of the voxel
+      // block hash: the block itself and its 26 neighbours
+#define SDF_OCCUPANCY_LEVEL_NUM \
+  2  // Number of levels of the block occupancy grid of the voxel block hash
+#define SDF_OCCUPANCY_CELL_SHIFT \
+  3  // Cells of the first occupancy level span 2^3 blocks along each axis,
+     // 64 voxels, and each further level is 2^3 times as wide again
+#define SDF_OCCUPANCY_CELL_NUM \
+  0x1000  // Minimum number of counters per occupancy level, should be 2^n,
+          // levels get as many as there are voxel blocks, rounded up to 2^n
+
+#define SDF_OPEN_HASH_SLOT_NUM \
+  4  // Number of slots in a bucket of the open addressing hash, keys of all
+     // slots are compared at once
+#define SDF_OPEN_HASH_BUCKET_NUM \
+  0x40000  // Number of buckets of the open addressing hash, should be 2^n,
+           // SDF_OPEN_HASH_MASK = SDF_OPEN_HASH_BUCKET_NUM - 1
+#define SDF_OPEN_HASH_MASK \
+  0x3ffff  // Used for wrapping around the buckets when probing,
+           // SDF_OPEN_HASH_MASK = SDF_OPEN_HASH_BUCKET_NUM - 1
+
+#define SDF_OCTREE_DEPTH \
+  12  // Number of levels of the voxel block octree above the voxel blocks,
+      // its root spans 2^12 blocks along each axis, centred on the origin
+#define SDF_OCTREE_CACHED_LEVEL \
+  8  // Level of the nodes lookups remember to start the next one from,
+     // each spans 2^(SDF_OCTREE_DEPTH - 8) blocks along each axis
+
+// #define SDF_PACKED_BLOCK_KEYS  // Store the block positions of the voxel
+                                  // block hash in 64 bit keys, see
+                                  // ITMPackedBlockPos. Not supported by the
+                                  // Metal kernels
+#ifdef SDF_PACKED_BLOCK_KEYS
+#define SDF_BLOCK_POS_BITS \
+  21  // Number of bits per axis of the block positions of the voxel block
+      // hash
+#else
+#define SDF_BLOCK_POS_BITS 16
+#endif
 
 //////////////////////////////////////////////////////////////////////////
 // Voxel Hashing data structures
 //////////////////////////////////////////////////////////////////////////
 
+#ifdef SDF_PACKED_BLOCK_KEYS
+/** \brief
+    Block position packed into a single 64 bit key, with 21 bits per axis
+    instead of the 16 of a Vector3s. This extends the range of the map
+    to +-2^20 blocks per axis, while a hash entry stays 16 bytes. Lookups
+    compare the whole key instead of the coordinates, see isBlockKey().
+
+    The key holds x in its lowest bits, then y and z, each in two's
+    complement, and its highest bit is always zero.
+*/
+struct ITMPackedBlockPos {
+  unsigned long long key;
+
+  _CPU_AND_GPU_CODE_ ITMPackedBlockPos() {}
+  _CPU_AND_GPU_CODE_ ITMPackedBlockPos(int x, int y, int z) {
+    key = field(x) | (field(y) << SDF_BLOCK_POS_BITS) |
+          (field(z) << (2 * SDF_BLOCK_POS_BITS));
+  }
+
+  _CPU_AND_GPU_CODE_ inline int x() const { return coord(0); }
+  _CPU_AND_GPU_CODE_ inline int y() const { return coord(1); }
+  _CPU_AND_GPU_CODE_ inline int z() const { return coord(2); }
+
+  _CPU_AND_GPU_CODE_ inline Vector3i toInt() const {
+    return Vector3i(x(), y(), z());
+  }
+
+ private:
+  static const unsigned long long fieldMask =
+      (1ull << SDF_BLOCK_POS_BITS) - 1;
+  static const int signBit = 1 << (SDF_BLOCK_POS_BITS - 1);
+
+  _CPU_AND_GPU_CODE_ static inline unsigned long long field(int v) {
+    return (unsigned long long)(unsigned int)v & fieldMask;
+  }
+  _CPU_AND_GPU_CODE_ inline int coord(int axis) const {
+    int v = (int)((key >> (axis * SDF_BLOCK_POS_BITS)) & fieldMask);
+    return (v ^ signBit) - signBit;
+  }
+};
+
+/** Type of the block positions stored in the voxel block hash, and of
+    the block coordinates gathered for allocation. */
+typedef ITMPackedBlockPos ITMBlockPos;
+typedef Vector4i ITMBlockCoords;
+#else
+typedef Vector3s ITMBlockPos;
+typedef Vector4s ITMBlockCoords;
+#endif
+
 /** \brief
     A single entry in the hash table.
 */
 struct ITMHashEntry {
   /** Position of the corner of the 8x8x8 volume, that identifies the entry. */
-  Vector3s pos;
+  ITMBlockPos pos;
   /** Offset in the excess list. */
   int offset;
   /** Pointer to the voxel block array.
@@ -81,6 +177,35 @@ struct ITMHashEntry {
   int ptr;
 };
 
+/** \brief
+    A node of the voxel block octree. Its eight children are numbered
+    x + 2y + 4z by the octant they fill.
+*/
+struct ITMOctreeNode {
+  /** Position of the corner of the node in voxel blocks, the w component
+      is its level, 0 for the root. */
+  Vector4s pos;
+  /** Index of the node of each octant. Children of the last level,
+      SDF_OCTREE_DEPTH - 1, are pointers to the voxel block array
+      instead. -1 for empty octants. */
+  int child[8];
+};
+
+/** \brief
+    A bucket of the open addressing hash table. The keys of all slots
+    fill exactly 32 bytes, so that they are compared with a single SIMD
+    instruction. Slots are taken in order and never freed, so a key is
+    either found before the first free slot on its probe sequence or it
+    is not in the table.
+*/
+struct alignas(16) ITMOpenHashBucket {
+  /** Positions of the blocks in the slots. The w component is 1 for
+      taken slots and 0 for free ones. */
+  Vector4s pos[SDF_OPEN_HASH_SLOT_NUM];
+  /** Pointers to the voxel block array, only valid for taken slots. */
+  int ptr[SDF_OPEN_HASH_SLOT_NUM];
+};
+
 struct ITMHashSwapState {
   /// 0 - most recent data is on host, data not currently in active
   ///     memory
@@ -93,6 +218,88 @@ struct ITMHashSwapState {
 
 #include "../Objects/ITMPlainVoxelArray.h"
 #include "../Objects/ITMVoxelBlockHash.h"
+#include "../Objects/ITMVoxelBlockOpenHash.h"
+#include "../Objects/ITMVoxelBlockOctree.h"
+
+#if defined(__F16C__) && !defined(__CUDACC__) && !defined(__METALC__)
+#include <immintrin.h>
+#endif
+
+/** \brief
+    IEEE 754 half precision number. The bits are stored byte-wise, so
+    that voxel types using it need no padding. Converts to and from
+    float, rounding to the nearest even value.
+*/
+struct ITMHalf {
+  uchar bits[2];
+
+  _CPU_AND_GPU_CODE_ static uint floatAsUint(float f) {
+#if defined(__METALC__)
+    return as_type<uint>(f);
+#else
+    union { float f; uint u; } v;
+    v.f = f;
+    return v.u;
+#endif
+  }
+
+  _CPU_AND_GPU_CODE_ static float uintAsFloat(uint u) {
+#if defined(__METALC__)
+    return as_type<float>(u);
+#else
+    union { float f; uint u; } v;
+    v.u = u;
+    return v.f;
+#endif
+  }
+
+  _CPU_AND_GPU_CODE_ static ushort floatToHalfBits(float f) {
+#if defined(__F16C__) && !defined(__CUDACC__) && !defined(__METALC__)
+    return _cvtss_sh(f, 0);
+#else
+    uint u = floatAsUint(f);
+    uint sign = (u >> 16) & 0x8000u;
+    u &= 0x7fffffffu;
+
+    // overflow to infinity, NaN stays NaN
+    if (u >= 0x47800000u) return (ushort)(sign | (u > 0x7f800000u ? 0x7e00u : 0x7c00u));
+
+    // subnormal results: the float addition aligns and rounds the mantissa
+    if (u < 0x38800000u)
+      return (ushort)(sign | (floatAsUint(uintAsFloat(u) + 0.5f) - 0x3f000000u));
+
+    // normal results: rebias the exponent, round to nearest even
+    u += 0xc8000fffu + ((u >> 13) & 1u);
+    return (ushort)(sign | (u >> 13));
+#endif
+  }
+
+  _CPU_AND_GPU_CODE_ static float halfBitsToFloat(ushort h) {
+#if defined(__F16C__) && !defined(__CUDACC__) && !defined(__METALC__)
+    return _cvtsh_ss(h);
+#else
+    uint u = ((uint)h & 0x7fffu) << 13;
+    uint exponent = u & 0x0f800000u;
+    u += 0x38000000u;
+
+    if (exponent == 0x0f800000u) u += 0x38000000u;  // infinity, NaN
+    else if (exponent == 0) u = floatAsUint(uintAsFloat(u + 0x00800000u) - 6.103515625e-05f);  // zero, subnormal
+
+    return uintAsFloat(u | (((uint)h & 0x8000u) << 16));
+#endif
+  }
+
+  _CPU_AND_GPU_CODE_ ITMHalf() {}
+  _CPU_AND_GPU_CODE_ ITMHalf(float f) {
+    ushort h = floatToHalfBits(f);
+    bits[0] = (uchar)(h & 0xff);
+    bits[1] = (uchar)(h >> 8);
+  }
+
+  _CPU_AND_GPU_CODE_ operator float() const {
+    return halfBitsToFloat((ushort)(bits[0] | (bits[1] << 8)));
+  }
+};
 
 /** \brief
     Stores the information of a single voxel in the volume
@@ -101,6 +308,7 @@ struct ITMVoxel_f_rgb {
   _CPU_AND_GPU_CODE_ static float SDF_initialValue() { return 1.0f; }
   _CPU_AND_GPU_CODE_ static float SDF_valueToFloat(float x) { return x; }
   _CPU_AND_GPU_CODE_ static float SDF_floatToValue(float x) { return x; }
+  _CPU_AND_GPU_CODE_ static int W_maxValue() { return 255; }
 
   static const CONSTPTR(bool) hasColorInformation = true;
 
@@ -132,6 +340,7 @@ struct ITMVoxel_s_rgb {
   _CPU_AND_GPU_CODE_ static short SDF_floatToValue(float x) {
     return (short)((x)*32767.0f);
   }
+  _CPU_AND_GPU_CODE_ static int W_maxValue() { return 255; }
 
   static const CONSTPTR(bool) hasColorInformation = true;
 
@@ -162,6 +371,7 @@ struct ITMVoxel_s {
   _CPU_AND_GPU_CODE_ static short SDF_floatToValue(float x) {
     return (short)((x)*32767.0f);
   }
+  _CPU_AND_GPU_CODE_ static int W_maxValue() { return 255; }
 
   static const CONSTPTR(bool) hasColorInformation = false;
 
@@ -182,6 +392,7 @@ struct ITMVoxel_f {
   _CPU_AND_GPU_CODE_ static float SDF_initialValue() { return 1.0f; }
   _CPU_AND_GPU_CODE_ static float SDF_valueToFloat(float x) { return x; }
   _CPU_AND_GPU_CODE_ static float SDF_floatToValue(float x) { return x; }
+  _CPU_AND_GPU_CODE_ static int W_maxValue() { return 255; }
 
   static const CONSTPTR(bool) hasColorInformation = false;
 
@@ -198,18 +409,109 @@ struct ITMVoxel_f {
   }
 };
 
-/** This chooses the information stored at each voxel. At the moment, valid
-    options are ITMVoxel_s, ITMVoxel_f, ITMVoxel_s_rgb and ITMVoxel_f_rgb
+/** \brief
+    Stores the SDF as a half precision number: 3 bytes per voxel instead
+    of the 8 of ITMVoxel_f.
+*/
+struct ITMVoxel_h {
+  _CPU_AND_GPU_CODE_ static ITMHalf SDF_initialValue() { return ITMHalf(1.0f); }
+  _CPU_AND_GPU_CODE_ static float SDF_valueToFloat(float x) { return x; }
+  _CPU_AND_GPU_CODE_ static ITMHalf SDF_floatToValue(float x) { return ITMHalf(x); }
+  _CPU_AND_GPU_CODE_ static int W_maxValue() { return 255; }
+
+  static const CONSTPTR(bool) hasColorInformation = false;
+
+  /** Value of the truncated signed distance transformation. */
+  ITMHalf sdf;
+  /** Number of fused observations that make up @p sdf. */
+  uchar w_depth;
+
+  _CPU_AND_GPU_CODE_ ITMVoxel_h() {
+    sdf = SDF_initialValue();
+    w_depth = 0;
+  }
+};
+
+/** \brief
+    Stores the SDF, which is normalised to the truncation band mu, in 12
+    bits and the depth weight in the other 4 bits of a 16 bit word: 2
+    bytes per voxel instead of the 4 of ITMVoxel_s. The weight saturates
+    at W_maxValue(), below the usual ITMSceneParams::maxW, so the SDF
+    follows the last 15 observations rather than averaging all of them.
+    Unlike the other fixed point types the SDF is rounded to the nearest
+    step, as truncation would bias the running average towards zero at
+    this resolution. Both are bit fields, which are only ever accessed
+    by name, so their layout within the word does not matter.
+*/
+struct ITMVoxel_b {
+  _CPU_AND_GPU_CODE_ static short SDF_initialValue() { return 2047; }
+  _CPU_AND_GPU_CODE_ static float SDF_valueToFloat(float x) {
+    return (float)(x) / 2047.0f;
+  }
+  _CPU_AND_GPU_CODE_ static short SDF_floatToValue(float x) {
+    return (short)((x)*2047.0f + ((x) < 0 ? -0.5f : 0.5f));
+  }
+  _CPU_AND_GPU_CODE_ static int W_maxValue() { return 15; }
+
+  static const CONSTPTR(bool) hasColorInformation = false;
+
+  /** Value of the truncated signed distance transformation. */
+  signed short sdf : 12;
+  /** Number of fused observations that make up @p sdf. */
+  unsigned short w_depth : 4;
+
+  _CPU_AND_GPU_CODE_ ITMVoxel_b() {
+    sdf = SDF_initialValue();
+    w_depth = 0;
+  }
+};
+
+/** This chooses the default information stored at each voxel, which
+    ITMLibSettings::voxelType can override at runtime. At the moment, valid
+    options are ITMVoxel_s, ITMVoxel_f, ITMVoxel_h, ITMVoxel_b,
+    ITMVoxel_s_rgb and ITMVoxel_f_rgb. The Metal kernels only support this
+    type.
 */
 // typedef ITMVoxel_f_rgb ITMVoxel;
 typedef ITMVoxel_s ITMVoxel;
 
-/** This chooses the way the voxels are addressed and indexed. At the moment,
-    valid options are ITMVoxelBlockHash and ITMPlainVoxelArray.
+/** This chooses the default way the voxels are addressed and indexed, which
+    ITMLibSettings::indexType can override at runtime. At the moment,
+    valid options are ITMVoxelBlockHash, ITMVoxelBlockOpenHash,
+    ITMVoxelBlockOctree and ITMPlainVoxelArray.
 */
 typedef ITMLib::Objects::ITMVoxelBlockHash ITMVoxelIndex;
 // typedef ITMLib::Objects::ITMPlainVoxelArray ITMVoxelIndex;
 
+/** Explicitly instantiates a class template for every combination of voxel
+    type and index that can be selected at runtime.
+*/
+#define ITM_INSTANTIATE_FOR_ALL_SCENE_TYPES(Class)                           \
+  template class Class<ITMVoxel_s, ITMLib::Objects::ITMVoxelBlockHash>;      \
+  template class Class<ITMVoxel_f, ITMLib::Objects::ITMVoxelBlockHash>;      \
+  template class Class<ITMVoxel_h, ITMLib::Objects::ITMVoxelBlockHash>;      \
+  template class Class<ITMVoxel_b, ITMLib::Objects::ITMVoxelBlockHash>;      \
+  template class Class<ITMVoxel_s_rgb, ITMLib::Objects::ITMVoxelBlockHash>;  \
+  template class Class<ITMVoxel_f_rgb, ITMLib::Objects::ITMVoxelBlockHash>;  \
+  template class Class<ITMVoxel_s, ITMLib::Objects::ITMVoxelBlockOpenHash>;   \
+  template class Class<ITMVoxel_f, ITMLib::Objects::ITMVoxelBlockOpenHash>;   \
+  template class Class<ITMVoxel_h, ITMLib::Objects::ITMVoxelBlockOpenHash>;   \
+  template class Class<ITMVoxel_b, ITMLib::Objects::ITMVoxelBlockOpenHash>;   \
+  template class Class<ITMVoxel_s_rgb, ITMLib::Objects::ITMVoxelBlockOpenHash>; \
+  template class Class<ITMVoxel_f_rgb, ITMLib::Objects::ITMVoxelBlockOpenHash>; \
+  template class Class<ITMVoxel_s, ITMLib::Objects::ITMVoxelBlockOctree>;    \
+  template class Class<ITMVoxel_f, ITMLib::Objects::ITMVoxelBlockOctree>;    \
+  template class Class<ITMVoxel_h, ITMLib::Objects::ITMVoxelBlockOctree>;    \
+  template class Class<ITMVoxel_b, ITMLib::Objects::ITMVoxelBlockOctree>;    \
+  template class Class<ITMVoxel_s_rgb, ITMLib::Objects::ITMVoxelBlockOctree>; \
+  template class Class<ITMVoxel_f_rgb, ITMLib::Objects::ITMVoxelBlockOctree>; \
+  template class Class<ITMVoxel_s, ITMLib::Objects::ITMPlainVoxelArray>;     \
+  template class Class<ITMVoxel_f, ITMLib::Objects::ITMPlainVoxelArray>;     \
+  template class Class<ITMVoxel_h, ITMLib::Objects::ITMPlainVoxelArray>;     \
+  template class Class<ITMVoxel_b, ITMLib::Objects::ITMPlainVoxelArray>;     \
+  template class Class<ITMVoxel_s_rgb, ITMLib::Objects::ITMPlainVoxelArray>; \
+  template class Class<ITMVoxel_f_rgb, ITMLib::Objects::ITMPlainVoxelArray>;
+
 #include "../../ORUtils/Image.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -8,6 +8,39 @@ using namespace ITMLib::Objects;
 
 ITMLibSettings::ITMLibSettings(void)
     : sceneParams(0.02f, 100, 0.005f, 0.35f, 3.0f, false) {
+  /// capacities of the voxel block hash and of one swap operation
+  sceneParams.noLocalBlocks = SDF_LOCAL_BLOCK_NUM;
+  sceneParams.noExcessEntries = SDF_EXCESS_LIST_SIZE;
+  sceneParams.noTransferBlocks = SDF_TRANSFER_BLOCK_NUM;
+
+  /// CPU engines: parallel block allocation, SIMD integration of voxel rows
+  /// and voxel blocks stored as structures of arrays
+  sceneParams.useParallelAllocation = false;
+  sceneParams.useVectorisedIntegration = false;
+  sceneParams.useSoAVoxelBlocks = false;
+
+  /// garbage collection of empty blocks every N frames, 0 for none, and the
+  /// number of entries looked at each time
+  sceneParams.garbageCollectionInterval = 0;
+  sceneParams.garbageCollectionBudget = 4096;
+
+  /// grow the hash once this fraction of it is in use, 0 for fixed capacities
+  sceneParams.growthThreshold = 0.0f;
+
+  /// defragment the voxel block array every N frames, 0 for none
+  sceneParams.defragmentationInterval = 0;
+
+  /// move the scene origin once the camera is this far from it, 0 for never,
+  /// and the number of hash entries moved per frame
+  sceneParams.recenteringDistance = 0.0f;
+  sceneParams.recenteringBudget = 16384;
+
+  /// storage of the blocks swapped out: mapped from a file, encoded, and the
+  /// MB kept in memory before the rest goes to disk, 0 for no limit
+  sceneParams.useMappedGlobalCache = false;
+  sceneParams.useCompressedGlobalCache = false;
+  sceneParams.globalCacheMemoryLimit = 0;
+
   /// depth threashold for the ICP tracker
   depthTrackerICPThreshold = 0.1f * 0.1f;
 
@@ -30,6 +63,10 @@ ITMLibSettings::ITMLibSettings(void)
   // currently using only CPU for External tracker
   // deviceType = DEVICE_CPU;
 
+  /// voxel type and index, the compile time defaults of ITMLibDefines.h
+  voxelType = ITMVoxelTypeOf<ITMVoxel>::value;
+  indexType = ITMIndexTypeOf<ITMVoxelIndex>::value;
+
   /// enables or disables swapping. HERE BE DRAGONS: It should work, but
   /// requires more testing
   useSwapping = false;
@@ -78,10 +115,6 @@ ITMLibSettings::ITMLibSettings(void)
     noICPRunTillLevel = 0;
   }
 
-  if ((trackerType == TRACKER_COLOR) && (!ITMVoxel::hasColorInformation)) {
-    printf(
-        "Error: Color tracker requires a voxel type with color information!\n");
-  }
   if (trackerType == TRACKER_EXTERNAL) {
     std::cout << "TRACKER_EXTERNAL" << std::endl;
   }
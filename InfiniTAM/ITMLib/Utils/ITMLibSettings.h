@@ -62,6 +62,39 @@ class ITMLibSettings {
   /// For ITMDepthTracker: ICP iteration termination threshold
   float depthTrackerTerminationThreshold;
 
+  /// Voxel types, see ITMLibDefines.h
+  typedef enum {
+    VOXEL_S,
+    VOXEL_F,
+    VOXEL_H,
+    VOXEL_B,
+    VOXEL_S_RGB,
+    VOXEL_F_RGB
+  } VoxelType;
+
+  /// Select the information stored at each voxel. Defaults to ITMVoxel.
+  VoxelType voxelType;
+
+  /// Index types, see ITMLibDefines.h
+  typedef enum {
+    //! ITMVoxelBlockHash
+    INDEX_HASH,
+    //! ITMPlainVoxelArray
+    INDEX_PLAIN,
+    //! ITMVoxelBlockOpenHash, CPU only, without swapping
+    INDEX_OPEN_HASH,
+    //! ITMVoxelBlockOctree, CPU only, without swapping
+    INDEX_OCTREE
+  } IndexType;
+
+  /// Select the way the voxels are indexed. Defaults to ITMVoxelIndex.
+  IndexType indexType;
+
+  /// Whether the selected voxel type stores colour information
+  bool VoxelTypeHasColorInformation(void) const {
+    return voxelType == VOXEL_S_RGB || voxelType == VOXEL_F_RGB;
+  }
+
   /// Further, scene specific parameters such as voxel size
   ITMLib::Objects::ITMSceneParams sceneParams;
 
@@ -72,5 +105,54 @@ class ITMLibSettings {
   ITMLibSettings(const ITMLibSettings&);
   ITMLibSettings& operator=(const ITMLibSettings&);
 };
+
+/// Maps the voxel types of ITMLibDefines.h to ITMLibSettings::VoxelType
+template <class TVoxel>
+struct ITMVoxelTypeOf;
+template <>
+struct ITMVoxelTypeOf<ITMVoxel_s> {
+  static const ITMLibSettings::VoxelType value = ITMLibSettings::VOXEL_S;
+};
+template <>
+struct ITMVoxelTypeOf<ITMVoxel_f> {
+  static const ITMLibSettings::VoxelType value = ITMLibSettings::VOXEL_F;
+};
+template <>
+struct ITMVoxelTypeOf<ITMVoxel_h> {
+  static const ITMLibSettings::VoxelType value = ITMLibSettings::VOXEL_H;
+};
+template <>
+struct ITMVoxelTypeOf<ITMVoxel_b> {
+  static const ITMLibSettings::VoxelType value = ITMLibSettings::VOXEL_B;
+};
+template <>
+struct ITMVoxelTypeOf<ITMVoxel_s_rgb> {
+  static const ITMLibSettings::VoxelType value = ITMLibSettings::VOXEL_S_RGB;
+};
+template <>
+struct ITMVoxelTypeOf<ITMVoxel_f_rgb> {
+  static const ITMLibSettings::VoxelType value = ITMLibSettings::VOXEL_F_RGB;
+};
+
+/// Maps the index types of ITMLibDefines.h to ITMLibSettings::IndexType
+template <class TIndex>
+struct ITMIndexTypeOf;
+template <>
+struct ITMIndexTypeOf<ITMVoxelBlockHash> {
+  static const ITMLibSettings::IndexType value = ITMLibSettings::INDEX_HASH;
+};
+template <>
+struct ITMIndexTypeOf<ITMVoxelBlockOpenHash> {
+  static const ITMLibSettings::IndexType value =
+      ITMLibSettings::INDEX_OPEN_HASH;
+};
+template <>
+struct ITMIndexTypeOf<ITMVoxelBlockOctree> {
+  static const ITMLibSettings::IndexType value = ITMLibSettings::INDEX_OCTREE;
+};
+template <>
+struct ITMIndexTypeOf<ITMPlainVoxelArray> {
+  static const ITMLibSettings::IndexType value = ITMLibSettings::INDEX_PLAIN;
+};
 }
 }
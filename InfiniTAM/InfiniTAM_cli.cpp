@@ -1,6 +1,7 @@
 // Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
 
 #include <cstdlib>
+#include <cstring>
 
 #include "Engine/CLIEngine.h"
 #include "Engine/ImageSourceEngine.h"
@@ -15,8 +16,16 @@ int main(int argc, char** argv) {
     const char* imagesource_part1 = NULL;
     const char* imagesource_part2 = NULL;
     const char* imagesource_part3 = NULL;
+    int statisticsInterval = 0;
 
     int arg = 1;
+    if (argv[arg] != NULL && strcmp(argv[arg], "--stats") == 0 &&
+        argv[arg + 1] != NULL) {
+      statisticsInterval = atoi(argv[arg + 1]);
+      arg += 2;
+    }
+    const int firstArg = arg;
+
     do {
       if (argv[arg] != NULL)
         calibFile = argv[arg];
@@ -39,9 +48,11 @@ int main(int argc, char** argv) {
         break;
     } while (false);
 
-    if (arg == 1) {
+    if (arg == firstArg) {
       printf(
-          "usage: %s [<calibfile> [<imagesource>] ]\n"
+          "usage: %s [--stats <n>] [<calibfile> [<imagesource>] ]\n"
+          "  --stats <n>   : print the load of the voxel block hash every n "
+          "frames\n"
           "  <calibfile>   : path to a file containing intrinsic calibration "
           "parameters\n"
           "  <imagesource> : either one argument to specify OpenNI device ID\n"
@@ -95,6 +106,7 @@ int main(int argc, char** argv) {
 
     CLIEngine::Instance()->Initialise(imageSource, imuSource, mainEngine,
                                       internalSettings->deviceType);
+    CLIEngine::Instance()->statisticsInterval = statisticsInterval;
     CLIEngine::Instance()->Run();
     CLIEngine::Instance()->Shutdown();
 
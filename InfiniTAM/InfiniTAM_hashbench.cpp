@@ -0,0 +1,301 @@
+// Copyright 2014-2015 Isis Innovation Limited and the authors of InfiniTAM
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Engine/ImageSourceEngine.h"
+#include "ITMLib/Engine/DeviceAgnostic/ITMRepresentationAccess.h"
+#include "ITMLib/Engine/ITMMainEngine.h"
+
+using namespace InfiniTAM::Engine;
+
+static const int maxChainLength = 8;
+
+/** Reconstructs the image sequence with the CPU engines and appends the
+    positions of the blocks in the hash table, in order of allocation. */
+static bool reconstructBlocks(const char* calibFile, const char* rgbImageMask,
+                              const char* depthImageMask,
+                              std::vector<Vector3i>& blocks) {
+  ImageSourceEngine* imageSource =
+      new ImageFileReader(calibFile, rgbImageMask, depthImageMask);
+  if (imageSource->getDepthImageSize().x == 0) {
+    printf("Error: Could not read the images!\n");
+    delete imageSource;
+    return false;
+  }
+
+  // swapping keeps the blocks that are out of view in the hash table
+  ITMLibSettings* settings = new ITMLibSettings();
+  settings->deviceType = ITMLibSettings::DEVICE_CPU;
+  settings->voxelType = ITMVoxelTypeOf<ITMVoxel>::value;
+  settings->indexType = ITMLibSettings::INDEX_HASH;
+  settings->useSwapping = true;
+
+  ITMMainEngine* mainEngine = new ITMMainEngine(
+      settings, &imageSource->calib, imageSource->getRGBImageSize(),
+      imageSource->getDepthImageSize());
+
+  ITMUChar4Image* rgbImage =
+      new ITMUChar4Image(imageSource->getRGBImageSize(), true, false);
+  ITMShortImage* rawDepthImage =
+      new ITMShortImage(imageSource->getDepthImageSize(), true, false);
+
+  int frameNo = 0;
+  while (imageSource->hasMoreImages()) {
+    imageSource->getImages(rgbImage, rawDepthImage);
+    mainEngine->ProcessFrame(rgbImage, rawDepthImage);
+    printf("\rreconstructing frame %i", frameNo++);
+    fflush(stdout);
+  }
+  printf("\n");
+
+  const ITMScene<ITMVoxel, ITMVoxelBlockHash>* scene =
+      mainEngine->GetScene<ITMVoxel, ITMVoxelBlockHash>();
+  const ITMHashEntry* hashTable = scene->index.GetEntries();
+  const int* allocatedEntryIDs = scene->index.GetAllocatedEntryIDs();
+  for (int listIdx = 0; listIdx < scene->index.GetNoAllocatedEntries();
+       listIdx++) {
+    blocks.push_back(hashTable[allocatedEntryIDs[listIdx]].pos.toInt());
+  }
+
+  delete rgbImage;
+  delete rawDepthImage;
+  delete mainEngine;
+  delete settings;
+  delete imageSource;
+  return true;
+}
+
+/** Reads block positions, one "x y z" triple per line. */
+static bool readBlocks(const char* fileName, std::vector<Vector3i>& blocks) {
+  FILE* f = fopen(fileName, "r");
+  if (f == NULL) {
+    printf("Error: Could not open %s!\n", fileName);
+    return false;
+  }
+
+  int x, y, z;
+  while (fscanf(f, "%i %i %i", &x, &y, &z) == 3) {
+    blocks.push_back(Vector3i(x, y, z));
+  }
+
+  fclose(f);
+  return true;
+}
+
+static bool writeBlocks(const char* fileName,
+                        const std::vector<Vector3i>& blocks) {
+  FILE* f = fopen(fileName, "w");
+  if (f == NULL) {
+    printf("Error: Could not open %s!\n", fileName);
+    return false;
+  }
+
+  for (size_t i = 0; i < blocks.size(); i++) {
+    fprintf(f, "%i %i %i\n", blocks[i].x, blocks[i].y, blocks[i].z);
+  }
+
+  fclose(f);
+  return true;
+}
+
+/** Appends the blocks on the walls of a box of @p size blocks, as seen
+    along a trajectory through its middle along x. A long thin box
+    models a corridor. */
+static void makeBoxBlocks(const Vector3i& size,
+                          std::vector<Vector3i>& blocks) {
+  Vector3i origin = -size / 2;
+  for (int x = 0; x < size.x; x++)
+    for (int y = 0; y < size.y; y++)
+      for (int z = 0; z < size.z; z++) {
+        bool onWall = x == 0 || x == size.x - 1 || y == 0 ||
+                      y == size.y - 1 || z == 0 || z == size.z - 1;
+        if (onWall) {
+          blocks.push_back(
+              Vector3i(origin.x + x, origin.y + y, origin.z + z));
+        }
+      }
+}
+
+/** Returns the entry of @p blockPos in the same way as findVoxel(), or
+    -1 if the block is not in the table. */
+template <class THashFunction>
+static inline int findEntry(const ITMHashEntry* hashTable,
+                            const Vector3i& blockPos) {
+  int hashIdx = hashIndex<THashFunction>(blockPos);
+  ITMBlockKey key = blockKey(blockPos);
+  while (true) {
+    const ITMHashEntry& hashEntry = hashTable[hashIdx];
+    if (isBlockKey(hashEntry.pos, key) && hashEntry.ptr >= 0) {
+      return hashIdx;
+    }
+    if (hashEntry.offset < 1) return -1;
+    hashIdx = SDF_BUCKET_NUM + hashEntry.offset - 1;
+  }
+}
+
+/** Inserts the blocks into a voxel block hash laid out as
+    ITMVoxelBlockHash with an unbounded excess list, prints the
+    distribution of the chain lengths and times lookups of the blocks
+    and of their neighbours along x, which are mostly misses. */
+template <class THashFunction>
+static void benchmarkHashFunction(const char* name,
+                                  const std::vector<Vector3i>& blocks,
+                                  int noRounds) {
+  ITMHashEntry emptyEntry;
+  memset(&emptyEntry, 0, sizeof(ITMHashEntry));
+  emptyEntry.ptr = -2;
+  std::vector<ITMHashEntry> hashTable(SDF_BUCKET_NUM + blocks.size(),
+                                      emptyEntry);
+  std::vector<int> chainLengths(SDF_BUCKET_NUM, 0);
+
+  int noBlocks = 0, noExcessEntries = 0;
+  long long noProbes = 0;
+  for (size_t i = 0; i < blocks.size(); i++) {
+    const Vector3i& blockPos = blocks[i];
+    if (findEntry<THashFunction>(&hashTable[0], blockPos) >= 0) continue;
+
+    ITMHashEntry hashEntry;
+    hashEntry.pos = ITMBlockPos(blockPos.x, blockPos.y, blockPos.z);
+    hashEntry.offset = 0;
+    hashEntry.ptr = noBlocks++;
+
+    int hashIdx = hashIndex<THashFunction>(blockPos);
+    int chainLength = ++chainLengths[hashIdx];
+    noProbes += chainLength;
+
+    if (hashTable[hashIdx].ptr < -1) {
+      hashTable[hashIdx] = hashEntry;
+      continue;
+    }
+
+    while (hashTable[hashIdx].offset >= 1) {
+      hashIdx = SDF_BUCKET_NUM + hashTable[hashIdx].offset - 1;
+    }
+    hashTable[hashIdx].offset = ++noExcessEntries;
+    hashTable[SDF_BUCKET_NUM + noExcessEntries - 1] = hashEntry;
+  }
+
+  int histogram[maxChainLength + 1] = {0};
+  int noOccupiedBuckets = 0, longestChain = 0;
+  for (int bucketId = 0; bucketId < SDF_BUCKET_NUM; bucketId++) {
+    int chainLength = chainLengths[bucketId];
+    if (chainLength == 0) continue;
+    noOccupiedBuckets++;
+    histogram[MIN(chainLength, maxChainLength)]++;
+    longestChain = MAX(longestChain, chainLength);
+  }
+
+  // lookups are timed in the order the blocks were allocated in
+  long long noFound = 0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (int round = 0; round < noRounds; round++)
+    for (size_t i = 0; i < blocks.size(); i++) {
+      noFound += findEntry<THashFunction>(&hashTable[0], blocks[i]) >= 0;
+    }
+  std::chrono::steady_clock::time_point middle =
+      std::chrono::steady_clock::now();
+  for (int round = 0; round < noRounds; round++)
+    for (size_t i = 0; i < blocks.size(); i++) {
+      Vector3i blockPos = blocks[i];
+      blockPos.x += 1;
+      noFound += findEntry<THashFunction>(&hashTable[0], blockPos) >= 0;
+    }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  double noLookups = (double)noRounds * (double)blocks.size();
+  double timeHits =
+      std::chrono::duration<double, std::micro>(middle - start).count();
+  double timeNeighbours =
+      std::chrono::duration<double, std::micro>(end - middle).count();
+
+  printf("%-14s buckets %8i, excess %7i (%5.2f%%), chain max %3i avg %.3f, "
+         "probes/hit %.3f, lookups %7.1f M/s, neighbours %7.1f M/s (%lli)\n",
+         name, noOccupiedBuckets, noExcessEntries,
+         noBlocks > 0 ? 100.0 * noExcessEntries / noBlocks : 0.0,
+         longestChain,
+         noOccupiedBuckets > 0 ? (double)noBlocks / noOccupiedBuckets : 0.0,
+         noBlocks > 0 ? (double)noProbes / noBlocks : 0.0,
+         timeHits > 0 ? noLookups / timeHits : 0.0,
+         timeNeighbours > 0 ? noLookups / timeNeighbours : 0.0, noFound);
+
+  printf("%-14s chain lengths:", "");
+  for (int chainLength = 1; chainLength <= maxChainLength; chainLength++) {
+    printf(" %i%s: %i", chainLength,
+           chainLength == maxChainLength ? "+" : "", histogram[chainLength]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  const char* blockFile = NULL;
+  const char* saveFile = NULL;
+  const char* imageSource[3] = {NULL, NULL, NULL};
+  Vector3i boxSize(0, 0, 0);
+  int noRounds = 10;
+
+  int noImageSourceArgs = 0;
+  for (int arg = 1; arg < argc; arg++) {
+    if (strcmp(argv[arg], "--blocks") == 0 && arg + 1 < argc) {
+      blockFile = argv[++arg];
+    } else if (strcmp(argv[arg], "--save") == 0 && arg + 1 < argc) {
+      saveFile = argv[++arg];
+    } else if (strcmp(argv[arg], "--box") == 0 && arg + 3 < argc) {
+      boxSize.x = atoi(argv[++arg]);
+      boxSize.y = atoi(argv[++arg]);
+      boxSize.z = atoi(argv[++arg]);
+    } else if (strcmp(argv[arg], "--rounds") == 0 && arg + 1 < argc) {
+      noRounds = atoi(argv[++arg]);
+    } else if (noImageSourceArgs < 3) {
+      imageSource[noImageSourceArgs++] = argv[arg];
+    }
+  }
+
+  if (blockFile == NULL && boxSize.x <= 0 && noImageSourceArgs != 3) {
+    printf(
+        "usage: %s [options] [<calibfile> <rgbimages> <depthimages>]\n"
+        "  <calibfile>      : path to a file containing intrinsic "
+        "calibration parameters\n"
+        "  <rgbimages>      : rgb file mask\n"
+        "  <depthimages>    : depth file mask\n"
+        "  --blocks <file>  : read block positions, one \"x y z\" per line\n"
+        "  --box <x> <y> <z>: add the walls of a box of that many blocks, "
+        "e.g. 1000 8 8 for a corridor\n"
+        "  --save <file>    : write the block positions that were used\n"
+        "  --rounds <n>     : number of times every block is looked up\n"
+        "\n"
+        "Compares the hash functions of ITMRepresentationAccess.h on the "
+        "blocks of a scene.\n",
+        argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Vector3i> blocks;
+  if (noImageSourceArgs == 3 &&
+      !reconstructBlocks(imageSource[0], imageSource[1], imageSource[2],
+                         blocks)) {
+    return EXIT_FAILURE;
+  }
+  if (blockFile != NULL && !readBlocks(blockFile, blocks)) {
+    return EXIT_FAILURE;
+  }
+  if (boxSize.x > 0) makeBoxBlocks(boxSize, blocks);
+
+  if (saveFile != NULL && !writeBlocks(saveFile, blocks)) {
+    return EXIT_FAILURE;
+  }
+
+  printf("%i blocks, %i buckets\n", (int)blocks.size(), SDF_BUCKET_NUM);
+
+  benchmarkHashFunction<ITMTeschnerHash>("teschner", blocks, noRounds);
+  benchmarkHashFunction<ITMMortonHash>("morton", blocks, noRounds);
+  benchmarkHashFunction<ITMMultiplyShiftHash>("multiply-shift", blocks,
+                                              noRounds);
+  benchmarkHashFunction<ITMMurmurHash>("murmur", blocks, noRounds);
+
+  return 0;
+}
@@ -94,6 +94,8 @@ namespace ORUtils
 			this->isAllocated_CPU = false;
 			this->isAllocated_CUDA = false;
 			this->isMetalCompatible = false;
+			this->data_cpu = NULL;
+			this->data_cuda = NULL;
 
 			Allocate(dataSize, allocate_CPU, allocate_CUDA, metalCompatible);
 			Clear();
@@ -108,6 +110,8 @@ namespace ORUtils
 			this->isAllocated_CPU = false;
 			this->isAllocated_CUDA = false;
 			this->isMetalCompatible = false;
+			this->data_cpu = NULL;
+			this->data_cuda = NULL;
 
 			switch (memoryType)
 			{
@@ -165,6 +169,34 @@ namespace ORUtils
 			}
 		}
 
+		/** Resize the memory block to @p newDataSize elements,
+		keeping the first min(dataSize, newDataSize) elements on
+		every device the block is allocated on. Any new elements
+		are set to zero.
+		*/
+		void Resize(size_t newDataSize)
+		{
+			if (newDataSize == dataSize) return;
+
+			MemoryBlock<T> resized(newDataSize, isAllocated_CPU, isAllocated_CUDA, isMetalCompatible);
+			size_t noCopied = newDataSize < dataSize ? newDataSize : dataSize;
+
+			if (isAllocated_CPU && noCopied > 0) memcpy(resized.data_cpu, data_cpu, noCopied * sizeof(T));
+#ifndef COMPILE_WITHOUT_CUDA
+			if (isAllocated_CUDA && noCopied > 0)
+				ORcudaSafeCall(cudaMemcpy(resized.data_cuda, data_cuda, noCopied * sizeof(T), cudaMemcpyDeviceToDevice));
+#endif
+
+			// the old data is released with resized
+			DEVICEPTR(T) *tmpData = data_cpu; data_cpu = resized.data_cpu; resized.data_cpu = tmpData;
+			tmpData = data_cuda; data_cuda = resized.data_cuda; resized.data_cuda = tmpData;
+#ifdef COMPILE_WITH_METAL
+			void *tmpBuffer = data_metalBuffer; data_metalBuffer = resized.data_metalBuffer; resized.data_metalBuffer = tmpBuffer;
+#endif
+			resized.dataSize = dataSize;
+			dataSize = newDataSize;
+		}
+
 		virtual ~MemoryBlock() { this->Free(); }
 
 		/** Allocate image data of the specified size. If the
@@ -253,8 +253,7 @@ bool InfinitamNode::publishMap(std_srvs::Empty::Request& request,
                                std_srvs::Empty::Response& response) {
   ROS_INFO_STREAM("Service for publishing the map has started.");
   // Make the mesh ready for reading.
-  main_engine_->GetMeshingEngine()->MeshScene(main_engine_->GetMesh(),
-                                              main_engine_->GetScene());
+  main_engine_->UpdateMesh();
 
   // Get triangles from the device's memory.
   ORUtils::MemoryBlock<ITMMesh::Triangle>* cpu_triangles;
@@ -475,6 +474,15 @@ void InfinitamNode::readParameters() {
                             0.35f);
   node_handle_.param<float>(
       "viewFrustum_max", internal_settings_->sceneParams.viewFrustum_max, 3.0f);
+  node_handle_.param<int>("noLocalBlocks",
+                          internal_settings_->sceneParams.noLocalBlocks,
+                          SDF_LOCAL_BLOCK_NUM);
+  node_handle_.param<int>("noExcessEntries",
+                          internal_settings_->sceneParams.noExcessEntries,
+                          SDF_EXCESS_LIST_SIZE);
+  node_handle_.param<int>("noTransferBlocks",
+                          internal_settings_->sceneParams.noTransferBlocks,
+                          SDF_TRANSFER_BLOCK_NUM);
 
   int tracker;
   node_handle_.param<int>("trackerType", tracker, 1);